@@ -184,6 +184,7 @@ int main_dx() {
 
     auto scene = make_unique<core::Scene>();
     LoadScene_dx4(scene.get());
+    scene->GetStaticModelGroup().OptimizeMeshes();
     scene->GetStaticModelGroup().BuildBvh();
 
     d3d12RenderSystem::RenderSystem renderSystem;
@@ -232,6 +233,7 @@ int main_dx() {
             renderWindow.SetCaption(L"FPS: " + std::to_wstring(fps));
         }
         // update
+        scene->GetStaticModelGroup().GetBvh()->Refit();
         cameraController.Step();
         renderSystem.Update();
         // draw
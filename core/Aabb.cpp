@@ -1,5 +1,7 @@
 #include "Aabb.h"
+#include "SlabTest.h"
 
+#include <algorithm>
 #include <limits>
 
 using std::numeric_limits;
@@ -46,37 +48,35 @@ auto Aabb::Intersect(Aabb const & other) -> void {
 auto Aabb::GetCenter() const -> Point4f {
     return (_minVertex + _maxVertex) * 0.5;
 }
-// ray-AABB intersection algorithm, see "Real-time rendering" Ch16.7.
-auto Aabb::IntersectRay(Ray ray) const -> Float32 {
-    auto tMin = std::numeric_limits<Float32>::lowest();
-    auto tMax = std::numeric_limits<Float32>::max();
-    auto axes = std::array<Vector4f, 3>{ Vector4f{ 1, 0, 0, 0 }, Vector4f{ 0, 1, 0, 0 }, Vector4f{ 0, 0, 1, 0 }};
-    for (auto axisIndex = 0; axisIndex < 3; ++axisIndex) {
-        auto cosine = DotProduct(ray.direction, axes[axisIndex]);
-        if (abs(cosine) > std::numeric_limits<Float32>::epsilon()) {
-            auto t1 = (_minVertex(axisIndex) - ray.origin(axisIndex)) / cosine;
-            auto t2 = (_maxVertex(axisIndex) - ray.origin(axisIndex)) / cosine;
-            if (t1 > t2) {
-                std::swap(t1, t2);
-            }
-            if (t1 > tMin) {
-                tMin = t1;
-            }
-            if (t2 < tMax) {
-                tMax = t2;
-            }
-            if (tMax < 0 || tMin > tMax) {
-                return -1;
-            }
-        } else if (_minVertex(axisIndex) - ray.origin(axisIndex) > 0 || _maxVertex(axisIndex) - ray.origin(axisIndex) < 0) {
-            // ray is parallel with axis and reside outside of 2 bounding plane
-            return -1;
-        }
-        if (tMin >= ray.length) { // intersection point is farther than ray length
-            return -1;
+
+auto Aabb::GetSurfaceArea() const -> Float32 {
+    auto x = _maxVertex(0) - _minVertex(0);
+    auto y = _maxVertex(1) - _minVertex(1);
+    auto z = _maxVertex(2) - _minVertex(2);
+    if (x < 0 || y < 0 || z < 0) { // empty AABB
+        return 0.0f;
+    }
+    return 2 * (x * y + y * z + z * x);
+}
+
+// transform center and extent rather than 8 vertexes, see Arvo, "Transforming Axis-Aligned Bounding Boxes".
+auto Aabb::Transform(Matrix4x4f const& matrix) const -> Aabb {
+    auto ret = Aabb{};
+    for (auto i = 0u; i < 3; ++i) {
+        ret._minVertex(i) = ret._maxVertex(i) = matrix(i, 3);
+        for (auto j = 0u; j < 3; ++j) {
+            auto a = matrix(i, j) * _minVertex(j);
+            auto b = matrix(i, j) * _maxVertex(j);
+            ret._minVertex(i) += std::min(a, b);
+            ret._maxVertex(i) += std::max(a, b);
         }
     }
-    return tMin > 0 ? tMin : tMax;
+    return ret;
+}
+
+// ray-AABB intersection algorithm, see "Real-time rendering" Ch16.7.
+auto Aabb::IntersectRay(Ray ray) const -> Float32 {
+    return IntersectSlab(SlabRay{ ray }, _minVertex.data(), _maxVertex.data());
 }
 
 auto Aabb::IntersectTriangle(std::array<Point4f, 3> const& vertex) const -> bool {
@@ -23,6 +23,7 @@ public:
     auto Expand(Point4f vertex) -> void;
     auto Intersect(Aabb const& other) -> void;
     auto GetCenter() const -> Point4f;
+    auto GetSurfaceArea() const -> Float32;
     auto GetMinVertex() const -> Point4f {
         return _minVertex;
     }
@@ -50,6 +51,7 @@ public:
     auto Translate(Vector4f translate) -> Aabb {
         return Aabb{ _minVertex + translate, _maxVertex + translate };
     }
+    auto Transform(Matrix4x4f const& matrix) const -> Aabb;
     auto IntersectRay(Ray ray) const -> Float32;
     auto IntersectTriangle(std::array<Point4f, 3> const& vertex) const -> bool;
     auto IntersectAabb(Aabb const& other) -> bool;
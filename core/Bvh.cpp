@@ -1,85 +1,249 @@
 #include "Bvh.h"
 
+#include <algorithm>
+#include <unordered_map>
+
+#include "OcclusionBuffer.h"
+
 using std::vector;
-using std::unique_ptr;
-using std::make_unique;
 
 namespace core {
 
-core::Bvh::Bvh(vector<Shape *> && shapes) {
-    _root = make_unique<BvhNode>(move(shapes));
-    SubDivideBvhNode(_root.get());
-    GetAabbList();
+core::Bvh::Bvh(vector<Shape *> && shapes, SplitMethod splitMethod, unsigned int threadCount)
+    : _splitMethod(splitMethod)
+    , _threadCount(threadCount) {
+    _instances.reserve(shapes.size());
+    auto modelIndexes = std::unordered_map<Movable const*, unsigned int>{};
+    for (auto * shape : shapes) {
+        assert(shape->GetMeshBvh() != nullptr);
+        auto model = modelIndexes.emplace(shape->GetModel(), static_cast<unsigned int>(_models.size()));
+        if (model.second) {
+            _models.push_back(shape->GetModel());
+        }
+        _instances.push_back(Instance{ shape, shape->GetMeshBvh() });
+        _instances.back().modelIndex = model.first->second;
+        auto const* material = shape->GetMaterial();
+        _instances.back().translucent = material != nullptr && material->GetTransparency() > 0;
+    }
+    UpdateInstances();
+    Build();
 }
 
-auto Bvh::SubDivideBvhNode(BvhNode * node) -> void {
-    assert(node->_leftChild == nullptr && node->_rightChild == nullptr);
-    if (node->_shapes.size() <= 1u) {
+auto Bvh::Refit() -> void {
+    // 1. update instances of models that moved since the last update
+    auto dirtyLeaves = vector<unsigned int>{};
+    for (auto const& range : _modelChangeTracker.CollectChanges(_models.data(), static_cast<unsigned int>(_models.size()))) {
+        for (auto model = range.first; model < range.first + range.count; ++model) {
+            for (auto i = _modelInstanceBegins[model]; i < _modelInstanceBegins[model + 1]; ++i) {
+                UpdateInstance(_modelInstances[i]);
+                dirtyLeaves.push_back(_instanceLeaves[_modelInstances[i]]);
+            }
+        }
+    }
+    if (dirtyLeaves.empty()) {
         return;
     }
-
-    // 1. calculate centers' AABB
-    auto centerAabb = Aabb{};
-    for (auto const& shape : node->_shapes) {
-        centerAabb.Expand(shape->GetAabb().GetCenter());
+    // 2. refit from their leaves towards the root, a node whose bounds did not change leaves its ancestors unchanged as well
+    for (auto leaf : dirtyLeaves) {
+        for (auto nodeIndex = leaf; nodeIndex != NoParent && RefitNode(nodeIndex); nodeIndex = _parents[nodeIndex]) {
+        }
+    }
+    // 3. refitted bounds overlap more and more as instances move apart, start over once traversal got too expensive
+    if (++_refitCount % SahCostResumInterval == 0) {
+        _weightedArea = SumNodeCosts();
+    }
+    if (GetSahCost() > _builtSahCost * RebuildSahCostRatio) {
+        Build();
     }
-    // 2. calculate split point (half of centers' AABB's longest axis)
-    auto axisIndex = 0;
-    auto diameter = centerAabb.GetMaxVertex() - centerAabb.GetMinVertex();
-    auto length = diameter(0);
-    for (auto i = 1u; i < 3; ++i) {
-        if (diameter(i) > length) {
-            length = diameter(i);
-            axisIndex = i;
+}
+
+auto Bvh::Rebuild() -> void {
+    UpdateInstances();
+    Build();
+}
+
+auto Bvh::GetAabb() const -> Aabb {
+    return _nodes.empty() ? Aabb{} : _nodes.front().GetAabb();
+}
+
+auto Bvh::CullFrustum(Frustum const& frustum, vector<Shape *> & visible, OcclusionBuffer const* occlusionBuffer, ShapeFilter filter) const -> void {
+    auto visit = [&](unsigned int begin, unsigned int end, unsigned int planeMask) {
+        for (auto i = begin; i < end; ++i) {
+            auto const& instance = _instances[i];
+            if (instance.meshBvh->GetTriangleCount() == 0 || (filter == ShapeFilter::Opaque && instance.translucent)) {
+                continue;
+            }
+            auto instanceMask = planeMask;
+            auto minVertex = instance.aabb.GetMinVertex();
+            auto maxVertex = instance.aabb.GetMaxVertex();
+            if ((instanceMask == 0 || frustum.IntersectAabb(minVertex.data(), maxVertex.data(), instanceMask))
+                && (occlusionBuffer == nullptr || occlusionBuffer->IsVisible(minVertex.data(), maxVertex.data()))) {
+                visible.push_back(instance.shape);
+            }
         }
+    };
+    frustum.CullBvh(_nodes, visit, [occlusionBuffer](BvhNode const& node) {
+        return occlusionBuffer == nullptr || occlusionBuffer->IsVisible(node.minVertex, node.maxVertex);
+    });
+}
+
+auto Bvh::GetSahCost() const -> Float32 {
+    if (_nodes.empty()) {
+        return 0.0f;
     }
-    if (length < MaxCenterAabbRadius) { // stop splitting BvhNode if children's centers' AABB's radius is smaller than this value
-        return;
+    auto rootArea = _nodes.front().GetSurfaceArea();
+    return rootArea > 0.0f ? _weightedArea / rootArea : static_cast<Float32>(_nodes.front().primitiveCount);
+}
+
+auto Bvh::Build() -> void {
+    auto primitives = vector<BvhBuilder::Primitive>{};
+    primitives.reserve(_instances.size());
+    for (auto const& instance : _instances) {
+        primitives.push_back(BvhBuilder::Primitive{ instance.aabb.GetMinVertex(), instance.aabb.GetMaxVertex(), instance.aabb.GetCenter() });
     }
+    auto builder = BvhBuilder{ _splitMethod, MaxLeafShapeCount, _threadCount };
+    builder.Build(primitives);
+    _nodes = builder.AcquireNodes();
 
-    auto splitPoint = centerAabb.GetMinVertex()(axisIndex) + length / 2;
+    // reorder instances so that leaves reference them directly
+    auto instances = vector<Instance>{};
+    instances.reserve(_instances.size());
+    for (auto index : builder.AcquirePrimitiveIndex()) {
+        instances.push_back(_instances[index]);
+    }
+    _instances = move(instances);
+    for (auto axis = 0u; axis < 3; ++axis) {
+        _instanceMinVertex[axis].assign(_instances.size() + 3, 0.0f);
+        _instanceMaxVertex[axis].assign(_instances.size() + 3, 0.0f);
+        for (auto i = 0u; i < _instances.size(); ++i) {
+            _instanceMinVertex[axis][i] = _instances[i].aabb.GetMinVertex()(axis);
+            _instanceMaxVertex[axis][i] = _instances[i].aabb.GetMaxVertex()(axis);
+        }
+    }
 
-    // 3. divide nodes into 2 groups according to split point
-    auto group0 = std::vector<Shape *>();
-    auto group1 = std::vector<Shape *>();
-    for (auto * shape : node->_shapes) {
-        if (shape->GetAabb().GetCenter()(axisIndex) <= splitPoint) {
-            group0.push_back(shape);
+    // links for bottom-up refit
+    _parents.assign(_nodes.size(), NoParent);
+    _instanceLeaves.resize(_instances.size());
+    for (auto i = 0u; i < _nodes.size(); ++i) {
+        auto const& node = _nodes[i];
+        if (node.IsLeaf()) {
+            for (auto j = node.offset; j < node.offset + node.primitiveCount; ++j) {
+                _instanceLeaves[j] = i;
+            }
         } else {
-            group1.push_back(shape);
+            _parents[i + 1] = i;
+            _parents[node.offset] = i;
         }
     }
-    node->_leftChild = make_unique<BvhNode>(move(group0));
-    node->_rightChild = make_unique<BvhNode>(move(group1));
-    node->_shapes.clear();
+    IndexInstancesByModel();
+    _weightedArea = SumNodeCosts();
+    _refitCount = 0u;
+    _builtSahCost = GetSahCost();
+    GetAabbList();
+}
 
-    // 4. recursively construct children
-    SubDivideBvhNode(node->_leftChild.get());
-    SubDivideBvhNode(node->_rightChild.get());
+auto Bvh::UpdateInstances() -> void {
+    for (auto i = 0u; i < _instances.size(); ++i) {
+        UpdateInstance(i);
+    }
+    // instances are up to date with the current transforms, later refits only look at models moved after this
+    _modelChangeTracker.Reset();
+    _modelChangeTracker.CollectChanges(_models.data(), static_cast<unsigned int>(_models.size()));
 }
 
-auto Bvh::GetAabbList() -> void {
-    // traverse bvh
-    auto currentNode = _root.get();
-    while (currentNode != nullptr) {
-        if (currentNode->_leftChild == nullptr) {
-            _aabbs.push_back(&currentNode->GetAabb());
-            currentNode = currentNode->_rightChild.get();
-        } else {
-            auto preNode = currentNode->_leftChild.get();
-            while (preNode->_rightChild != nullptr && preNode->_rightChild.get() != currentNode) {
-                preNode = preNode->_rightChild.get();
-            }
-            if (preNode->_rightChild == nullptr) {
-                preNode->_rightChild = unique_ptr<BvhNode>(currentNode);    // hack: now currentNode is handled by 2 unique_ptr...
-                currentNode = currentNode->_leftChild.get();
-            } else {
-                preNode->_rightChild.release(); // hack: this unique_ptr is a duplicated one, release it.
-                _aabbs.push_back(&currentNode->GetAabb());
-                currentNode = currentNode->_rightChild.get();
+auto Bvh::UpdateInstance(unsigned int instanceIndex) -> void {
+    auto & instance = _instances[instanceIndex];
+    auto const* model = instance.shape->GetModel();
+    instance.transform = model->GetTransform();
+    instance.transformInverse = Inverse(instance.transform); // world transforms may be scaled by their parents
+    instance.aabb = instance.meshBvh->GetTriangleCount() == 0 ? Aabb{} : instance.meshBvh->GetAabb().Transform(instance.transform);
+    // structure of arrays is allocated by the first build
+    if (instanceIndex < _instanceMinVertex[0].size()) {
+        for (auto axis = 0u; axis < 3; ++axis) {
+            _instanceMinVertex[axis][instanceIndex] = instance.aabb.GetMinVertex()(axis);
+            _instanceMaxVertex[axis][instanceIndex] = instance.aabb.GetMaxVertex()(axis);
+        }
+    }
+}
+
+// recompute bounds of a node from its instances or children, returns whether they changed
+auto Bvh::RefitNode(unsigned int nodeIndex) -> bool {
+    auto & node = _nodes[nodeIndex];
+    Float32 minVertex[3];
+    Float32 maxVertex[3];
+    if (node.IsLeaf()) {
+        auto aabb = Aabb{};
+        for (auto i = node.offset; i < node.offset + node.primitiveCount; ++i) {
+            auto const& instance = _instances[i];
+            if (instance.meshBvh->GetTriangleCount() > 0) { // expanding by an empty AABB would blow it up to infinity
+                aabb.Expand(instance.aabb);
             }
         }
+        for (auto i = 0u; i < 3; ++i) {
+            minVertex[i] = aabb.GetMinVertex()(i);
+            maxVertex[i] = aabb.GetMaxVertex()(i);
+        }
+    } else {
+        auto const& firstChild = _nodes[nodeIndex + 1];
+        auto const& secondChild = _nodes[node.offset];
+        for (auto i = 0u; i < 3; ++i) {
+            minVertex[i] = std::min(firstChild.minVertex[i], secondChild.minVertex[i]);
+            maxVertex[i] = std::max(firstChild.maxVertex[i], secondChild.maxVertex[i]);
+        }
     }
+    if (std::equal(minVertex, minVertex + 3, node.minVertex) && std::equal(maxVertex, maxVertex + 3, node.maxVertex)) {
+        return false;
+    }
+    _weightedArea -= GetNodeCost(nodeIndex);
+    std::copy(minVertex, minVertex + 3, node.minVertex);
+    std::copy(maxVertex, maxVertex + 3, node.maxVertex);
+    _weightedArea += GetNodeCost(nodeIndex);
+    // keep render data of the debug AABB
+    auto aabb = node.GetAabb();
+    _nodeAabbs[nodeIndex].SetMinVertex(aabb.GetMinVertex());
+    _nodeAabbs[nodeIndex].SetMaxVertex(aabb.GetMaxVertex());
+    return true;
 }
 
-}
\ No newline at end of file
+// instance indexes change with every build, models keep their order
+auto Bvh::IndexInstancesByModel() -> void {
+    _modelInstanceBegins.assign(_models.size() + 1, 0u);
+    for (auto const& instance : _instances) {
+        ++_modelInstanceBegins[instance.modelIndex + 1];
+    }
+    for (auto i = 0u; i < _models.size(); ++i) {
+        _modelInstanceBegins[i + 1] += _modelInstanceBegins[i];
+    }
+    auto next = vector<unsigned int>(_modelInstanceBegins.cbegin(), _modelInstanceBegins.cend() - 1);
+    _modelInstances.resize(_instances.size());
+    for (auto i = 0u; i < _instances.size(); ++i) {
+        _modelInstances[next[_instances[i].modelIndex]++] = i;
+    }
+}
+
+auto Bvh::SumNodeCosts() const -> Float32 {
+    auto sum = 0.0f;
+    for (auto i = 0u; i < _nodes.size(); ++i) {
+        sum += GetNodeCost(i);
+    }
+    return sum;
+}
+
+auto Bvh::GetNodeCost(unsigned int nodeIndex) const -> Float32 {
+    auto const& node = _nodes[nodeIndex];
+    return node.GetSurfaceArea() * (node.IsLeaf() ? node.primitiveCount : BvhBuilder::SahTraversalCost);
+}
+
+auto Bvh::GetAabbList() -> void {
+    _nodeAabbs.clear();
+    _aabbs.clear();
+    _nodeAabbs.reserve(_nodes.size());
+    for (auto const& node : _nodes) {
+        _nodeAabbs.push_back(node.GetAabb());
+    }
+    for (auto & aabb : _nodeAabbs) {
+        _aabbs.push_back(&aabb);
+    }
+}
+
+}
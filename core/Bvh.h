@@ -1,18 +1,72 @@
 #pragma once
 
+#include <array>
+
 #include "BvhNode.h"
+#include "BvhBuilder.h"
+#include "Frustum.h"
+#include "SlabTest.h"
+#include "MeshBvh.h"
+#include "Shape.h"
 #include "ShaderProgram.h"
+#include "TransformChangeTracker.h"
 
 namespace core {
 
+class OcclusionBuffer;
+
+// Top-level BVH over shape instances. Every instance references the bottom-level BVH of its mesh
+// and caches its model transform, so moving models only requires Refit() or Rebuild().
 class Bvh {
-    static constexpr const Float32 MaxCenterAabbRadius = 0.5f;
+    static constexpr const unsigned int MaxLeafShapeCount = 4u;
+    static constexpr const unsigned int NoParent = 0xffffffffu;
+public:
+    static constexpr const Float32 RebuildSahCostRatio = 1.5f; // Refit() rebuilds once SAH cost grows past this ratio of the built tree's
+    static constexpr const unsigned int SahCostResumInterval = 64u; // refits between exact sums of the incrementally updated SAH cost
+
+    static constexpr const unsigned int MaxDepth = BvhBuilder::MaxDepth;
+    using SplitMethod = BvhBuilder::SplitMethod;
+    enum class ShapeFilter {
+        All,
+        Opaque, // without shapes whose material was translucent when the Bvh was built
+    };
+    struct Instance {
+    public:
+        Shape * shape;
+        MeshBvh const* meshBvh;
+        Matrix4x4f transform;
+        Matrix4x4f transformInverse;
+        Aabb aabb; // world space
+        unsigned int modelIndex; // of shape's model in the distinct models of the instances
+        bool translucent;
+    };
 public:
-    Bvh(std::vector<Shape *> && shapes);
+    Bvh(std::vector<Shape *> && shapes, SplitMethod splitMethod = SplitMethod::Sah, unsigned int threadCount = 1u);
 public:
-    auto GetRoot() const -> BvhNode * {
-        return _root.get();
+    // update transforms of instances whose model moved and refit the bounds on their paths to the root,
+    // keeping the tree topology. Only the models are checked for changes, not every instance. Rebuilds the whole tree
+    // if the refitted one has degraded too much, there is no local rebalancing by tree rotations.
+    auto Refit() -> void;
+    // update instance transforms and rebuild the tree over instances, mesh BVHs are reused
+    auto Rebuild() -> void;
+    auto GetNodes() const -> std::vector<BvhNode> const& {
+        return _nodes;
     }
+    // instances ordered so that every leaf references a contiguous range
+    auto GetInstances() const -> std::vector<Instance> const& {
+        return _instances;
+    }
+    auto GetAabb() const -> Aabb;
+    // slab test of ray against the AABBs of 4 consecutive instances starting at first, see IntersectSlab4.
+    // instances past the end are padding and have to be masked out by the caller.
+    auto IntersectInstances(SlabRay const& ray, unsigned int first, Float32 t[4]) const -> int {
+        Float32 const* minVertex[3] = { &_instanceMinVertex[0][first], &_instanceMinVertex[1][first], &_instanceMinVertex[2][first] };
+        Float32 const* maxVertex[3] = { &_instanceMaxVertex[0][first], &_instanceMaxVertex[1][first], &_instanceMaxVertex[2][first] };
+        return IntersectSlab4(ray, minVertex, maxVertex, t);
+    }
+    // appends shapes whose instance intersects the frustum and passes filter to visible, in the order of instances.
+    // nodes and instances hidden behind the occluders of occlusionBuffer are rejected as well if it is given.
+    auto CullFrustum(Frustum const& frustum, std::vector<Shape *> & visible, OcclusionBuffer const* occlusionBuffer = nullptr, ShapeFilter filter = ShapeFilter::All) const -> void;
     auto GetAabbs() const -> std::vector<Aabb *> const& {
         return _aabbs;
     }
@@ -25,11 +79,38 @@ public:
     auto GetShaderProgram() -> ShaderProgram * {
         return &_shaderProgram;
     }
+    auto GetSplitMethod() const -> SplitMethod {
+        return _splitMethod;
+    }
+    auto GetSahCost() const -> Float32;
 private:
-    auto SubDivideBvhNode(BvhNode * node) -> void;
+    auto Build() -> void;
+    auto UpdateInstances() -> void;
+    auto UpdateInstance(unsigned int instanceIndex) -> void;
+    auto IndexInstancesByModel() -> void;
+    auto SumNodeCosts() const -> Float32;
+    auto RefitNode(unsigned int nodeIndex) -> bool;
+    auto GetNodeCost(unsigned int nodeIndex) const -> Float32;
     auto GetAabbList() -> void;
 private:
-    std::unique_ptr<BvhNode> _root = nullptr;
+    SplitMethod _splitMethod;
+    unsigned int _threadCount;
+    std::vector<BvhNode> _nodes;
+    std::vector<Instance> _instances;
+    std::array<std::vector<Float32>, 3> _instanceMinVertex; // instance AABBs as structure of arrays, padded for 4-wide loads
+    std::array<std::vector<Float32>, 3> _instanceMaxVertex;
+    std::vector<unsigned int> _parents; // parent node of every node
+    std::vector<unsigned int> _instanceLeaves; // leaf node of every instance
+    std::vector<Movable const*> _models; // distinct models of the instances
+    std::vector<unsigned int> _modelInstanceBegins; // instances of model i are _modelInstances[begins[i]] to [begins[i + 1]]
+    std::vector<unsigned int> _modelInstances;
+    TransformChangeTracker _modelChangeTracker;
+    // sum of node costs weighted by surface area, SAH cost without normalization by the root. updated incrementally
+    // by refits and summed again every SahCostResumInterval refits, as the float updates drift
+    Float32 _weightedArea = 0.0f;
+    unsigned int _refitCount = 0u;
+    Float32 _builtSahCost = 0.0f;
+    std::vector<Aabb> _nodeAabbs;
     std::vector<Aabb *> _aabbs;
 
     openglUint _vao;
@@ -37,4 +118,4 @@ private:
     int _indexCount = 0; // todo: get rid of this mess
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,366 @@
+#include "BvhBuilder.h"
+
+#include <algorithm>
+#include <array>
+#include <future>
+#include <limits>
+
+#include "Parallel.h"
+
+using std::vector;
+using std::array;
+
+namespace core {
+
+namespace {
+
+auto GetBinIndex(BvhBuilder::Primitive const& primitive, unsigned int axisIndex, Point4f const& centerMin, Vector4f const& diameter) -> unsigned int {
+    auto offset = (primitive.center(axisIndex) - centerMin(axisIndex)) / diameter(axisIndex);
+    return std::min(BvhBuilder::SahBinCount - 1, static_cast<unsigned int>(offset * BvhBuilder::SahBinCount));
+}
+
+}
+
+auto BvhBuilder::ComputeSahCost(vector<BvhNode> const& nodes) -> Float32 {
+    // expected cost of tracing a ray through the tree: every node is weighted by the probability
+    // of being hit (its surface area relative to root's), leaves are charged for their primitives.
+    if (nodes.empty()) {
+        return 0.0f;
+    }
+    auto rootArea = nodes.front().GetSurfaceArea();
+    if (rootArea <= 0.0f) {
+        return static_cast<Float32>(nodes.front().primitiveCount);
+    }
+    auto cost = 0.0f;
+    for (auto const& node : nodes) {
+        auto probability = node.GetSurfaceArea() / rootArea;
+        cost += probability * (node.IsLeaf() ? node.primitiveCount : SahTraversalCost);
+    }
+    return cost;
+}
+
+BvhBuilder::BvhBuilder(SplitMethod splitMethod, unsigned int maxLeafSize, unsigned int threadCount, unsigned int primitiveBlockSize)
+    : _splitMethod(splitMethod)
+    , _maxLeafSize(maxLeafSize)
+    , _threadCount(std::max(1u, threadCount))
+    , _primitiveBlockSize(std::max(1u, primitiveBlockSize))
+    , _taskDepth(0u) {
+    if (_threadCount > 1) {
+        // spawn about 4 tasks per thread so that uneven splits still keep every thread busy
+        while ((1u << _taskDepth) < _threadCount * 4) {
+            ++_taskDepth;
+        }
+    }
+}
+
+auto BvhBuilder::Build(vector<Primitive> const& primitives) -> void {
+    _primitives = &primitives;
+    _nodes.clear();
+    _primitiveIndex.resize(primitives.size());
+    for (auto i = 0u; i < primitives.size(); ++i) {
+        _primitiveIndex[i] = i;
+    }
+    if (primitives.empty()) {
+        return;
+    }
+    if (_threadCount > 1 && primitives.size() >= ParallelRangeSize) {
+        _partitionBuffer.resize(primitives.size());
+    }
+    // a binary tree has less than 2n nodes
+    _nodes.reserve(primitives.size() * 2 - 1);
+    BuildNode(_nodes, 0u, static_cast<unsigned int>(primitives.size()), 0u);
+    _primitives = nullptr;
+    _partitionBuffer.clear();
+    _partitionBuffer.shrink_to_fit();
+}
+
+auto BvhBuilder::AcquireNodes() -> vector<BvhNode> {
+    return move(_nodes);
+}
+
+auto BvhBuilder::AcquirePrimitiveIndex() -> vector<unsigned int> {
+    return move(_primitiveIndex);
+}
+
+// Tasks of sibling subtrees only touch their own range of _primitiveIndex and _partitionBuffer
+// and append to their own node array, so they need no synchronization.
+auto BvhBuilder::BuildNode(vector<BvhNode> & nodes, unsigned int begin, unsigned int end, unsigned int depth) -> unsigned int {
+    auto nodeIndex = static_cast<unsigned int>(nodes.size());
+    nodes.emplace_back();
+    auto const chunkCount = GetChunkCount(begin, end, depth);
+
+    // 1. calculate AABB of primitives and AABB of their centers
+    auto aabb = Aabb{};
+    auto centerAabb = Aabb{};
+    ComputeBounds(begin, end, chunkCount, aabb, centerAabb);
+
+    // 2. find split point in the primitive range, end means no split
+    auto const count = end - begin;
+    auto axis = uint8{ 0 };
+    auto mid = end;
+    if (count > 1) {
+        if (depth + 2 >= MaxDepth / 2) {
+            // keep the tree shallow enough for fixed-size traversal stacks: from here on, every split halves the range
+            mid = count > _maxLeafSize ? SplitMedian(begin, end, centerAabb, axis) : end;
+        } else if (_splitMethod == SplitMethod::Middle) {
+            mid = SplitMiddle(begin, end, chunkCount, centerAabb, axis);
+        } else {
+            mid = SplitSah(begin, end, chunkCount, centerAabb, aabb.GetSurfaceArea(), axis);
+        }
+        if (mid == begin) {
+            mid = end;
+        }
+        // the split methods may give up on primitives too close together, leaves still never exceed maxLeafSize
+        if (mid == end && (count > _maxLeafSize || count > std::numeric_limits<uint16>::max())) {
+            mid = SplitMedian(begin, end, centerAabb, axis);
+        }
+    }
+
+    // 3. write node, recursively construct children
+    auto const& minVertex = aabb.GetMinVertex();
+    auto const& maxVertex = aabb.GetMaxVertex();
+    for (auto i = 0u; i < 3; ++i) {
+        nodes[nodeIndex].minVertex[i] = minVertex(i);
+        nodes[nodeIndex].maxVertex[i] = maxVertex(i);
+    }
+    if (mid == end) {
+        nodes[nodeIndex].offset = begin;
+        nodes[nodeIndex].primitiveCount = static_cast<uint16>(count);
+        nodes[nodeIndex].axis = 0;
+        return nodeIndex;
+    }
+    auto secondChild = 0u;
+    if (_threadCount > 1 && depth < _taskDepth && end - mid >= ParallelRangeSize) {
+        // build second subtree into a separate array while this thread builds the first one,
+        // then append it, its interior nodes' child indices shifted by its position in this array
+        auto secondNodes = vector<BvhNode>{};
+        secondNodes.reserve((end - mid) * 2 - 1);
+        auto task = std::async(std::launch::async, [this, &secondNodes, mid, end, depth] {
+            BuildNode(secondNodes, mid, end, depth + 1);
+        });
+        BuildNode(nodes, begin, mid, depth + 1);
+        task.get();
+        secondChild = static_cast<unsigned int>(nodes.size());
+        for (auto node : secondNodes) {
+            if (!node.IsLeaf()) {
+                node.offset += secondChild;
+            }
+            nodes.push_back(node);
+        }
+    } else {
+        BuildNode(nodes, begin, mid, depth + 1);
+        secondChild = BuildNode(nodes, mid, end, depth + 1);
+    }
+    // nodes may have been reallocated during recursion
+    nodes[nodeIndex].offset = secondChild;
+    nodes[nodeIndex].primitiveCount = 0;
+    nodes[nodeIndex].axis = axis;
+    return nodeIndex;
+}
+
+auto BvhBuilder::GetChunkCount(unsigned int begin, unsigned int end, unsigned int depth) const -> unsigned int {
+    // near the root only a few tasks are running, so the linear passes over a range are split into chunks as well;
+    // 2^depth tasks share the threads at a given depth
+    if (_threadCount == 1 || end - begin < ParallelRangeSize || depth >= 32) {
+        return 1u;
+    }
+    return std::max(1u, std::min(_threadCount >> depth, end - begin));
+}
+
+auto BvhBuilder::ComputeBounds(unsigned int begin, unsigned int end, unsigned int chunkCount, Aabb & aabb, Aabb & centerAabb) const -> void {
+    auto const& primitives = *_primitives;
+    auto chunkAabbs = vector<array<Aabb, 2>>(chunkCount);
+    ForEachChunk(begin, end, chunkCount, [this, &primitives, &chunkAabbs](unsigned int chunk, unsigned int first, unsigned int last) {
+        auto & bounds = chunkAabbs[chunk];
+        for (auto i = first; i < last; ++i) {
+            auto const& primitive = primitives[_primitiveIndex[i]];
+            bounds[0].Expand(primitive.minVertex);
+            bounds[0].Expand(primitive.maxVertex);
+            bounds[1].Expand(primitive.center);
+        }
+    });
+    // every chunk holds at least one primitive, so none of the AABBs is empty
+    aabb = chunkAabbs[0][0];
+    centerAabb = chunkAabbs[0][1];
+    for (auto chunk = 1u; chunk < chunkCount; ++chunk) {
+        aabb.Expand(chunkAabbs[chunk][0]);
+        centerAabb.Expand(chunkAabbs[chunk][1]);
+    }
+}
+
+auto BvhBuilder::ComputeBins(unsigned int begin, unsigned int end, unsigned int chunkCount, Point4f const& centerMin, Vector4f const& diameter, AxisBins & bins) const -> void {
+    auto const& primitives = *_primitives;
+    auto chunkBins = vector<AxisBins>(chunkCount);
+    ForEachChunk(begin, end, chunkCount, [this, &primitives, &centerMin, &diameter, &chunkBins](unsigned int chunk, unsigned int first, unsigned int last) {
+        for (auto axisIndex = 0u; axisIndex < 3; ++axisIndex) {
+            if (diameter(axisIndex) <= std::numeric_limits<Float32>::epsilon()) {
+                continue;
+            }
+            auto & axisBins = chunkBins[chunk][axisIndex];
+            for (auto i = first; i < last; ++i) {
+                auto const& primitive = primitives[_primitiveIndex[i]];
+                auto & bin = axisBins[GetBinIndex(primitive, axisIndex, centerMin, diameter)];
+                bin.aabb.Expand(primitive.minVertex);
+                bin.aabb.Expand(primitive.maxVertex);
+                ++bin.count;
+            }
+        }
+    });
+    bins = chunkBins[0];
+    for (auto chunk = 1u; chunk < chunkCount; ++chunk) {
+        for (auto axisIndex = 0u; axisIndex < 3; ++axisIndex) {
+            for (auto i = 0u; i < SahBinCount; ++i) {
+                auto const& bin = chunkBins[chunk][axisIndex][i];
+                if (bin.count > 0) { // expanding by an empty AABB would blow it up to infinity
+                    bins[axisIndex][i].aabb.Expand(bin.aabb);
+                    bins[axisIndex][i].count += bin.count;
+                }
+            }
+        }
+    }
+}
+
+template <typename Predicate>
+auto BvhBuilder::Partition(unsigned int begin, unsigned int end, unsigned int chunkCount, Predicate predicate) -> unsigned int {
+    auto const indexBegin = _primitiveIndex.begin();
+    if (chunkCount == 1) {
+        return static_cast<unsigned int>(std::partition(indexBegin + begin, indexBegin + end, predicate) - indexBegin);
+    }
+    // 1. partition every chunk in place
+    auto chunkMid = vector<unsigned int>(chunkCount);
+    ForEachChunk(begin, end, chunkCount, [indexBegin, &predicate, &chunkMid](unsigned int chunk, unsigned int first, unsigned int last) {
+        chunkMid[chunk] = static_cast<unsigned int>(std::partition(indexBegin + first, indexBegin + last, predicate) - indexBegin);
+    });
+    // 2. lay out all chunks' left sides, followed by all chunks' right sides
+    auto leftOffset = vector<unsigned int>(chunkCount);
+    auto rightOffset = vector<unsigned int>(chunkCount);
+    auto offset = begin;
+    for (auto chunk = 0u; chunk < chunkCount; ++chunk) {
+        leftOffset[chunk] = offset;
+        offset += chunkMid[chunk] - GetChunkBegin(begin, end, chunkCount, chunk);
+    }
+    auto const mid = offset;
+    for (auto chunk = 0u; chunk < chunkCount; ++chunk) {
+        rightOffset[chunk] = offset;
+        offset += GetChunkBegin(begin, end, chunkCount, chunk + 1) - chunkMid[chunk];
+    }
+    // 3. scatter into the buffer, then copy back
+    auto const bufferBegin = _partitionBuffer.begin();
+    ForEachChunk(begin, end, chunkCount, [indexBegin, bufferBegin, &chunkMid, &leftOffset, &rightOffset](unsigned int chunk, unsigned int first, unsigned int last) {
+        std::copy(indexBegin + first, indexBegin + chunkMid[chunk], bufferBegin + leftOffset[chunk]);
+        std::copy(indexBegin + chunkMid[chunk], indexBegin + last, bufferBegin + rightOffset[chunk]);
+    });
+    ForEachChunk(begin, end, chunkCount, [indexBegin, bufferBegin](unsigned int, unsigned int first, unsigned int last) {
+        std::copy(bufferBegin + first, bufferBegin + last, indexBegin + first);
+    });
+    return mid;
+}
+
+auto BvhBuilder::SplitMiddle(unsigned int begin, unsigned int end, unsigned int chunkCount, Aabb const& centerAabb, uint8 & axis) -> unsigned int {
+    // split at half of centers' AABB's longest axis
+    auto axisIndex = 0u;
+    auto diameter = static_cast<Vector4f>(centerAabb.GetMaxVertex() - centerAabb.GetMinVertex());
+    auto length = diameter(0);
+    for (auto i = 1u; i < 3; ++i) {
+        if (diameter(i) > length) {
+            length = diameter(i);
+            axisIndex = i;
+        }
+    }
+    if (length < MaxCenterAabbRadius) { // stop splitting if children's centers' AABB's radius is smaller than this value
+        return end;
+    }
+    auto splitPoint = centerAabb.GetMinVertex()(axisIndex) + length / 2;
+    axis = static_cast<uint8>(axisIndex);
+
+    auto const& primitives = *_primitives;
+    return Partition(begin, end, chunkCount, [&primitives, axisIndex, splitPoint](unsigned int index) {
+        return primitives[index].center(axisIndex) <= splitPoint;
+    });
+}
+
+// binned SAH split, see Wald, "On fast Construction of SAH-based Bounding Volume Hierarchies".
+auto BvhBuilder::SplitSah(unsigned int begin, unsigned int end, unsigned int chunkCount, Aabb const& centerAabb, Float32 nodeArea, uint8 & axis) -> unsigned int {
+    auto const& primitives = *_primitives;
+    auto const count = end - begin;
+    auto centerMin = centerAabb.GetMinVertex();
+    auto diameter = static_cast<Vector4f>(centerAabb.GetMaxVertex() - centerMin);
+    auto bins = AxisBins{};
+    ComputeBins(begin, end, chunkCount, centerMin, diameter, bins);
+
+    // 1. evaluate split candidates on bin boundaries of every axis
+    auto bestCost = std::numeric_limits<Float32>::max();
+    auto bestAxis = -1;
+    auto bestSplit = 0u;
+    for (auto axisIndex = 0u; axisIndex < 3; ++axisIndex) {
+        if (diameter(axisIndex) <= std::numeric_limits<Float32>::epsilon()) {
+            continue;
+        }
+        auto const& axisBins = bins[axisIndex];
+        // sweep from right to left to get area and count of every right side
+        auto rightArea = array<Float32, SahBinCount>{};
+        auto rightCount = array<unsigned int, SahBinCount>{};
+        auto rightAabb = Aabb{};
+        auto sideCount = 0u;
+        for (auto i = SahBinCount - 1; i > 0; --i) {
+            if (axisBins[i].count > 0) { // expanding by an empty AABB would blow it up to infinity
+                rightAabb.Expand(axisBins[i].aabb);
+                sideCount += axisBins[i].count;
+            }
+            rightArea[i] = rightAabb.GetSurfaceArea();
+            rightCount[i] = sideCount;
+        }
+        // sweep from left to right, candidate i splits between bin i-1 and bin i
+        auto leftAabb = Aabb{};
+        sideCount = 0u;
+        for (auto i = 1u; i < SahBinCount; ++i) {
+            if (axisBins[i - 1].count > 0) {
+                leftAabb.Expand(axisBins[i - 1].aabb);
+                sideCount += axisBins[i - 1].count;
+            }
+            if (sideCount == 0 || rightCount[i] == 0) {
+                continue;
+            }
+            auto cost = SahTraversalCost + (leftAabb.GetSurfaceArea() * GetLeafCost(sideCount) + rightArea[i] * GetLeafCost(rightCount[i])) / nodeArea;
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axisIndex;
+                bestSplit = i;
+            }
+        }
+    }
+
+    // 2. stop splitting if it is not cheaper than testing all primitives, unless the leaf would be too large
+    if (bestAxis < 0) {
+        // all centers coincide, no split plane can separate them
+        return count <= _maxLeafSize ? end : begin + count / 2;
+    }
+    if (bestCost >= GetLeafCost(count) && count <= _maxLeafSize) {
+        return end;
+    }
+    axis = static_cast<uint8>(bestAxis);
+    auto const splitAxis = static_cast<unsigned int>(bestAxis);
+    return Partition(begin, end, chunkCount, [&primitives, &centerMin, &diameter, splitAxis, bestSplit](unsigned int index) {
+        return GetBinIndex(primitives[index], splitAxis, centerMin, diameter) < bestSplit;
+    });
+}
+
+auto BvhBuilder::SplitMedian(unsigned int begin, unsigned int end, Aabb const& centerAabb, uint8 & axis) -> unsigned int {
+    // object median on centers' AABB's longest axis, always halves the range
+    auto axisIndex = 0u;
+    auto diameter = static_cast<Vector4f>(centerAabb.GetMaxVertex() - centerAabb.GetMinVertex());
+    for (auto i = 1u; i < 3; ++i) {
+        if (diameter(i) > diameter(axisIndex)) {
+            axisIndex = i;
+        }
+    }
+    axis = static_cast<uint8>(axisIndex);
+    auto const& primitives = *_primitives;
+    auto mid = begin + (end - begin) / 2;
+    std::nth_element(_primitiveIndex.begin() + begin, _primitiveIndex.begin() + mid, _primitiveIndex.begin() + end, [&primitives, axisIndex](unsigned int lhs, unsigned int rhs) {
+        return primitives[lhs].center(axisIndex) < primitives[rhs].center(axisIndex);
+    });
+    return mid;
+}
+
+}
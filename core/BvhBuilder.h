@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "BvhNode.h"
+
+namespace core {
+
+// Top-down BVH builder over primitive bounds, emits nodes in depth-first order.
+class BvhBuilder {
+public:
+    static constexpr const unsigned int MaxDepth = 64u; // size of traversal stacks
+    static constexpr const Float32 MaxCenterAabbRadius = 0.5f;
+    static constexpr const unsigned int SahBinCount = 12u;
+    static constexpr const Float32 SahTraversalCost = 0.125f; // relative to the cost of intersecting one primitive
+    static auto ComputeSahCost(std::vector<BvhNode> const& nodes) -> Float32;
+public:
+    enum class SplitMethod {
+        Middle, // split at half of centers' AABB's longest axis
+        Sah,    // binned surface area heuristic over all 3 axes
+    };
+    struct Primitive {
+        Point4f minVertex;
+        Point4f maxVertex;
+        Point4f center;
+    };
+public:
+    // threadCount > 1 builds large subtrees as concurrent tasks and splits binning and partitioning of large ranges into chunks.
+    // primitiveBlockSize > 1 charges leaves per started block of primitives, for leaves tested that many at once.
+    BvhBuilder(SplitMethod splitMethod, unsigned int maxLeafSize, unsigned int threadCount = 1u, unsigned int primitiveBlockSize = 1u);
+public:
+    auto Build(std::vector<Primitive> const& primitives) -> void;
+    auto AcquireNodes() -> std::vector<BvhNode>;
+    auto AcquirePrimitiveIndex() -> std::vector<unsigned int>;
+private:
+    struct Bin {
+        Aabb aabb;
+        unsigned int count = 0u;
+    };
+    using AxisBins = std::array<std::array<Bin, SahBinCount>, 3>;
+private:
+    auto BuildNode(std::vector<BvhNode> & nodes, unsigned int begin, unsigned int end, unsigned int depth) -> unsigned int;
+    auto GetChunkCount(unsigned int begin, unsigned int end, unsigned int depth) const -> unsigned int;
+    auto ComputeBounds(unsigned int begin, unsigned int end, unsigned int chunkCount, Aabb & aabb, Aabb & centerAabb) const -> void;
+    auto ComputeBins(unsigned int begin, unsigned int end, unsigned int chunkCount, Point4f const& centerMin, Vector4f const& diameter, AxisBins & bins) const -> void;
+    template <typename Predicate>
+    auto Partition(unsigned int begin, unsigned int end, unsigned int chunkCount, Predicate predicate) -> unsigned int;
+    auto SplitMiddle(unsigned int begin, unsigned int end, unsigned int chunkCount, Aabb const& centerAabb, uint8 & axis) -> unsigned int;
+    auto SplitSah(unsigned int begin, unsigned int end, unsigned int chunkCount, Aabb const& centerAabb, Float32 nodeArea, uint8 & axis) -> unsigned int;
+    auto GetLeafCost(unsigned int primitiveCount) const -> Float32 {
+        return static_cast<Float32>((primitiveCount + _primitiveBlockSize - 1) / _primitiveBlockSize);
+    }
+    auto SplitMedian(unsigned int begin, unsigned int end, Aabb const& centerAabb, uint8 & axis) -> unsigned int;
+private:
+    SplitMethod _splitMethod;
+    unsigned int _maxLeafSize;
+    unsigned int _threadCount;
+    unsigned int _primitiveBlockSize;
+    unsigned int _taskDepth; // subtrees above this depth are built as separate tasks
+    std::vector<Primitive> const* _primitives = nullptr;
+    std::vector<BvhNode> _nodes;
+    std::vector<unsigned int> _primitiveIndex;
+    std::vector<unsigned int> _partitionBuffer;
+};
+
+}
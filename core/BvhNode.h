@@ -1,43 +1,62 @@
 #pragma once
 
-#include <memory>
-#include <array>
-
+#include "Primitive.h"
+#include "Matrix.h"
+#include "Ray.h"
 #include "Aabb.h"
-#include "Shape.h"
+#include "SlabTest.h"
 
 namespace core {
 
-class BvhNode {
-public:
-    friend class Bvh;
+// Compact BVH node, stored in depth-first order in a flat array: the first child of an interior node
+// immediately follows it, the second child is referenced by offset. Leaves reference a range of the
+// BVH's primitive index array.
+struct BvhNode {
 public:
-    BvhNode() = default;
-    explicit BvhNode(std::vector<Shape *> && shapes);
+    Float32 minVertex[3];
+    uint32 offset; // leaf: first primitive of the range; interior node: index of the second child
+    Float32 maxVertex[3];
+    uint16 primitiveCount; // 0 for interior node
+    uint8 axis; // split axis of interior node
+    uint8 _pad;
 public:
-    auto GetAabb() const -> Aabb const& {
-        return _aabb;
+    auto IsLeaf() const -> bool {
+        return primitiveCount != 0;
     }
-    auto GetAabb() -> Aabb & {
-        return _aabb;
+    auto GetSurfaceArea() const -> Float32 {
+        auto x = maxVertex[0] - minVertex[0];
+        auto y = maxVertex[1] - minVertex[1];
+        auto z = maxVertex[2] - minVertex[2];
+        return 2 * (x * y + y * z + z * x);
     }
-    auto IsLeaf() const -> bool {
-        return _leftChild == nullptr && _rightChild == nullptr;
+    auto GetAabb() const -> Aabb {
+        return Aabb{
+            Point4f{ minVertex[0], minVertex[1], minVertex[2], 1.0f },
+            Point4f{ maxVertex[0], maxVertex[1], maxVertex[2], 1.0f },
+        };
     }
-    auto LeftChild() const -> BvhNode * {
-        return _leftChild.get();
+    auto IntersectAabb(Aabb const& aabb) const -> bool {
+        auto const& aabbMin = aabb.GetMinVertex();
+        auto const& aabbMax = aabb.GetMaxVertex();
+        for (auto i = 0u; i < 3; ++i) {
+            if (aabbMax(i) < minVertex[i] || aabbMin(i) > maxVertex[i]) {
+                return false;
+            }
+        }
+        return true;
     }
-    auto RightChild() const -> BvhNode * {
-        return _rightChild.get();
+    // children of an interior node at nodeIndex in the order ray enters them, the first child holds the lower side of axis
+    auto GetOrderedChildren(unsigned int nodeIndex, SlabRay const& ray, unsigned int & nearChild, unsigned int & farChild) const -> void {
+        auto negative = (ray.negativeAxes & (1u << axis)) != 0;
+        nearChild = negative ? offset : nodeIndex + 1;
+        farChild = negative ? nodeIndex + 1 : offset;
     }
-    auto GetShapes() const -> std::vector<Shape *> const& {
-        return _shapes;
+    // same semantic as Aabb::IntersectRay: distance to entry point (or exit point if origin is inside), -1 if missed
+    auto IntersectRay(SlabRay const& ray) const -> Float32 {
+        // offset and primitiveCount follow the vertexes and fill the 4th lane, which is ignored
+        return IntersectSlab(ray, minVertex, maxVertex);
     }
-private:
-    Aabb _aabb;
-    std::unique_ptr<BvhNode> _leftChild = nullptr;
-    std::unique_ptr<BvhNode> _rightChild = nullptr;
-    std::vector<Shape *> _shapes;
 };
+static_assert(sizeof(BvhNode) == 32, "BvhNode should be 32 bytes so that 2 nodes share a cache line");
 
-}
\ No newline at end of file
+}
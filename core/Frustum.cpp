@@ -0,0 +1,94 @@
+#include "Frustum.h"
+
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace core {
+
+Frustum::Frustum(Matrix4x4f const& viewProjectTransform) {
+    // Gribb & Hartmann: -w <= x <= w and friends become dot products of a point with sums of matrix rows
+    auto const& m = viewProjectTransform;
+    for (auto i = 0u; i < PlaneCount; ++i) {
+        auto row = i / 2;
+        auto sign = i % 2 == 0 ? 1.0f : -1.0f;
+        Float32 plane[4];
+        for (auto j = 0u; j < 4; ++j) {
+            plane[j] = m(3, j) + sign * m(row, j);
+        }
+        auto length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        for (auto j = 0u; j < 4; ++j) {
+            _planes[j][i] = plane[j] / length;
+        }
+    }
+    for (auto i = PlaneCount; i < 8; ++i) {
+        _planes[0][i] = _planes[1][i] = _planes[2][i] = 0.0f;
+        _planes[3][i] = 1.0f;
+    }
+    for (auto j = 0u; j < 3; ++j) {
+        for (auto i = 0u; i < 8; ++i) {
+            _absNormals[j][i] = std::abs(_planes[j][i]);
+        }
+    }
+}
+
+auto Frustum::IntersectAabb(Float32 const* minVertex, Float32 const* maxVertex, unsigned int & planeMask) const -> bool {
+    // halve before subtracting, the vertexes of an empty AABB are +-FLT_MAX
+    auto const half = _mm_set1_ps(0.5f);
+    auto minHalf = _mm_mul_ps(_mm_loadu_ps(minVertex), half);
+    auto maxHalf = _mm_mul_ps(_mm_loadu_ps(maxVertex), half);
+    auto center = _mm_add_ps(maxHalf, minHalf);
+    auto extent = _mm_sub_ps(maxHalf, minHalf);
+    __m128 centers[3] = {
+        _mm_shuffle_ps(center, center, _MM_SHUFFLE(0, 0, 0, 0)),
+        _mm_shuffle_ps(center, center, _MM_SHUFFLE(1, 1, 1, 1)),
+        _mm_shuffle_ps(center, center, _MM_SHUFFLE(2, 2, 2, 2)),
+    };
+    __m128 extents[3] = {
+        _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(0, 0, 0, 0)),
+        _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(1, 1, 1, 1)),
+        _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(2, 2, 2, 2)),
+    };
+    auto outside = 0u;
+    auto inside = 0u;
+    for (auto group = 0u; group < 2; ++group) {
+        auto lane = group * 4;
+        // signed distance of the center and the radius of the box projected onto the normal
+        auto distance = _mm_loadu_ps(&_planes[3][lane]);
+        auto radius = _mm_setzero_ps();
+        for (auto axis = 0u; axis < 3; ++axis) {
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(&_planes[axis][lane]), centers[axis]));
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_loadu_ps(&_absNormals[axis][lane]), extents[axis]));
+        }
+        outside |= static_cast<unsigned int>(_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()))) << lane;
+        inside |= static_cast<unsigned int>(_mm_movemask_ps(_mm_cmpge_ps(_mm_sub_ps(distance, radius), _mm_setzero_ps()))) << lane;
+    }
+    if ((outside & planeMask) != 0) {
+        return false;
+    }
+    planeMask &= ~inside;
+    return true;
+}
+
+auto Frustum::IntersectAabb(Aabb const& aabb) const -> bool {
+    auto minVertex = aabb.GetMinVertex();
+    auto maxVertex = aabb.GetMaxVertex();
+    auto planeMask = AllPlanes;
+    return IntersectAabb(minVertex.data(), maxVertex.data(), planeMask);
+}
+
+auto Frustum::IntersectSphere(Point4f const& center, Float32 radius) const -> bool {
+    auto x = _mm_set1_ps(center(0));
+    auto y = _mm_set1_ps(center(1));
+    auto z = _mm_set1_ps(center(2));
+    auto negativeRadius = _mm_set1_ps(-radius);
+    auto outside = 0;
+    for (auto lane = 0u; lane < 8; lane += 4) {
+        auto distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&_planes[0][lane]), x), _mm_mul_ps(_mm_loadu_ps(&_planes[1][lane]), y)),
+            _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&_planes[2][lane]), z), _mm_loadu_ps(&_planes[3][lane])));
+        outside |= _mm_movemask_ps(_mm_cmplt_ps(distance, negativeRadius));
+    }
+    return outside == 0;
+}
+
+}
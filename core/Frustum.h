@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include "Primitive.h"
+#include "Matrix.h"
+#include "Aabb.h"
+#include "BvhNode.h"
+#include "BvhBuilder.h"
+
+namespace core {
+
+// View frustum as 6 inward facing planes extracted from a view-projection matrix. A point p is inside
+// plane i if a*x + b*y + c*z + d >= 0. Planes are stored as structure of arrays in 2 groups of 4 lanes,
+// the 2 lanes past the 6th plane are always-inside padding.
+class Frustum {
+public:
+    static constexpr const unsigned int PlaneCount = 6u; // left, right, bottom, top, near, far
+    static constexpr const unsigned int AllPlanes = (1u << PlaneCount) - 1;
+public:
+    Frustum() = default;
+    // viewProjectTransform maps world space to OpenGL clip space, where visible points satisfy -w <= x, y, z <= w
+    explicit Frustum(Matrix4x4f const& viewProjectTransform);
+public:
+    // conservative test, boxes straddling 2 planes outside of the frustum's corner are reported visible.
+    // planeMask holds the planes to test, planes the box is completely inside of are cleared from it
+    // so that children of the box can skip them. Reads 4 floats from both vertexes, the 4th one is ignored.
+    auto IntersectAabb(Float32 const* minVertex, Float32 const* maxVertex, unsigned int & planeMask) const -> bool;
+    auto IntersectAabb(Aabb const& aabb) const -> bool;
+    auto IntersectSphere(Point4f const& center, Float32 radius) const -> bool;
+    auto GetPlane(unsigned int index) const -> Vector4f {
+        return Vector4f{ _planes[0][index], _planes[1][index], _planes[2][index], _planes[3][index] };
+    }
+    // walks a BVH and calls visit(begin, end, planeMask) for every range of primitives whose node intersects
+    // the frustum. planeMask is 0 for ranges completely inside, primitives of those need no further test.
+    // subtrees of nodes intersecting the frustum are skipped if accept(node) returns false.
+    template <typename Visit, typename Accept>
+    auto CullBvh(std::vector<BvhNode> const& nodes, Visit visit, Accept accept) const -> void;
+    template <typename Visit>
+    auto CullBvh(std::vector<BvhNode> const& nodes, Visit visit) const -> void {
+        CullBvh(nodes, visit, [](BvhNode const&) {
+            return true;
+        });
+    }
+private:
+    Float32 _planes[4][8]; // a, b, c, d of every plane
+    Float32 _absNormals[3][8]; // |a|, |b|, |c| to project box extents onto the normals
+};
+
+template <typename Visit, typename Accept>
+auto Frustum::CullBvh(std::vector<BvhNode> const& nodes, Visit visit, Accept accept) const -> void {
+    if (nodes.empty()) {
+        return;
+    }
+    struct Entry {
+        unsigned int nodeIndex;
+        unsigned int planeMask;
+    };
+    Entry stack[BvhBuilder::MaxDepth];
+    auto stackSize = 0u;
+    stack[stackSize++] = Entry{ 0u, AllPlanes };
+    while (stackSize > 0) {
+        auto entry = stack[--stackSize];
+        auto const& node = nodes[entry.nodeIndex];
+        if (!IntersectAabb(node.minVertex, node.maxVertex, entry.planeMask) || !accept(node)) {
+            continue;
+        }
+        if (node.IsLeaf()) {
+            visit(node.offset, node.offset + node.primitiveCount, entry.planeMask);
+        } else if (entry.planeMask == 0) {
+            // the whole subtree is inside, its primitives span from its leftmost leaf to its rightmost one
+            auto first = entry.nodeIndex;
+            while (!nodes[first].IsLeaf()) {
+                ++first;
+            }
+            auto last = entry.nodeIndex;
+            while (!nodes[last].IsLeaf()) {
+                last = nodes[last].offset;
+            }
+            visit(nodes[first].offset, nodes[last].offset + nodes[last].primitiveCount, 0u);
+        } else {
+            stack[stackSize++] = Entry{ node.offset, entry.planeMask };
+            stack[stackSize++] = Entry{ entry.nodeIndex + 1, entry.planeMask };
+        }
+    }
+}
+
+}
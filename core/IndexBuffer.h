@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+#include "Primitive.h"
+#include "Mesh.h"
+
+namespace core {
+
+// Layout of the indexes of many meshes concatenated into one buffer: all 16 bit indexes first, then, 4 byte aligned,
+// all 32 bit ones, so that a renderer binds at most 2 views of the buffer, one per index width.
+struct IndexBufferLayout {
+    struct Entry {
+        IndexFormat format;
+        unsigned int offset; // in indexes from the beginning of the part of the buffer with its format
+    };
+    std::vector<Entry> entries; // one per mesh, in order
+    unsigned int uint16Size = 0u; // bytes of 16 bit indexes, including padding
+    unsigned int uint32Size = 0u; // bytes of 32 bit indexes, which start at uint16Size
+
+    auto GetSize() const -> unsigned int {
+        return uint16Size + uint32Size;
+    }
+    // in bytes from the beginning of the buffer
+    auto GetByteOffset(unsigned int i) const -> unsigned int {
+        return entries[i].format == IndexFormat::Uint16 ? entries[i].offset * sizeof(uint16) : uint16Size + entries[i].offset * sizeof(uint32);
+    }
+};
+
+// meshes are given as a range of pointers, raw or smart
+template <typename Iterator>
+auto LayoutIndexBuffer(Iterator first, Iterator last) -> IndexBufferLayout {
+    auto ret = IndexBufferLayout{};
+    auto uint16Count = 0u;
+    auto uint32Count = 0u;
+    for (auto it = first; it != last; ++it) {
+        auto const format = (*it)->GetIndexFormat();
+        auto & count = format == IndexFormat::Uint16 ? uint16Count : uint32Count;
+        ret.entries.push_back(IndexBufferLayout::Entry{ format, count });
+        count += static_cast<unsigned int>((*it)->GetIndex().size());
+    }
+    ret.uint16Size = (uint16Count * sizeof(uint16) + 3u) & ~3u;
+    ret.uint32Size = uint32Count * sizeof(uint32);
+    return ret;
+}
+
+// dest must hold layout.GetSize() bytes
+template <typename Iterator>
+auto WriteIndexBuffer(Iterator first, Iterator last, IndexBufferLayout const& layout, void * dest) -> void {
+    auto bytes = static_cast<uint8 *>(dest);
+    // clear the padding after the 16 bit part, if there is none the indexes overwrite it
+    if (layout.uint16Size > 0) {
+        bytes[layout.uint16Size - 2] = 0;
+        bytes[layout.uint16Size - 1] = 0;
+    }
+    auto i = 0u;
+    for (auto it = first; it != last; ++it, ++i) {
+        (*it)->WriteIndex(bytes + layout.GetByteOffset(i));
+    }
+}
+
+}
@@ -1,6 +1,13 @@
 #pragma once
 
 #include <array>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <emmintrin.h>
+#if defined(__FMA__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 #include "Primitive.h"
 
 namespace core {
@@ -116,8 +123,92 @@ using Point4f = Matrix<Float32, 4, 1>;
 template<typename T, size_type ROW, size_type COL>
 struct Matrix_traits<Matrix<T, ROW, COL>> {
     using value_type = T;
+    static constexpr const size_type rows = ROW;
+    static constexpr const size_type columns = COL;
 };
 
+// An expression holds evaluated matrices by reference and other expressions by value, so that an expression stored
+// in a variable never refers to a temporary expression destroyed at the end of the statement that built it. Temporary
+// matrices are moved into a MatrixTemporary, which is held by value as well.
+template<typename T>
+struct ExpressionOperand {
+    using type = T const;
+};
+
+template<typename T, size_type ROW, size_type COL>
+struct ExpressionOperand<Matrix<T, ROW, COL>> {
+    using type = Matrix<T, ROW, COL> const&;
+};
+
+template<typename T>
+using Evaluated = Matrix<typename Matrix_traits<T>::value_type, Matrix_traits<T>::rows, Matrix_traits<T>::columns>;
+
+template<typename LHS, typename RHS>
+class MatrixProduct;
+
+// A product reads every element of its operands once per row or column of the result. An operand that is itself a
+// product is evaluated into a temporary once when the outer product is built, rather than re-evaluated element by
+// element, which makes a chain of n products cost O(n) products. Element-wise operands are cheap and stay lazy.
+template<typename T>
+struct ProductOperand : ExpressionOperand<T> {
+};
+
+template<typename LHS, typename RHS>
+struct ProductOperand<MatrixProduct<LHS, RHS>> {
+    using type = Evaluated<MatrixProduct<LHS, RHS>> const;
+};
+
+// a matrix passed to an expression as a temporary, owned by the expression
+template<typename M>
+class MatrixTemporary : public MatrixExpression<MatrixTemporary<M>> {
+public:
+    using value_type = typename M::value_type;
+public:
+    explicit MatrixTemporary(M && matrix)
+        : _matrix(std::move(matrix)) {
+    }
+public:
+    auto operator()(size_type r, size_type c) const -> value_type {
+        return _matrix(r, c);
+    }
+    auto operator()(size_type index) const -> value_type {
+        return _matrix(index);
+    }
+    auto constexpr RowCount() const -> size_type {
+        return _matrix.RowCount();
+    }
+    auto constexpr ColumnCount() const -> size_type {
+        return _matrix.ColumnCount();
+    }
+private:
+    M _matrix;
+};
+
+template<typename M>
+struct Matrix_traits<MatrixTemporary<M>> : Matrix_traits<M> {
+};
+
+template<typename T, size_type ROW, size_type COL>
+auto inline Hold(Matrix<T, ROW, COL> && matrix) {
+    return MatrixTemporary<Matrix<T, ROW, COL>>(std::move(matrix));
+}
+
+// operands of the SSE overloads of operator* below, which are evaluated at once and never refer to their operands
+template<typename LHS, typename RHS>
+struct IsSimdProduct : std::false_type {
+};
+
+template<>
+struct IsSimdProduct<Matrix4x4f, Matrix4x4f> : std::true_type {
+};
+
+template<>
+struct IsSimdProduct<Matrix4x4f, Vector4f> : std::true_type {
+};
+
+template<typename LHS, typename RHS>
+using EnableIfLazyProduct = std::enable_if_t<!IsSimdProduct<LHS, RHS>::value, int>;
+
 template<typename T>
 auto Length(Matrix<T, 4, 1> const& vector) -> T {
     return sqrt(vector(0) * vector(0) + vector(1) * vector(1) + vector(2) * vector(2));
@@ -149,11 +240,13 @@ template<typename LHS, typename RHS>
 class MatrixProduct : public MatrixExpression<MatrixProduct<LHS, RHS>> {
 public:
     using value_type = typename LHS::value_type;
+    using lhs_type = typename ProductOperand<LHS>::type;
+    using rhs_type = typename ProductOperand<RHS>::type;
 
 public:
     MatrixProduct(MatrixExpression<LHS> const& lhs, MatrixExpression<RHS> const& rhs)
-        : _lhs(lhs)
-        , _rhs(rhs) {
+        : _lhs(static_cast<LHS const&>(lhs))
+        , _rhs(static_cast<RHS const&>(rhs)) {
         assert(lhs.ColumnCount() == rhs.RowCount());
     }
 
@@ -180,13 +273,15 @@ public:
     }
 
 private:
-    MatrixExpression<LHS> const& _lhs;
-    MatrixExpression<RHS> const& _rhs;
+    lhs_type _lhs;
+    rhs_type _rhs;
 };
 
 template<typename LHS, typename RHS>
 struct Matrix_traits<MatrixProduct<LHS, RHS>> {
     using value_type = typename LHS::value_type;
+    static constexpr const size_type rows = Matrix_traits<LHS>::rows;
+    static constexpr const size_type columns = Matrix_traits<RHS>::columns;
 };
 
 template<typename LHS, typename RHS>
@@ -194,14 +289,30 @@ auto inline operator*(MatrixExpression<LHS> const& lhs, MatrixExpression<RHS> co
     return MatrixProduct<LHS, RHS>(lhs, rhs);
 }
 
+template<typename T, size_type ROW, size_type COL, typename RHS, EnableIfLazyProduct<Matrix<T, ROW, COL>, RHS> = 0>
+auto inline operator*(Matrix<T, ROW, COL> && lhs, MatrixExpression<RHS> const& rhs) {
+    return Hold(std::move(lhs)) * rhs;
+}
+
+template<typename LHS, typename T, size_type ROW, size_type COL, EnableIfLazyProduct<LHS, Matrix<T, ROW, COL>> = 0>
+auto inline operator*(MatrixExpression<LHS> const& lhs, Matrix<T, ROW, COL> && rhs) {
+    return lhs * Hold(std::move(rhs));
+}
+
+template<typename T, size_type ROW, size_type COL, size_type COL2, EnableIfLazyProduct<Matrix<T, ROW, COL>, Matrix<T, COL, COL2>> = 0>
+auto inline operator*(Matrix<T, ROW, COL> && lhs, Matrix<T, COL, COL2> && rhs) {
+    return Hold(std::move(lhs)) * Hold(std::move(rhs));
+}
+
 // Matrix Transpose
 template <typename T>
 class MatrixTranspose : public MatrixExpression<MatrixTranspose<T>> {
 public:
     using value_type = typename T::value_type;
+    using operand_type = typename ExpressionOperand<T>::type;
 public:
     MatrixTranspose(MatrixExpression<T> const& matrix)
-        : _matrix(matrix) {
+        : _matrix(static_cast<T const&>(matrix)) {
     }
 public:
     auto operator()(size_type r, size_type c) const -> value_type {
@@ -219,12 +330,14 @@ public:
         return _matrix.ColumnCount();
     }
 private:
-    MatrixExpression<T> const& _matrix;
+    operand_type _matrix;
 };
 
 template <typename T>
 struct Matrix_traits<MatrixTranspose<T>> {
     using value_type = typename T::value_type;
+    static constexpr const size_type rows = Matrix_traits<T>::columns;
+    static constexpr const size_type columns = Matrix_traits<T>::rows;
 };
 
 template <typename T>
@@ -232,14 +345,20 @@ auto inline Transpose(MatrixExpression<T> const& e) {
     return MatrixTranspose<T>(e);
 }
 
+template <typename T, size_type ROW, size_type COL>
+auto inline Transpose(Matrix<T, ROW, COL> && matrix) {
+    return Transpose(Hold(std::move(matrix)));
+}
+
 // Matrix Negate
 template <typename T>
 class MatrixNegate : public MatrixExpression<MatrixNegate<T>> {
 public:
     using value_type = typename T::value_type;
+    using operand_type = typename ExpressionOperand<T>::type;
 public:
     MatrixNegate(MatrixExpression<T> const& matrix)
-        : _matrix(matrix) {
+        : _matrix(static_cast<T const&>(matrix)) {
     }
 public:
     auto operator()(size_type r, size_type c) const -> value_type {
@@ -258,12 +377,14 @@ public:
         return _matrix.RowCount();
     }
 private:
-    MatrixExpression<T> const& _matrix;
+    operand_type _matrix;
 };
 
 template<typename T>
 struct Matrix_traits<MatrixNegate<T>> {
     using value_type = typename T::value_type;
+    static constexpr const size_type rows = Matrix_traits<T>::rows;
+    static constexpr const size_type columns = Matrix_traits<T>::columns;
 };
 
 template<typename T>
@@ -271,14 +392,20 @@ auto inline operator-(MatrixExpression<T> const& expression) {
     return MatrixNegate<T>(expression);
 }
 
+template<typename T, size_type ROW, size_type COL>
+auto inline operator-(Matrix<T, ROW, COL> && matrix) {
+    return -Hold(std::move(matrix));
+}
+
 // Matrix multiply scalar
 template <typename T>
 class MatrixScalarMultiply : public MatrixExpression<MatrixScalarMultiply<T>> {
 public:
     using value_type = typename T::value_type;
+    using operand_type = typename ExpressionOperand<T>::type;
 public:
     MatrixScalarMultiply(MatrixExpression<T> const& matrix, value_type scalar)
-        : _matrix(matrix)
+        : _matrix(static_cast<T const&>(matrix))
         , _scalar(scalar) {
     }
 public:
@@ -298,13 +425,15 @@ public:
         return _matrix.RowCount();
     }
 private:
-    MatrixExpression<T> const& _matrix;
+    operand_type _matrix;
     value_type _scalar;
 };
 
 template<typename T>
 struct Matrix_traits<MatrixScalarMultiply<T>> {
     using value_type = typename T::value_type;
+    static constexpr const size_type rows = Matrix_traits<T>::rows;
+    static constexpr const size_type columns = Matrix_traits<T>::columns;
 };
 
 template<typename T>
@@ -322,15 +451,32 @@ auto inline operator*(typename T::value_type scalar, MatrixExpression<T> const&
     return MatrixScalarMultiply<T>(expression, scalar);
 }
 
+template<typename T, size_type ROW, size_type COL>
+auto inline operator*(Matrix<T, ROW, COL> && matrix, typename Matrix<T, ROW, COL>::value_type scalar) {
+    return Hold(std::move(matrix)) * scalar;
+}
+
+template<typename T, size_type ROW, size_type COL>
+auto inline operator/(Matrix<T, ROW, COL> && matrix, typename Matrix<T, ROW, COL>::value_type scalar) {
+    return Hold(std::move(matrix)) / scalar;
+}
+
+template<typename T, size_type ROW, size_type COL>
+auto inline operator*(typename Matrix<T, ROW, COL>::value_type scalar, Matrix<T, ROW, COL> && matrix) {
+    return scalar * Hold(std::move(matrix));
+}
+
 // Matrix add
 template <typename LHS, typename RHS>
 class MatrixAdd : public MatrixExpression<MatrixAdd<LHS, RHS>> {
 public:
     using value_type = typename LHS::value_type;
+    using lhs_type = typename ExpressionOperand<LHS>::type;
+    using rhs_type = typename ExpressionOperand<RHS>::type;
 public:
     MatrixAdd(MatrixExpression<LHS> const& lhs, MatrixExpression<RHS> const& rhs)
-        : _lhs(lhs)
-        , _rhs(rhs) {
+        : _lhs(static_cast<LHS const&>(lhs))
+        , _rhs(static_cast<RHS const&>(rhs)) {
     }
 public:
     auto operator()(size_type r, size_type c) const -> value_type {
@@ -349,13 +495,15 @@ public:
         return _rhs.ColumnCount();
     }
 private:
-    MatrixExpression<LHS> const& _lhs;
-    MatrixExpression<RHS> const& _rhs;
+    lhs_type _lhs;
+    rhs_type _rhs;
 };
 
 template <typename LHS, typename RHS>
 struct Matrix_traits<MatrixAdd<LHS, RHS>> {
     using value_type = typename LHS::value_type;
+    static constexpr const size_type rows = Matrix_traits<LHS>::rows;
+    static constexpr const size_type columns = Matrix_traits<RHS>::columns;
 };
 
 template<typename LHS, typename RHS>
@@ -363,15 +511,32 @@ auto inline operator+(MatrixExpression<LHS> const& lhs, MatrixExpression<RHS> co
     return MatrixAdd<LHS, RHS>(lhs, rhs);
 }
 
+template<typename T, size_type ROW, size_type COL, typename RHS>
+auto inline operator+(Matrix<T, ROW, COL> && lhs, MatrixExpression<RHS> const& rhs) {
+    return Hold(std::move(lhs)) + rhs;
+}
+
+template<typename LHS, typename T, size_type ROW, size_type COL>
+auto inline operator+(MatrixExpression<LHS> const& lhs, Matrix<T, ROW, COL> && rhs) {
+    return lhs + Hold(std::move(rhs));
+}
+
+template<typename T, size_type ROW, size_type COL>
+auto inline operator+(Matrix<T, ROW, COL> && lhs, Matrix<T, ROW, COL> && rhs) {
+    return Hold(std::move(lhs)) + Hold(std::move(rhs));
+}
+
 // Matrix subtract
 template <typename LHS, typename RHS>
 class MatrixSubtract : public MatrixExpression<MatrixSubtract<LHS, RHS>> {
 public:
     using value_type = typename LHS::value_type;
+    using lhs_type = typename ExpressionOperand<LHS>::type;
+    using rhs_type = typename ExpressionOperand<RHS>::type;
 public:
     MatrixSubtract(MatrixExpression<LHS> const& lhs, MatrixExpression<RHS> const& rhs)
-        : _lhs(lhs)
-        , _rhs(rhs) {
+        : _lhs(static_cast<LHS const&>(lhs))
+        , _rhs(static_cast<RHS const&>(rhs)) {
     }
 public:
     auto operator()(size_type r, size_type c) const -> value_type {
@@ -390,13 +555,15 @@ public:
         return _rhs.ColumnCount();
     }
 private:
-    MatrixExpression<LHS> const& _lhs;
-    MatrixExpression<RHS> const& _rhs;
+    lhs_type _lhs;
+    rhs_type _rhs;
 };
 
 template <typename LHS, typename RHS>
 struct Matrix_traits<MatrixSubtract<LHS, RHS>> {
     using value_type = typename LHS::value_type;
+    static constexpr const size_type rows = Matrix_traits<LHS>::rows;
+    static constexpr const size_type columns = Matrix_traits<RHS>::columns;
 };
 
 template<typename LHS, typename RHS>
@@ -404,15 +571,31 @@ auto inline operator-(MatrixExpression<LHS> const& lhs, MatrixExpression<RHS> co
     return MatrixSubtract<LHS, RHS>(lhs, rhs);
 }
 
+template<typename T, size_type ROW, size_type COL, typename RHS>
+auto inline operator-(Matrix<T, ROW, COL> && lhs, MatrixExpression<RHS> const& rhs) {
+    return Hold(std::move(lhs)) - rhs;
+}
+
+template<typename LHS, typename T, size_type ROW, size_type COL>
+auto inline operator-(MatrixExpression<LHS> const& lhs, Matrix<T, ROW, COL> && rhs) {
+    return lhs - Hold(std::move(rhs));
+}
+
+template<typename T, size_type ROW, size_type COL>
+auto inline operator-(Matrix<T, ROW, COL> && lhs, Matrix<T, ROW, COL> && rhs) {
+    return Hold(std::move(lhs)) - Hold(std::move(rhs));
+}
+
 // 3-dimention vector cross product
 template<typename T>
 class VectorCrossProduct : public MatrixExpression<VectorCrossProduct<T>> {
 public:
     using value_type = typename T::value_type;
+    using operand_type = typename ExpressionOperand<T>::type;
 public:
     VectorCrossProduct(MatrixExpression<T> const& lhs, MatrixExpression<T> const& rhs)
-        : _lhs(lhs)
-        , _rhs(rhs) {
+        : _lhs(static_cast<T const&>(lhs))
+        , _rhs(static_cast<T const&>(rhs)) {
         assert(_lhs.ColumnCount() == 1);
         assert(_lhs.RowCount() == 3 || _lhs.RowCount() == 4);
         assert(_rhs.ColumnCount() == 1);
@@ -437,7 +620,7 @@ public:
     auto operator()(size_type index) const -> value_type {
         auto r = index / ColumnCount();
         auto c = index % ColumnCount();
-        return operator()(r, c)
+        return operator()(r, c);
     }
     auto constexpr RowCount() const -> size_type {
         return _lhs.RowCount();
@@ -446,13 +629,15 @@ public:
         return _lhs.ColumnCount();
     }
 private:
-    MatrixExpression<T> const& _lhs;
-    MatrixExpression<T> const& _rhs;
+    operand_type _lhs;
+    operand_type _rhs;
 };
 
 template <typename T>
 struct Matrix_traits<VectorCrossProduct<T>> {
     using value_type = typename T::value_type;
+    static constexpr const size_type rows = Matrix_traits<T>::rows;
+    static constexpr const size_type columns = 1;
 };
 
 template<typename T>
@@ -460,5 +645,159 @@ auto inline CrossProduct(MatrixExpression<T> const& lhs, MatrixExpression<T> con
     return VectorCrossProduct<T>(lhs, rhs);
 }
 
+// both operands have to be of the same type, the one that is not a temporary is copied
+template<typename T, size_type ROW>
+auto inline CrossProduct(Matrix<T, ROW, 1> && lhs, Matrix<T, ROW, 1> const& rhs) {
+    return CrossProduct(Hold(std::move(lhs)), Hold(Matrix<T, ROW, 1>(rhs)));
+}
+
+template<typename T, size_type ROW>
+auto inline CrossProduct(Matrix<T, ROW, 1> const& lhs, Matrix<T, ROW, 1> && rhs) {
+    return CrossProduct(Hold(Matrix<T, ROW, 1>(lhs)), Hold(std::move(rhs)));
+}
+
+template<typename T, size_type ROW>
+auto inline CrossProduct(Matrix<T, ROW, 1> && lhs, Matrix<T, ROW, 1> && rhs) {
+    return CrossProduct(Hold(std::move(lhs)), Hold(std::move(rhs)));
+}
+
+// 4x4 products evaluated at once with SSE rather than lazily element by element. Being non-template overloads they
+// are preferred over MatrixProduct whenever both operands are evaluated matrices, which also makes chains like
+// a * b * c evaluate every product once. Terms are summed in the same order as MatrixProduct, so results are the
+// same bit for bit unless fused multiply-add is enabled, which rounds once per term instead of twice.
+// Rows are loaded unaligned, matrices live in containers whose allocations are only 8-byte aligned on Win32.
+auto inline MultiplyAdd(__m128 a, __m128 b, __m128 c) -> __m128 {
+#if defined(__FMA__) || defined(__AVX2__)
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+auto inline operator*(Matrix4x4f const& lhs, Matrix4x4f const& rhs) -> Matrix4x4f {
+    __m128 rhsRows[4];
+    for (auto i = 0u; i < 4; ++i) {
+        rhsRows[i] = _mm_loadu_ps(rhs.data() + i * 4);
+    }
+    auto ret = Matrix4x4f{};
+    for (auto i = 0u; i < 4; ++i) {
+        // row i of the product is row i of lhs linearly combining rows of rhs
+        auto const* lhsRow = lhs.data() + i * 4;
+        auto row = _mm_mul_ps(_mm_set1_ps(lhsRow[0]), rhsRows[0]);
+        row = MultiplyAdd(_mm_set1_ps(lhsRow[1]), rhsRows[1], row);
+        row = MultiplyAdd(_mm_set1_ps(lhsRow[2]), rhsRows[2], row);
+        row = MultiplyAdd(_mm_set1_ps(lhsRow[3]), rhsRows[3], row);
+        _mm_storeu_ps(ret.data() + i * 4, row);
+    }
+    return ret;
+}
+
+auto inline operator*(Matrix4x4f const& lhs, Vector4f const& rhs) -> Vector4f {
+    // columns of lhs linearly combined by rhs
+    auto column0 = _mm_loadu_ps(lhs.data());
+    auto column1 = _mm_loadu_ps(lhs.data() + 4);
+    auto column2 = _mm_loadu_ps(lhs.data() + 8);
+    auto column3 = _mm_loadu_ps(lhs.data() + 12);
+    _MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+    auto product = _mm_mul_ps(column0, _mm_set1_ps(rhs(0)));
+    product = MultiplyAdd(column1, _mm_set1_ps(rhs(1)), product);
+    product = MultiplyAdd(column2, _mm_set1_ps(rhs(2)), product);
+    product = MultiplyAdd(column3, _mm_set1_ps(rhs(3)), product);
+    auto ret = Vector4f{};
+    _mm_storeu_ps(ret.data(), product);
+    return ret;
+}
+
+// lanes of v picked by index, Swizzle<1, 0, 3, 2>(v) is (v1, v0, v3, v2)
+template<int X, int Y, int Z, int W>
+auto inline Swizzle(__m128 v) -> __m128 {
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X));
+}
+
+// General inverse by Gauss-Jordan elimination with partial pivoting, every row of the matrix and the same row of the
+// identity, which becomes the inverse, in a register each. Pivoting keeps it accurate for ill-conditioned matrices,
+// where cofactor expansion loses most of the digits. Infinite or NaN elements if the matrix is singular.
+auto inline Inverse(Matrix4x4f const& matrix) -> Matrix4x4f {
+    __m128 left[4];
+    __m128 right[4];
+    for (auto i = 0u; i < 4; ++i) {
+        left[i] = _mm_loadu_ps(matrix.data() + i * 4);
+    }
+    right[0] = _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    right[1] = _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f);
+    right[2] = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+    right[3] = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    for (auto k = 0u; k < 4; ++k) {
+        Float32 rows[4][4];
+        auto pivot = k;
+        for (auto i = k; i < 4; ++i) {
+            _mm_storeu_ps(rows[i], left[i]);
+            pivot = std::abs(rows[i][k]) > std::abs(rows[pivot][k]) ? i : pivot;
+        }
+        std::swap(left[k], left[pivot]);
+        std::swap(right[k], right[pivot]);
+        auto pivotInverse = _mm_set1_ps(1.0f / rows[pivot][k]);
+        left[k] = _mm_mul_ps(left[k], pivotInverse);
+        right[k] = _mm_mul_ps(right[k], pivotInverse);
+        for (auto i = 0u; i < 4; ++i) {
+            if (i == k) {
+                continue;
+            }
+            Float32 row[4];
+            _mm_storeu_ps(row, left[i]);
+            auto factor = _mm_set1_ps(row[k]);
+            left[i] = _mm_sub_ps(left[i], _mm_mul_ps(factor, left[k]));
+            right[i] = _mm_sub_ps(right[i], _mm_mul_ps(factor, right[k]));
+        }
+    }
+    auto ret = Matrix4x4f{};
+    for (auto i = 0u; i < 4; ++i) {
+        _mm_storeu_ps(ret.data() + i * 4, right[i]);
+    }
+    return ret;
+}
+
+// inverse of rotation followed by translation: transposed rotation and negated translation rotated back
+auto inline RigidBodyInverse(Matrix4x4f const& matrix) -> Matrix4x4f {
+    auto row0 = _mm_loadu_ps(matrix.data());
+    auto row1 = _mm_loadu_ps(matrix.data() + 4);
+    auto row2 = _mm_loadu_ps(matrix.data() + 8);
+    // rows of the rotation linearly combined by the translation, lane 3 is garbage
+    auto translation = _mm_mul_ps(row0, Swizzle<3, 3, 3, 3>(row0));
+    translation = MultiplyAdd(row1, Swizzle<3, 3, 3, 3>(row1), translation);
+    translation = MultiplyAdd(row2, Swizzle<3, 3, 3, 3>(row2), translation);
+    translation = _mm_sub_ps(_mm_setzero_ps(), translation);
+    _MM_TRANSPOSE4_PS(row0, row1, row2, translation);
+    auto ret = Matrix4x4f{};
+    _mm_storeu_ps(ret.data(), row0);
+    _mm_storeu_ps(ret.data() + 4, row1);
+    _mm_storeu_ps(ret.data() + 8, row2);
+    return ret;
+}
+
+// transpose of the inverse of the upper-left 3x3, which transforms normals, in a 4x4 matrix without translation.
+// Rows of the result are cross products of rows of the matrix divided by the determinant.
+auto inline InverseTranspose3x3(Matrix4x4f const& matrix) -> Matrix4x4f {
+    auto const mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    auto row0 = _mm_and_ps(_mm_loadu_ps(matrix.data()), mask);
+    auto row1 = _mm_and_ps(_mm_loadu_ps(matrix.data() + 4), mask);
+    auto row2 = _mm_and_ps(_mm_loadu_ps(matrix.data() + 8), mask);
+    auto cross = [](__m128 u, __m128 v) {
+        return _mm_sub_ps(_mm_mul_ps(Swizzle<1, 2, 0, 3>(u), Swizzle<2, 0, 1, 3>(v)), _mm_mul_ps(Swizzle<2, 0, 1, 3>(u), Swizzle<1, 2, 0, 3>(v)));
+    };
+    auto cofactor0 = cross(row1, row2);
+    auto cofactor1 = cross(row2, row0);
+    auto cofactor2 = cross(row0, row1);
+    auto determinant = _mm_mul_ps(row0, cofactor0);
+    determinant = _mm_add_ps(determinant, Swizzle<2, 3, 0, 1>(determinant));
+    determinant = _mm_add_ps(determinant, Swizzle<1, 0, 3, 2>(determinant));
+    auto determinantInverse = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+    auto ret = Matrix4x4f{};
+    _mm_storeu_ps(ret.data(), _mm_mul_ps(cofactor0, determinantInverse));
+    _mm_storeu_ps(ret.data() + 4, _mm_mul_ps(cofactor1, determinantInverse));
+    _mm_storeu_ps(ret.data() + 8, _mm_mul_ps(cofactor2, determinantInverse));
+    return ret;
+}
+
 
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstring>
 #include <vector>
 #include <memory>
 
@@ -8,6 +9,12 @@
 
 namespace core {
 
+// width of the indexes uploaded for a mesh; indexes are kept as 32 bit on the CPU
+enum class IndexFormat {
+    Uint16,
+    Uint32,
+};
+
 template <typename T>
 class Mesh {
 public:
@@ -19,6 +26,7 @@ public:
         openglUint _vao;
         openglUint _indexOffset;
         openglInt _baseVertex;
+        openglEnum _indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
     };
     static auto MakeMesh(Float32 * vertexData, unsigned int vertexDataCount, unsigned int * index, unsigned int indexCount) -> void {
         auto ret = Mesh{};
@@ -28,6 +36,8 @@ public:
     friend void swap(Mesh& first, Mesh& second) {
         using std::swap;
         swap(first._vertexes, second._vertexes);
+        swap(first._index, second._index);
+        swap(first._indexFormat, second._indexFormat);
         swap(first._renderData, second._renderData);
     }
     Mesh(DrawMode drawMode = triangles)
@@ -36,12 +46,14 @@ public:
     Mesh(std::vector<T> && vertexData, std::vector<unsigned int> && index)
         : _vertexes(move(vertexData))
         , _index(move(index)) {
+        UpdateIndexFormat();
     }
     Mesh(std::vector<Float32> const& vertexData, std::vector<unsigned int> && index)
         : _index(move(index)) {
         auto vertexCount = vertexData.size() * sizeof(Float32) / sizeof(T);
         _vertexes = std::vector<T>(vertexCount);
         memcpy(_vertexes.data(), vertexData.data(), vertexData.size() * sizeof(Float32));
+        UpdateIndexFormat();
     }
     Mesh(std::vector<T> && vertexData)
         : _vertexes(move(vertexData)) {
@@ -49,6 +61,7 @@ public:
         for (auto i = 0u; i < _vertexes.size(); ++i) {
             _index[i] = i;
         }
+        UpdateIndexFormat();
     }
     Mesh(Mesh&& other)
         : Mesh() {
@@ -70,6 +83,30 @@ public:
     auto GetIndex() const -> std::vector<unsigned int> const& {
         return _index;
     }
+    // replaces the geometry, e.g. with the same triangles reordered for rendering
+    auto SetData(std::vector<T> && vertexData, std::vector<unsigned int> && index) -> void {
+        _vertexes = move(vertexData);
+        _index = move(index);
+        UpdateIndexFormat();
+    }
+    auto GetIndexFormat() const -> IndexFormat {
+        return _indexFormat;
+    }
+    // bytes per uploaded index
+    auto GetIndexSize() const -> unsigned int {
+        return _indexFormat == IndexFormat::Uint16 ? sizeof(uint16) : sizeof(uint32);
+    }
+    // writes GetIndex().size() indexes of GetIndexSize() bytes each
+    auto WriteIndex(void * dest) const -> void {
+        if (_indexFormat == IndexFormat::Uint32) {
+            memcpy(dest, _index.data(), _index.size() * sizeof(uint32));
+            return;
+        }
+        auto narrow = static_cast<uint16 *>(dest);
+        for (auto i = 0u; i < _index.size(); ++i) {
+            narrow[i] = static_cast<uint16>(_index[i]);
+        }
+    }
     auto GetRenderData() const -> RenderData const& {
         return _renderData;
     }
@@ -82,9 +119,21 @@ public:
     auto SetRenderDataId(unsigned int id) -> void {
         _renderDataId = id;
     }
+private:
+    // 16 bit if every index fits, which is checked once whenever the geometry is set
+    auto UpdateIndexFormat() -> void {
+        _indexFormat = IndexFormat::Uint16;
+        for (auto i : _index) {
+            if (i > 0xffffu) {
+                _indexFormat = IndexFormat::Uint32;
+                return;
+            }
+        }
+    }
 private:
     std::vector<T> _vertexes;
     std::vector<unsigned int> _index;
+    IndexFormat _indexFormat = IndexFormat::Uint16;
     DrawMode _drawMode;
 
     RenderData _renderData;
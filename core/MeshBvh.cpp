@@ -0,0 +1,113 @@
+#include "MeshBvh.h"
+
+#include <algorithm>
+
+using std::vector;
+using std::array;
+
+namespace core {
+
+MeshBvh::MeshBvh(Mesh<Vertex> const& mesh, unsigned int threadCount) {
+    auto const& vertex = mesh.GetVertex();
+    auto const& index = mesh.GetIndex();
+    auto const triangleCount = static_cast<unsigned int>(index.size() / 3);
+
+    auto triangles = vector<array<Point4f, 3>>{};
+    auto primitives = vector<BvhBuilder::Primitive>{};
+    triangles.reserve(triangleCount);
+    primitives.reserve(triangleCount);
+    for (auto i = 0u; i < triangleCount; ++i) {
+        auto triangle = array<Point4f, 3>{};
+        auto aabb = Aabb{};
+        for (auto j = 0u; j < 3; ++j) {
+            auto const& coord = vertex[index[i * 3 + j]].coord;
+            triangle[j] = Point4f{ coord(0), coord(1), coord(2), 1.0f };
+            aabb.Expand(triangle[j]);
+        }
+        triangles.push_back(triangle);
+        primitives.push_back(BvhBuilder::Primitive{ aabb.GetMinVertex(), aabb.GetMaxVertex(), aabb.GetCenter() });
+    }
+    auto builder = BvhBuilder{ BvhBuilder::SplitMethod::Sah, MaxLeafTriangleCount, threadCount, TriangleBlock::Size };
+    builder.Build(primitives);
+    _nodes = builder.AcquireNodes();
+
+    _triangleCount = triangleCount;
+
+    // store triangles in leaf order so that leaves reference them directly, aligned to blocks
+    auto primitiveIndex = builder.AcquirePrimitiveIndex();
+    for (auto & node : _nodes) {
+        if (!node.IsLeaf()) {
+            continue;
+        }
+        auto first = node.offset;
+        node.offset = static_cast<uint32>(_triangles.size());
+        for (auto i = first; i < first + node.primitiveCount; ++i) {
+            _triangles.push_back(triangles[primitiveIndex[i]]);
+            _triangleIndex.push_back(primitiveIndex[i]);
+        }
+        while (_triangles.size() % TriangleBlock::Size != 0) {
+            _triangles.push_back(_triangles.back());
+            _triangleIndex.push_back(_triangleIndex.back());
+        }
+    }
+    _triangleBlocks.resize(_triangles.size() / TriangleBlock::Size);
+    for (auto i = 0u; i < _triangles.size(); ++i) {
+        auto & block = _triangleBlocks[i / TriangleBlock::Size];
+        auto lane = i % TriangleBlock::Size;
+        auto const& triangle = _triangles[i];
+        for (auto axis = 0u; axis < 3; ++axis) {
+            block.p0[axis][lane] = triangle[0](axis);
+            block.e1[axis][lane] = triangle[1](axis) - triangle[0](axis);
+            block.e2[axis][lane] = triangle[2](axis) - triangle[0](axis);
+        }
+    }
+}
+
+auto MeshBvh::GetAabb() const -> Aabb {
+    return _nodes.empty() ? Aabb{} : _nodes.front().GetAabb();
+}
+
+auto MeshBvh::IntersectRay(Ray const& ray, unsigned int & triangleIndex, Float32 & u, Float32 & v) const -> Float32 {
+    auto ret = -1.0f;
+    if (_nodes.empty()) {
+        return ret;
+    }
+    auto slabRay = SlabRay{ ray };
+    auto const rayLanes = RayLanes{ ray };
+    auto nodeStack = array<unsigned int, MaxDepth>{};
+    auto stackSize = 0u;
+    nodeStack[stackSize++] = 0u;
+    while (stackSize > 0) {
+        auto nodeIndex = nodeStack[--stackSize];
+        auto const& node = _nodes[nodeIndex];
+        if (node.IntersectRay(slabRay) < 0) {
+            continue;
+        }
+        if (!node.IsLeaf()) {
+            auto nearChild = 0u;
+            auto farChild = 0u;
+            node.GetOrderedChildren(nodeIndex, slabRay, nearChild, farChild);
+            nodeStack[stackSize++] = farChild;
+            nodeStack[stackSize++] = nearChild;
+            continue;
+        }
+        auto const leafEnd = node.offset + node.primitiveCount;
+        for (auto first = node.offset; first < leafEnd; first += TriangleBlock::Size) {
+            auto lane = 0u;
+            auto triangleU = 0.0f;
+            auto triangleV = 0.0f;
+            auto count = std::min(TriangleBlock::Size, leafEnd - first);
+            auto distance = Triangle::IntersectRay4(rayLanes, slabRay.length, _triangleBlocks[first / TriangleBlock::Size], count, lane, triangleU, triangleV);
+            if (distance > 0 && (ret < 0 || distance < ret)) {
+                ret = distance;
+                slabRay.length = distance;
+                triangleIndex = _triangleIndex[first + lane];
+                u = triangleU;
+                v = triangleV;
+            }
+        }
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <array>
+
+#include "BvhNode.h"
+#include "BvhBuilder.h"
+#include "Mesh.h"
+#include "Ray.h"
+#include "Triangle.h"
+
+namespace core {
+
+// Bottom-level BVH over the triangles of one mesh, in mesh-local space. Shared by every shape using the mesh.
+class MeshBvh {
+    static constexpr const unsigned int MaxLeafTriangleCount = 4u;
+public:
+    static constexpr const unsigned int MaxDepth = BvhBuilder::MaxDepth;
+public:
+    explicit MeshBvh(Mesh<Vertex> const& mesh, unsigned int threadCount = 1u);
+public:
+    auto GetNodes() const -> std::vector<BvhNode> const& {
+        return _nodes;
+    }
+    auto GetTriangleBlocks() const -> std::vector<TriangleBlock> const& {
+        return _triangleBlocks;
+    }
+    auto GetTriangleIndex() const -> std::vector<unsigned int> const& {
+        return _triangleIndex;
+    }
+    auto GetTriangleCount() const -> unsigned int {
+        return _triangleCount;
+    }
+    auto GetAabb() const -> Aabb;
+    // nearest intersection within ray.length, ray in mesh-local space. returns -1 if missed.
+    // nodes are visited front to back and every hit shortens the ray, so farther nodes are skipped.
+    // u and v are barycentric coordinates of the hit point on the triangle.
+    auto IntersectRay(Ray const& ray, unsigned int & triangleIndex, Float32 & u, Float32 & v) const -> Float32;
+    // calls f(triangle, triangleIndex) for triangles of every leaf overlapping aabb (mesh-local space) until f returns true.
+    template<typename F>
+    auto ForEachTriangle(Aabb const& aabb, F && f) const -> bool;
+private:
+    std::vector<BvhNode> _nodes;
+    // triangles in leaf order, every leaf starts at a multiple of TriangleBlock::Size and is padded up to the next one
+    std::vector<std::array<Point4f, 3>> _triangles; // mesh-local vertexes
+    std::vector<TriangleBlock> _triangleBlocks; // _triangles as structure of arrays for the ray test
+    std::vector<unsigned int> _triangleIndex; // index of triangle in mesh
+    unsigned int _triangleCount = 0u;
+};
+
+template<typename F>
+auto MeshBvh::ForEachTriangle(Aabb const& aabb, F && f) const -> bool {
+    if (_nodes.empty()) {
+        return false;
+    }
+    auto nodeStack = std::array<unsigned int, MaxDepth>{};
+    auto stackSize = 0u;
+    nodeStack[stackSize++] = 0u;
+    while (stackSize > 0) {
+        auto nodeIndex = nodeStack[--stackSize];
+        auto const& node = _nodes[nodeIndex];
+        if (!node.IntersectAabb(aabb)) {
+            continue;
+        }
+        if (!node.IsLeaf()) {
+            nodeStack[stackSize++] = node.offset;
+            nodeStack[stackSize++] = nodeIndex + 1;
+            continue;
+        }
+        for (auto i = node.offset; i < node.offset + node.primitiveCount; ++i) {
+            if (f(_triangles[i], _triangleIndex[i])) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+}
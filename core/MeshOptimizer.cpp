@@ -0,0 +1,239 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using std::vector;
+
+namespace core {
+
+namespace {
+
+auto TriangleNormal(Vector3f const& a, Vector3f const& b, Vector3f const& c) -> Vector3f {
+    auto e1 = Vector3f{ b(0) - a(0), b(1) - a(1), b(2) - a(2) };
+    auto e2 = Vector3f{ c(0) - a(0), c(1) - a(1), c(2) - a(2) };
+    // length is twice the area
+    return Vector3f{
+        e1(1) * e2(2) - e1(2) * e2(1),
+        e1(2) * e2(0) - e1(0) * e2(2),
+        e1(0) * e2(1) - e1(1) * e2(0),
+    };
+}
+
+}
+
+auto ComputeVertexCacheStatistics(std::vector<unsigned int> const& index, unsigned int cacheSize) -> VertexCacheStatistics {
+    if (index.size() < 3) {
+        return VertexCacheStatistics{ 0.0f, 0.0f };
+    }
+    auto const vertexCount = *std::max_element(index.cbegin(), index.cend()) + 1;
+    // a vertex is in the FIFO cache if fewer than cacheSize misses happened since it was inserted
+    auto insertedAt = vector<unsigned int>(vertexCount, 0u);
+    auto used = vector<bool>(vertexCount, false);
+    auto missCount = cacheSize + 1;
+    auto usedCount = 0u;
+    for (auto v : index) {
+        if (missCount - insertedAt[v] > cacheSize) {
+            insertedAt[v] = missCount++;
+        }
+        if (!used[v]) {
+            used[v] = true;
+            ++usedCount;
+        }
+    }
+    auto const transformed = static_cast<Float32>(missCount - cacheSize - 1);
+    return VertexCacheStatistics{ transformed / (index.size() / 3), transformed / usedCount };
+}
+
+auto OptimizeVertexCache(std::vector<unsigned int> const& index, unsigned int vertexCount, unsigned int cacheSize, std::vector<unsigned int> * clusterBegins) -> std::vector<unsigned int> {
+    auto const triangleCount = static_cast<unsigned int>(index.size() / 3);
+    // triangles adjacent to every vertex
+    auto adjacencyBegins = vector<unsigned int>(vertexCount + 1, 0u);
+    for (auto v : index) {
+        ++adjacencyBegins[v + 1];
+    }
+    std::partial_sum(adjacencyBegins.cbegin(), adjacencyBegins.cend(), adjacencyBegins.begin());
+    auto adjacency = vector<unsigned int>(index.size());
+    auto next = vector<unsigned int>(adjacencyBegins.cbegin(), adjacencyBegins.cend() - 1);
+    for (auto i = 0u; i < index.size(); ++i) {
+        adjacency[next[index[i]]++] = i / 3;
+    }
+
+    auto liveTriangles = vector<unsigned int>(vertexCount);
+    for (auto v = 0u; v < vertexCount; ++v) {
+        liveTriangles[v] = adjacencyBegins[v + 1] - adjacencyBegins[v];
+    }
+    auto cacheTime = vector<unsigned int>(vertexCount, 0u);
+    auto emitted = vector<bool>(triangleCount, false);
+    auto deadEnds = vector<unsigned int>{};
+    auto candidates = vector<unsigned int>{};
+    auto ret = vector<unsigned int>{};
+    ret.reserve(triangleCount * 3);
+    auto time = cacheSize + 1;
+    auto cursor = 0u;
+    auto const none = vertexCount;
+    auto fanning = none;
+    // the next vertex in input order with live triangles, used when there is no candidate and no dead end left
+    auto nextInOrder = [&]() {
+        while (cursor < vertexCount && liveTriangles[cursor] == 0) {
+            ++cursor;
+        }
+        return cursor < vertexCount ? cursor : none;
+    };
+    fanning = nextInOrder();
+    while (fanning != none) {
+        candidates.clear();
+        for (auto a = adjacencyBegins[fanning]; a < adjacencyBegins[fanning + 1]; ++a) {
+            auto triangle = adjacency[a];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = true;
+            for (auto i = triangle * 3; i < triangle * 3 + 3; ++i) {
+                auto v = index[i];
+                ret.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time++;
+                }
+            }
+        }
+        // prefer the candidate which entered the cache earliest among those whose triangles would all still hit it
+        auto best = none;
+        auto bestPriority = -1;
+        for (auto v : candidates) {
+            if (liveTriangles[v] == 0) {
+                continue;
+            }
+            auto priority = 0;
+            if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) {
+                priority = static_cast<int>(time - cacheTime[v]);
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+        if (best == none) {
+            // dead end, the cache is effectively flushed and a new cluster begins
+            while (!deadEnds.empty() && best == none) {
+                auto v = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveTriangles[v] > 0) {
+                    best = v;
+                }
+            }
+            if (best == none) {
+                best = nextInOrder();
+            }
+            if (clusterBegins != nullptr && best != none) {
+                clusterBegins->push_back(static_cast<unsigned int>(ret.size() / 3));
+            }
+        }
+        fanning = best;
+    }
+    if (clusterBegins != nullptr && triangleCount > 0) {
+        clusterBegins->insert(clusterBegins->begin(), 0u);
+    }
+    return ret;
+}
+
+auto OptimizeOverdraw(std::vector<Vertex> const& vertexes, std::vector<unsigned int> const& index, std::vector<unsigned int> const& clusterBegins) -> std::vector<unsigned int> {
+    auto const triangleCount = static_cast<unsigned int>(index.size() / 3);
+    auto const clusterCount = static_cast<unsigned int>(clusterBegins.size());
+    // area weighted centroids and normals of clusters and of the whole mesh
+    auto meshCentroid = Vector3f{ 0.0f, 0.0f, 0.0f };
+    auto meshArea = 0.0f;
+    auto sortKeys = vector<std::pair<Float32, unsigned int>>(clusterCount);
+    auto clusterCentroids = vector<Vector3f>(clusterCount);
+    auto clusterNormals = vector<Vector3f>(clusterCount);
+    for (auto c = 0u; c < clusterCount; ++c) {
+        auto const end = c + 1 < clusterCount ? clusterBegins[c + 1] : triangleCount;
+        auto centroid = Vector3f{ 0.0f, 0.0f, 0.0f };
+        auto normal = Vector3f{ 0.0f, 0.0f, 0.0f };
+        auto area = 0.0f;
+        for (auto t = clusterBegins[c]; t < end; ++t) {
+            auto const& a = vertexes[index[t * 3]].coord;
+            auto const& b = vertexes[index[t * 3 + 1]].coord;
+            auto const& d = vertexes[index[t * 3 + 2]].coord;
+            auto n = TriangleNormal(a, b, d);
+            auto triangleArea = std::sqrt(n(0) * n(0) + n(1) * n(1) + n(2) * n(2));
+            for (auto i = 0u; i < 3; ++i) {
+                centroid(i) += (a(i) + b(i) + d(i)) * triangleArea;
+                normal(i) += n(i);
+            }
+            area += triangleArea;
+        }
+        for (auto i = 0u; i < 3; ++i) {
+            meshCentroid(i) += centroid(i);
+            centroid(i) = area > 0.0f ? centroid(i) / (area * 3) : 0.0f;
+        }
+        meshArea += area;
+        clusterCentroids[c] = centroid;
+        clusterNormals[c] = normal;
+    }
+    for (auto i = 0u; i < 3; ++i) {
+        meshCentroid(i) = meshArea > 0.0f ? meshCentroid(i) / (meshArea * 3) : 0.0f;
+    }
+    for (auto c = 0u; c < clusterCount; ++c) {
+        auto const& n = clusterNormals[c];
+        auto length = std::sqrt(n(0) * n(0) + n(1) * n(1) + n(2) * n(2));
+        auto key = 0.0f;
+        if (length > 0.0f) {
+            for (auto i = 0u; i < 3; ++i) {
+                key += (clusterCentroids[c](i) - meshCentroid(i)) * n(i) / length;
+            }
+        }
+        // descending, so that clusters on the outside are drawn first and occlude the ones further in
+        sortKeys[c] = std::make_pair(-key, c);
+    }
+    std::stable_sort(sortKeys.begin(), sortKeys.end(), [](std::pair<Float32, unsigned int> const& lhs, std::pair<Float32, unsigned int> const& rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    auto ret = vector<unsigned int>{};
+    ret.reserve(index.size());
+    for (auto const& key : sortKeys) {
+        auto const c = key.second;
+        auto const end = c + 1 < clusterCount ? clusterBegins[c + 1] : triangleCount;
+        ret.insert(ret.end(), index.cbegin() + clusterBegins[c] * 3, index.cbegin() + end * 3);
+    }
+    return ret;
+}
+
+auto OptimizeVertexFetch(std::vector<Vertex> & vertexes, std::vector<unsigned int> & index) -> void {
+    auto const unused = static_cast<unsigned int>(vertexes.size());
+    auto remap = vector<unsigned int>(vertexes.size(), unused);
+    auto remapped = vector<Vertex>{};
+    remapped.reserve(vertexes.size());
+    for (auto & v : index) {
+        if (remap[v] == unused) {
+            remap[v] = static_cast<unsigned int>(remapped.size());
+            remapped.push_back(vertexes[v]);
+        }
+        v = remap[v];
+    }
+    vertexes = std::move(remapped);
+}
+
+auto OptimizeMesh(Mesh<Vertex> & mesh, unsigned int cacheSize) -> MeshOptimizationStatistics {
+    auto ret = MeshOptimizationStatistics{};
+    ret.before = ComputeVertexCacheStatistics(mesh.GetIndex(), cacheSize);
+    if (mesh.GetIndex().empty()) {
+        ret.after = ret.before;
+        return ret;
+    }
+    auto vertexes = mesh.GetVertex();
+    auto clusterBegins = vector<unsigned int>{};
+    auto index = OptimizeVertexCache(mesh.GetIndex(), static_cast<unsigned int>(vertexes.size()), cacheSize, &clusterBegins);
+    index = OptimizeOverdraw(vertexes, index, clusterBegins);
+    OptimizeVertexFetch(vertexes, index);
+    ret.after = ComputeVertexCacheStatistics(index, cacheSize);
+    mesh.SetData(std::move(vertexes), std::move(index));
+    return ret;
+}
+
+}
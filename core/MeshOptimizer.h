@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "Primitive.h"
+#include "Vertex.h"
+#include "Mesh.h"
+
+namespace core {
+
+// Reordering of triangle meshes for rendering, done once when meshes are loaded:
+// 1. Tipsify (Sander, Nehab, Barczak 2007) orders triangles for a post-transform vertex cache of the given size,
+// 2. the clusters it produces are sorted so that triangles facing outwards come first, which reduces overdraw,
+// 3. vertexes are renumbered in order of first use, so that vertex fetch reads memory sequentially.
+// Cache efficiency is measured as ACMR, transformed vertexes per triangle, and ATVR, transformed vertexes per vertex;
+// both for a FIFO cache, the lowest possible ATVR is 1.
+
+constexpr unsigned int VertexCacheSize = 16u;
+
+struct VertexCacheStatistics {
+    Float32 acmr;
+    Float32 atvr;
+};
+
+struct MeshOptimizationStatistics {
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+};
+
+auto ComputeVertexCacheStatistics(std::vector<unsigned int> const& index, unsigned int cacheSize = VertexCacheSize) -> VertexCacheStatistics;
+// triangles in cache friendly order; clusterBegins, if not null, receives the index of the first triangle of every cluster
+auto OptimizeVertexCache(std::vector<unsigned int> const& index, unsigned int vertexCount, unsigned int cacheSize = VertexCacheSize, std::vector<unsigned int> * clusterBegins = nullptr) -> std::vector<unsigned int>;
+// clusters of triangles sorted by how much they face away from the mesh center, triangles in a cluster keep their order
+auto OptimizeOverdraw(std::vector<Vertex> const& vertexes, std::vector<unsigned int> const& index, std::vector<unsigned int> const& clusterBegins) -> std::vector<unsigned int>;
+// renumbers vertexes by first use in index, unused vertexes are removed
+auto OptimizeVertexFetch(std::vector<Vertex> & vertexes, std::vector<unsigned int> & index) -> void;
+// all of the above
+auto OptimizeMesh(Mesh<Vertex> & mesh, unsigned int cacheSize = VertexCacheSize) -> MeshOptimizationStatistics;
+
+}
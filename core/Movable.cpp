@@ -78,73 +78,76 @@ auto Movable::Rotate(Point4f const& center, Vector4f const& pivot, Float32 angle
     Translate(center);
 }
 
+auto Movable::Scale(Float32 x, Float32 y, Float32 z) -> void {
+    assert(nullptr != _sceneNode);
+    _sceneNode->Scale(x, y, z);
+}
+
 auto Movable::GetRightDirection() -> Vector4f {
-    return _sceneNode->_transform * _rightDirection;
+    return RotateDirection(_rightDirection);
 }
 
 auto Movable::GetForwardDirection() -> Vector4f {
-    return _sceneNode->_transform * _forwardDirection;
+    return RotateDirection(_forwardDirection);
 }
 
 auto Movable::GetUpwardDirection() -> Vector4f {
-    return _sceneNode->_transform * _upwardDirection;
+    return RotateDirection(_upwardDirection);
 }
 
+auto Movable::RotateDirection(Vector4f const& direction) const -> Vector4f {
+    auto ret = Transform::FromMatrix(GetTransform()).GetRotation().Rotate(Vector3f{ direction(0), direction(1), direction(2) });
+    return Vector4f{ ret(0), ret(1), ret(2), 0.0f };
+}
+
+// the transform becomes relative to the new parent: world transform is the parent's one followed by this one
 auto Movable::AttachTo(Movable & node) -> void {
-    _sceneNode->_parent = node._sceneNode.get();
-    node._sceneNode->_children.push_front(_sceneNode.get());
-    _sceneNode->_transform = node.GetTransform() * GetTransform();
+    _sceneNode->SetParent(node._sceneNode.get());
 }
+
+// keeps the world transform, which becomes the local one. Not representable as a local transform if a non-uniformly
+// scaled ancestor rotates this node, the node is sheared then and loses the shear
 auto Movable::DetachFrom() -> void {
-    _sceneNode->_parent->_children.remove(_sceneNode.get());
-    _sceneNode->_parent = nullptr;
+    assert(Transform::IsDecomposable(GetTransform()));
+    _sceneNode->_transform = Transform::FromMatrix(GetTransform());
+    _sceneNode->SetParent(nullptr);
 }
 
 auto Movable::GetPosition() const -> Point4f {
-    return _sceneNode->_transform * Point4f{ 0, 0, 0, 1 };
+    auto const& matrix = GetTransform();
+    return Point4f{ matrix(0, 3), matrix(1, 3), matrix(2, 3), 1 };
 }
 
 auto Movable::GetRotationInverse() const -> Matrix4x4f {
-    using std::swap;
-    auto rotation = _sceneNode->_transform;
-    rotation(0, 3) = rotation(1, 3) = rotation(2, 3) = 0;
-    swap(rotation(0, 1), rotation(1, 0));
-    swap(rotation(0, 2), rotation(2, 0));
-    swap(rotation(1, 2), rotation(2, 1));
-    return rotation;
+    return Transform{ Vector3f{ 0, 0, 0 }, Transform::FromMatrix(GetTransform()).GetRotation().Conjugate(), Vector3f{ 1, 1, 1 } }.ToMatrix();
 }
 
 auto Movable::GetTransform() const -> Matrix4x4f const& {
+    return _sceneNode->GetWorldMatrix();
+}
+
+auto Movable::GetTransformVersion() const -> unsigned int {
+    return _sceneNode->GetWorldVersion();
+}
+
+auto Movable::GetLocalTransform() const -> Transform const& {
     return _sceneNode->_transform;
 }
 
 auto Movable::GetRigidBodyMatrixInverse() const -> Matrix4x4f {
-    using std::swap;
-    auto const& matrix = _sceneNode->_transform;
-
-    // rigid body matrix inverse: 
-    // 1. transpose rotation part (left-upper 3x3 submatrix)
-    auto rotationInverse = GetRotationInverse();
-    // 2. negate translation part (first 3 elements of 4th column)
-    auto translationInverse = Matrix4x4f{
-        1, 0, 0, -matrix(0, 3),
-        0, 1, 0, -matrix(1, 3),
-        0, 0, 1, -matrix(2, 3),
-        0, 0, 0, 1,
-    };
-    return rotationInverse * translationInverse;
+    // transposed rotation of the cached world matrix, exact only if the movable and its ancestors are not scaled
+    return RigidBodyInverse(GetTransform());
 }
 
 auto Movable::GetNormalTransform() const -> Matrix4x4f {
     // normal transform is the transpose of the inverse of the upper-left corner of the model matrix
-    // but for rigid body transformation, normal transformation is the same with world transformation.
-    return _sceneNode->_transform;
+    return InverseTranspose3x3(GetTransform());
 }
 
 auto Movable::GetShaderData() const -> ShaderData {
     return ShaderData{
-        _sceneNode->_transform,
-        _sceneNode->_transform,
+        GetTransform(),
+        GetNormalTransform(),
     };
 }
 
@@ -55,11 +55,13 @@ public:
     auto Pitch(Float32 radius) -> void;
     auto Roll(Float32 radius) -> void;
 
+    // in the parent's space, or world space if not attached
     auto Translate(Float32, Float32, Float32) -> void;
     auto Translate(Vector4f const&) -> void;
     auto Rotate(Float32, Float32, Float32, Float32) -> void;
     auto Rotate(Vector4f const& pivot, Float32 angle) -> void;
     auto Rotate(Point4f const& center, Vector4f const& pivot, Float32 angle) -> void;
+    auto Scale(Float32, Float32, Float32) -> void;
 
     auto GetRightDirection()->Vector4f;
     auto GetForwardDirection()->Vector4f;
@@ -70,9 +72,15 @@ public:
 
     auto GetPosition() const->Point4f;
     auto GetRotationInverse() const->Matrix4x4f;
+    // world transform, the parent's one followed by the local one
     auto GetTransform() const->Matrix4x4f const&;
+    // relative to the parent, or world transform if not attached
+    auto GetLocalTransform() const -> Transform const&;
+    // inverse of GetTransform() for unscaled movables such as cameras and lights, Inverse(GetTransform()) otherwise
     auto GetRigidBodyMatrixInverse() const->Matrix4x4f;
     auto GetNormalTransform() const->Matrix4x4f;
+    // changes whenever GetTransform() changes, lets caches of derived data detect stale entries
+    auto GetTransformVersion() const -> unsigned int;
 
     auto SetUbo(openglUint ubo) -> void {
         _ubo = ubo;
@@ -94,6 +102,9 @@ public:
         _renderDataId = id;
     }
 
+private:
+    auto RotateDirection(Vector4f const& direction) const -> Vector4f;
+
 protected:
     std::unique_ptr<SceneNode> _sceneNode = std::make_unique<SceneNode>();
     Vector4f _forwardDirection = Vector4f{ 0.0f, 1.0f, 0.0f, 0.0f };
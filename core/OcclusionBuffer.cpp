@@ -0,0 +1,295 @@
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <xmmintrin.h>
+
+#include "Parallel.h"
+
+using std::vector;
+
+namespace core {
+
+namespace {
+
+// rasterizes a counter-clockwise triangle into the rows [firstRow, lastRow), keeping the nearer depth of every pixel
+// whose center is covered. 4 horizontally adjacent pixels are processed at once.
+auto RasterizeTriangle(Float32 const* x, Float32 const* y, Float32 const* z, Float32 area, unsigned int firstRow, unsigned int lastRow, Float32 * depth) -> void {
+    auto minX = std::max(0.0f, std::floor(std::min({ x[0], x[1], x[2] })));
+    auto maxX = std::min(static_cast<Float32>(OcclusionBuffer::Width - 1), std::floor(std::max({ x[0], x[1], x[2] })));
+    auto minY = std::max(static_cast<Float32>(firstRow), std::floor(std::min({ y[0], y[1], y[2] })));
+    auto maxY = std::min(static_cast<Float32>(lastRow - 1), std::floor(std::max({ y[0], y[1], y[2] })));
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+    // edge functions a * x + b * y + c, non-negative on the inner side of the edge from vertex i to the next one
+    __m128 edgeA[3];
+    __m128 edgeB[3];
+    __m128 edgeC[3];
+    for (auto i = 0u; i < 3; ++i) {
+        auto j = (i + 1) % 3;
+        auto a = y[i] - y[j];
+        auto b = x[j] - x[i];
+        edgeA[i] = _mm_set1_ps(a);
+        edgeB[i] = _mm_set1_ps(b);
+        edgeC[i] = _mm_set1_ps(-(a * x[i] + b * y[i]));
+    }
+    // window space depth is linear in screen space
+    auto dzdx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    auto dzdy = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+    auto depthA = _mm_set1_ps(dzdx);
+    auto depthC = _mm_set1_ps(z[0] - dzdx * x[0] - dzdy * y[0]);
+    auto const laneOffset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    auto const zero = _mm_setzero_ps();
+
+    auto firstColumn = static_cast<unsigned int>(minX) & ~3u;
+    auto lastColumn = static_cast<unsigned int>(maxX);
+    for (auto row = static_cast<unsigned int>(minY); row <= static_cast<unsigned int>(maxY); ++row) {
+        auto pixelY = _mm_set1_ps(row + 0.5f);
+        auto rowDepth = _mm_add_ps(depthC, _mm_set1_ps(dzdy * (row + 0.5f)));
+        for (auto column = firstColumn; column <= lastColumn; column += 4) {
+            auto pixelX = _mm_add_ps(_mm_set1_ps(static_cast<Float32>(column)), laneOffset);
+            auto inside = _mm_cmpeq_ps(zero, zero); // all bits set
+            for (auto i = 0u; i < 3; ++i) {
+                auto edge = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[i], pixelX), _mm_mul_ps(edgeB[i], pixelY)), edgeC[i]);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, zero));
+            }
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+            auto * target = depth + OcclusionBuffer::GetPixelIndex(column, row);
+            auto oldDepth = _mm_loadu_ps(target);
+            auto newDepth = _mm_min_ps(oldDepth, _mm_add_ps(rowDepth, _mm_mul_ps(depthA, pixelX)));
+            _mm_storeu_ps(target, _mm_or_ps(_mm_and_ps(inside, newDepth), _mm_andnot_ps(inside, oldDepth)));
+        }
+    }
+}
+
+}
+
+OcclusionBuffer::OcclusionBuffer(unsigned int threadCount)
+    : _threadCount(std::max(1u, threadCount))
+    , _depth(Width * Height, 1.0f)
+    , _tileMaxDepth(TileColumnCount * TileRowCount, 1.0f) {
+}
+
+auto OcclusionBuffer::Render(Matrix4x4f const& viewProjectTransform, Point4f const& viewPosition, Shape * const* candidates, unsigned int candidateCount) -> void {
+    // the nearer and larger a box is the more it is likely to hide
+    struct Candidate {
+        Shape * shape;
+        Float32 size;
+    };
+    auto occluders = vector<Candidate>{};
+    for (auto i = 0u; i < candidateCount; ++i) {
+        auto * shape = candidates[i];
+        auto const* material = shape->GetMaterial();
+        if (material != nullptr && material->GetTransparency() > 0) {
+            continue; // things behind translucent shapes are visible
+        }
+        if (shape->GetMesh()->GetIndex().size() / 3 > MaxOccluderTriangleCount) {
+            continue;
+        }
+        auto const& aabb = shape->GetAabb();
+        auto diagonal = Length(static_cast<Vector4f>(aabb.GetMaxVertex() - aabb.GetMinVertex()));
+        auto distance = std::max(Length(static_cast<Vector4f>(aabb.GetCenter() - viewPosition)), std::numeric_limits<Float32>::epsilon());
+        if (diagonal / distance >= MinOccluderSize) {
+            occluders.push_back(Candidate{ shape, diagonal / distance });
+        }
+    }
+    auto occluderCount = std::min(static_cast<unsigned int>(occluders.size()), MaxOccluderCount);
+    std::partial_sort(occluders.begin(), occluders.begin() + occluderCount, occluders.end(), [](Candidate const& lhs, Candidate const& rhs) {
+        return lhs.size > rhs.size;
+    });
+
+    Begin(viewProjectTransform);
+    for (auto i = 0u; i < occluderCount; ++i) {
+        AddOccluder(*occluders[i].shape->GetMesh(), occluders[i].shape->GetModel()->GetTransform());
+    }
+    Rasterize();
+}
+
+auto OcclusionBuffer::Begin(Matrix4x4f const& viewProjectTransform) -> void {
+    _viewProjectTransform = viewProjectTransform;
+    _occluders.clear();
+}
+
+auto OcclusionBuffer::AddOccluder(Mesh<Vertex> const& mesh, Matrix4x4f const& modelTransform) -> void {
+    _occluders.push_back(Occluder{ &mesh, static_cast<Matrix4x4f>(_viewProjectTransform * modelTransform) });
+}
+
+auto OcclusionBuffer::Rasterize() -> void {
+    // 1. transform, clip and project triangles of occluders spread over the threads
+    auto setupChunkCount = std::max(1u, std::min(_threadCount, static_cast<unsigned int>(_occluders.size())));
+    auto triangles = vector<vector<ScreenTriangle>>(setupChunkCount);
+    ForEachChunk(0u, static_cast<unsigned int>(_occluders.size()), setupChunkCount, [this, &triangles](unsigned int chunk, unsigned int first, unsigned int last) {
+        for (auto i = first; i < last; ++i) {
+            SetupTriangles(_occluders[i], triangles[chunk]);
+        }
+    });
+    // 2. every thread rasterizes all triangles into its own band of tile rows, so no pixel is shared
+    ForEachChunk(0u, TileRowCount, std::min(_threadCount, TileRowCount), [this, &triangles](unsigned int, unsigned int first, unsigned int last) {
+        RasterizeTiles(triangles, first, last);
+    });
+}
+
+auto OcclusionBuffer::IsVisible(Float32 const* minVertex, Float32 const* maxVertex) const -> bool {
+    // bounds of the box's corners in window space
+    auto const& m = _viewProjectTransform;
+    auto minX = std::numeric_limits<Float32>::max();
+    auto minY = std::numeric_limits<Float32>::max();
+    auto maxX = std::numeric_limits<Float32>::lowest();
+    auto maxY = std::numeric_limits<Float32>::lowest();
+    auto minZ = std::numeric_limits<Float32>::max();
+    for (auto corner = 0u; corner < 8; ++corner) {
+        Float32 position[3] = {
+            (corner & 1u) != 0 ? maxVertex[0] : minVertex[0],
+            (corner & 2u) != 0 ? maxVertex[1] : minVertex[1],
+            (corner & 4u) != 0 ? maxVertex[2] : minVertex[2],
+        };
+        Float32 clip[4];
+        for (auto i = 0u; i < 4; ++i) {
+            clip[i] = m(i, 0) * position[0] + m(i, 1) * position[1] + m(i, 2) * position[2] + m(i, 3);
+        }
+        if (clip[2] < -clip[3] || clip[3] <= 0.0f) {
+            return true; // crosses the near plane, the viewer may be inside
+        }
+        auto x = (clip[0] / clip[3] * 0.5f + 0.5f) * Width;
+        auto y = (clip[1] / clip[3] * 0.5f + 0.5f) * Height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, clip[2] / clip[3] * 0.5f + 0.5f);
+    }
+    if (maxX < 0.0f || maxY < 0.0f || minX >= Width || minY >= Height) {
+        return false;
+    }
+    // every pixel the box touches
+    auto firstColumn = static_cast<unsigned int>(std::max(0.0f, minX));
+    auto lastColumn = static_cast<unsigned int>(std::min(static_cast<Float32>(Width - 1), maxX));
+    auto firstRow = static_cast<unsigned int>(std::max(0.0f, minY));
+    auto lastRow = static_cast<unsigned int>(std::min(static_cast<Float32>(Height - 1), maxY));
+    minZ -= DepthBias;
+    auto boxDepth = _mm_set1_ps(minZ);
+    for (auto tileRow = firstRow / TileHeight; tileRow <= lastRow / TileHeight; ++tileRow) {
+        for (auto tileColumn = firstColumn / TileWidth; tileColumn <= lastColumn / TileWidth; ++tileColumn) {
+            if (minZ > _tileMaxDepth[tileRow * TileColumnCount + tileColumn]) {
+                continue; // everything in the tile is nearer
+            }
+            auto rowBegin = std::max(firstRow, tileRow * TileHeight);
+            auto rowEnd = std::min(lastRow + 1, (tileRow + 1) * TileHeight);
+            auto columnBegin = std::max(firstColumn, tileColumn * TileWidth);
+            auto columnEnd = std::min(lastColumn + 1, (tileColumn + 1) * TileWidth);
+            for (auto row = rowBegin; row < rowEnd; ++row) {
+                for (auto column = columnBegin & ~3u; column < columnEnd; column += 4) {
+                    auto farther = _mm_movemask_ps(_mm_cmple_ps(boxDepth, _mm_loadu_ps(&_depth[GetPixelIndex(column, row)])));
+                    // only lanes within [columnBegin, columnEnd) count
+                    auto laneMask = (0xfu << (std::max(column, columnBegin) - column)) & (0xfu >> (column + 4 - std::min(column + 4, columnEnd)));
+                    if ((farther & laneMask) != 0) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+auto OcclusionBuffer::IsVisible(Aabb const& aabb) const -> bool {
+    auto minVertex = aabb.GetMinVertex();
+    auto maxVertex = aabb.GetMaxVertex();
+    return IsVisible(minVertex.data(), maxVertex.data());
+}
+
+auto OcclusionBuffer::SetupTriangles(Occluder const& occluder, vector<ScreenTriangle> & triangles) const -> void {
+    auto const& m = occluder.transform;
+    auto const& vertexes = occluder.mesh->GetVertex();
+    auto const& index = occluder.mesh->GetIndex();
+    auto clipVertexes = vector<std::array<Float32, 4>>(vertexes.size());
+    for (auto i = 0u; i < vertexes.size(); ++i) {
+        auto const& coord = vertexes[i].coord;
+        for (auto j = 0u; j < 4; ++j) {
+            clipVertexes[i][j] = m(j, 0) * coord(0) + m(j, 1) * coord(1) + m(j, 2) * coord(2) + m(j, 3);
+        }
+    }
+    for (auto i = 0u; i + 2 < index.size(); i += 3) {
+        // clip against the near plane z >= -w, a triangle becomes a polygon of up to 4 vertexes
+        std::array<Float32, 4> polygon[4];
+        auto vertexCount = 0u;
+        for (auto j = 0u; j < 3; ++j) {
+            auto const& current = clipVertexes[index[i + j]];
+            auto const& next = clipVertexes[index[i + (j + 1) % 3]];
+            auto currentDistance = current[2] + current[3];
+            auto nextDistance = next[2] + next[3];
+            if (currentDistance >= 0.0f) {
+                polygon[vertexCount++] = current;
+            }
+            if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+                auto t = currentDistance / (currentDistance - nextDistance);
+                for (auto k = 0u; k < 4; ++k) {
+                    polygon[vertexCount][k] = current[k] + t * (next[k] - current[k]);
+                }
+                ++vertexCount;
+            }
+        }
+        if (vertexCount < 3) {
+            continue;
+        }
+        // project to window space, w is positive in front of the near plane
+        Float32 x[4];
+        Float32 y[4];
+        Float32 z[4];
+        auto outside = false;
+        for (auto j = 0u; j < vertexCount; ++j) {
+            auto w = polygon[j][3];
+            if (w <= 0.0f) {
+                outside = true;
+                break;
+            }
+            x[j] = (polygon[j][0] / w * 0.5f + 0.5f) * Width;
+            y[j] = (polygon[j][1] / w * 0.5f + 0.5f) * Height;
+            z[j] = polygon[j][2] / w * 0.5f + 0.5f;
+        }
+        if (outside) {
+            continue;
+        }
+        for (auto j = 1u; j + 1 < vertexCount; ++j) {
+            triangles.push_back(ScreenTriangle{ { x[0], x[j], x[j + 1] }, { y[0], y[j], y[j + 1] }, { z[0], z[j], z[j + 1] } });
+        }
+    }
+}
+
+auto OcclusionBuffer::RasterizeTiles(vector<vector<ScreenTriangle>> const& triangles, unsigned int firstTileRow, unsigned int lastTileRow) -> void {
+    auto firstPixel = _depth.begin() + firstTileRow * TileColumnCount * TileWidth * TileHeight;
+    auto lastPixel = _depth.begin() + lastTileRow * TileColumnCount * TileWidth * TileHeight;
+    std::fill(firstPixel, lastPixel, 1.0f);
+    for (auto const& chunk : triangles) {
+        for (auto const& triangle : chunk) {
+            // occluders are closed or seen from both sides, so both windings are rasterized
+            auto area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+            if (area > 0.0f) {
+                RasterizeTriangle(triangle.x, triangle.y, triangle.z, area, firstTileRow * TileHeight, lastTileRow * TileHeight, _depth.data());
+            } else if (area < 0.0f) {
+                Float32 x[3] = { triangle.x[0], triangle.x[2], triangle.x[1] };
+                Float32 y[3] = { triangle.y[0], triangle.y[2], triangle.y[1] };
+                Float32 z[3] = { triangle.z[0], triangle.z[2], triangle.z[1] };
+                RasterizeTriangle(x, y, z, -area, firstTileRow * TileHeight, lastTileRow * TileHeight, _depth.data());
+            }
+        }
+    }
+    // farthest depth of every tile
+    for (auto tile = firstTileRow * TileColumnCount; tile < lastTileRow * TileColumnCount; ++tile) {
+        auto const* pixel = &_depth[tile * TileWidth * TileHeight];
+        auto maxDepth = _mm_loadu_ps(pixel);
+        for (auto i = 4u; i < TileWidth * TileHeight; i += 4) {
+            maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(pixel + i));
+        }
+        maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+        maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+        _tileMaxDepth[tile] = _mm_cvtss_f32(maxDepth);
+    }
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include "Primitive.h"
+#include "Matrix.h"
+#include "Aabb.h"
+#include "Mesh.h"
+#include "Shape.h"
+
+namespace core {
+
+// Low resolution depth buffer rasterized on the CPU from a few large occluders, rejects boxes hidden behind them
+// before their shapes reach the draw list. Pixels are stored tile by tile so that a tile is contiguous in memory,
+// and the farthest depth of every tile is kept to reject boxes without touching their pixels.
+// Depth is window space depth in [0, 1] of OpenGL clip space, smaller is nearer.
+class OcclusionBuffer {
+public:
+    static constexpr const unsigned int Width = 256u;
+    static constexpr const unsigned int Height = 128u;
+    static constexpr const unsigned int TileWidth = 32u;
+    static constexpr const unsigned int TileHeight = 8u;
+    static constexpr const unsigned int TileColumnCount = Width / TileWidth;
+    static constexpr const unsigned int TileRowCount = Height / TileHeight;
+    static constexpr const unsigned int MaxOccluderCount = 32u;
+    static constexpr const unsigned int MaxOccluderTriangleCount = 4096u; // detailed meshes cost more than they hide
+    static constexpr const Float32 MinOccluderSize = 0.5f; // diagonal of occluder's AABB relative to its distance to viewer
+    static constexpr const Float32 DepthBias = 1.0e-5f; // keeps rounding from letting occluders hide themselves
+public:
+    explicit OcclusionBuffer(unsigned int threadCount = 1u);
+public:
+    // selects the largest of candidates as occluders and rasterizes them, replacing the previous content
+    auto Render(Matrix4x4f const& viewProjectTransform, Point4f const& viewPosition, Shape * const* candidates, unsigned int candidateCount) -> void;
+    // lower level interface of Render(): occluders added after Begin() are rasterized by Rasterize()
+    auto Begin(Matrix4x4f const& viewProjectTransform) -> void;
+    auto AddOccluder(Mesh<Vertex> const& mesh, Matrix4x4f const& modelTransform) -> void;
+    auto Rasterize() -> void;
+    // conservative test of a world space box against the buffer, false only if every pixel it covers is nearer.
+    // reads 3 floats from both vertexes.
+    auto IsVisible(Float32 const* minVertex, Float32 const* maxVertex) const -> bool;
+    auto IsVisible(Aabb const& aabb) const -> bool;
+    auto GetDepth(unsigned int x, unsigned int y) const -> Float32 {
+        return _depth[GetPixelIndex(x, y)];
+    }
+    // tiles are contiguous, pixels of a tile are stored row by row
+    static auto GetPixelIndex(unsigned int x, unsigned int y) -> unsigned int {
+        return ((y / TileHeight) * TileColumnCount + x / TileWidth) * TileWidth * TileHeight + (y % TileHeight) * TileWidth + x % TileWidth;
+    }
+private:
+    struct Occluder {
+        Mesh<Vertex> const* mesh;
+        Matrix4x4f transform; // model space to clip space
+    };
+    struct ScreenTriangle {
+        Float32 x[3];
+        Float32 y[3];
+        Float32 z[3];
+    };
+private:
+    auto SetupTriangles(Occluder const& occluder, std::vector<ScreenTriangle> & triangles) const -> void;
+    auto RasterizeTiles(std::vector<std::vector<ScreenTriangle>> const& triangles, unsigned int firstTileRow, unsigned int lastTileRow) -> void;
+private:
+    unsigned int _threadCount;
+    Matrix4x4f _viewProjectTransform;
+    std::vector<Occluder> _occluders;
+    std::vector<Float32> _depth;
+    std::vector<Float32> _tileMaxDepth;
+};
+
+}
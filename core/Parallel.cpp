@@ -0,0 +1,95 @@
+#include "Parallel.h"
+
+#include <algorithm>
+
+using std::unique_lock;
+using std::mutex;
+
+namespace core {
+
+auto WorkerPool::GetInstance() -> WorkerPool & {
+    // the calling thread is one of the hardware threads
+    static WorkerPool pool{ std::max(std::thread::hardware_concurrency(), 2u) - 1 };
+    return pool;
+}
+
+WorkerPool::WorkerPool(unsigned int workerCount) {
+    _workers.reserve(workerCount);
+    for (auto i = 0u; i < workerCount; ++i) {
+        _workers.emplace_back([this] {
+            Work();
+        });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        auto lock = unique_lock<mutex>{ _mutex };
+        _stopping = true;
+    }
+    _batchAdded.notify_all();
+    for (auto & worker : _workers) {
+        worker.join();
+    }
+}
+
+auto WorkerPool::Run(unsigned int count, std::function<void(unsigned int)> const& job) -> void {
+    if (count == 0) {
+        return;
+    }
+    auto batch = Batch{ &job, count, 0u, 0u, nullptr };
+    auto lock = unique_lock<mutex>{ _mutex };
+    _batches.push_back(&batch);
+    if (count > 1) {
+        _batchAdded.notify_all();
+    }
+    while (RunNext(batch, lock)) {
+    }
+    // batch lives on this stack, wait for the workers still running its calls
+    _batchFinished.wait(lock, [&batch] {
+        return batch.finished == batch.count;
+    });
+    if (batch.exception != nullptr) {
+        std::rethrow_exception(batch.exception);
+    }
+}
+
+auto WorkerPool::Work() -> void {
+    auto lock = unique_lock<mutex>{ _mutex };
+    while (true) {
+        _batchAdded.wait(lock, [this] {
+            return _stopping || !_batches.empty();
+        });
+        if (_stopping) {
+            return;
+        }
+        RunNext(*_batches.front(), lock);
+    }
+}
+
+auto WorkerPool::RunNext(Batch & batch, unique_lock<mutex> & lock) -> bool {
+    if (batch.next == batch.count) {
+        return false;
+    }
+    auto index = batch.next++;
+    if (batch.next == batch.count) {
+        _batches.erase(std::find(_batches.begin(), _batches.end(), &batch));
+    }
+    lock.unlock();
+    auto exception = std::exception_ptr{};
+    try {
+        (*batch.job)(index);
+    } catch (...) {
+        exception = std::current_exception();
+    }
+    lock.lock();
+    if (exception != nullptr && batch.exception == nullptr) {
+        batch.exception = exception;
+    }
+    if (++batch.finished == batch.count) {
+        _batchFinished.notify_all();
+    }
+    return true;
+}
+
+}
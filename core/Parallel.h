@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Primitive.h"
+
+namespace core {
+
+// ranges smaller than this are processed by a single thread, splitting them costs more than it saves
+constexpr const unsigned int ParallelRangeSize = 4096u;
+
+// Threads started once and kept waiting for jobs, so that per frame work does not start a thread per chunk.
+// The thread submitting a job works on it as well, which keeps nested jobs from waiting on each other.
+class WorkerPool {
+public:
+    static auto GetInstance() -> WorkerPool &;
+public:
+    explicit WorkerPool(unsigned int workerCount);
+    WorkerPool(WorkerPool const&) = delete;
+    WorkerPool& operator=(WorkerPool const&) = delete;
+    ~WorkerPool();
+public:
+    // calls job(0) to job(count - 1) on the workers and the calling thread and returns once all returned.
+    // the first exception thrown by a call is rethrown
+    auto Run(unsigned int count, std::function<void(unsigned int)> const& job) -> void;
+private:
+    struct Batch {
+        std::function<void(unsigned int)> const* job;
+        unsigned int count;
+        unsigned int next;
+        unsigned int finished;
+        std::exception_ptr exception;
+    };
+private:
+    auto Work() -> void;
+    // runs the next call of batch with _mutex locked by lock, false if all calls have started
+    auto RunNext(Batch & batch, std::unique_lock<std::mutex> & lock) -> bool;
+private:
+    std::mutex _mutex;
+    std::condition_variable _batchAdded;
+    std::condition_variable _batchFinished;
+    std::vector<Batch *> _batches; // with calls not started yet
+    std::vector<std::thread> _workers;
+    bool _stopping = false;
+};
+
+// first index of the chunk-th of chunkCount nearly equal chunks of [begin, end)
+inline auto GetChunkBegin(unsigned int begin, unsigned int end, unsigned int chunkCount, unsigned int chunk) -> unsigned int {
+    return begin + static_cast<unsigned int>(static_cast<uint64>(end - begin) * chunk / chunkCount);
+}
+
+// calls f(chunk, first, last) for every chunk, spread over the threads of WorkerPool::GetInstance()
+template <typename F>
+auto ForEachChunk(unsigned int begin, unsigned int end, unsigned int chunkCount, F const& f) -> void {
+    if (chunkCount <= 1) {
+        f(0u, begin, end);
+        return;
+    }
+    WorkerPool::GetInstance().Run(chunkCount, [begin, end, chunkCount, &f](unsigned int chunk) {
+        f(chunk, GetChunkBegin(begin, end, chunkCount, chunk), GetChunkBegin(begin, end, chunkCount, chunk + 1));
+    });
+}
+
+}
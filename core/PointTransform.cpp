@@ -0,0 +1,125 @@
+#include "PointTransform.h"
+
+#include <algorithm>
+#include <limits>
+#include <xmmintrin.h>
+
+namespace core {
+
+namespace {
+
+auto PointAt(Vector3f const* points, unsigned int stride, unsigned int index) -> Float32 const* {
+    return reinterpret_cast<Float32 const*>(reinterpret_cast<char const*>(points) + static_cast<size_t>(index) * stride);
+}
+
+// matrix elements of the upper 3 rows broadcast to 4 lanes
+struct MatrixLanes {
+public:
+    explicit MatrixLanes(Matrix4x4f const& matrix) {
+        for (auto i = 0u; i < 3; ++i) {
+            for (auto j = 0u; j < 4; ++j) {
+                m[i][j] = _mm_set1_ps(matrix(i, j));
+            }
+        }
+    }
+public:
+    __m128 m[3][4];
+};
+
+// loads 4 points and transposes them to x, y and z of the 4 points. Reads a 4th float after every point, which is
+// part of the next point or of the vertex struct, so the caller keeps the last point of the array out of it.
+auto LoadPoints(Vector3f const* points, unsigned int stride, unsigned int first, __m128 & x, __m128 & y, __m128 & z) -> void {
+    x = _mm_loadu_ps(PointAt(points, stride, first));
+    y = _mm_loadu_ps(PointAt(points, stride, first + 1));
+    z = _mm_loadu_ps(PointAt(points, stride, first + 2));
+    auto w = _mm_loadu_ps(PointAt(points, stride, first + 3));
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+// same order of terms as Matrix4x4f * Point4f
+auto TransformLanes(MatrixLanes const& lanes, __m128 x, __m128 y, __m128 z, __m128 * ret) -> void {
+    for (auto i = 0u; i < 3; ++i) {
+        auto v = _mm_mul_ps(lanes.m[i][0], x);
+        v = MultiplyAdd(lanes.m[i][1], y, v);
+        v = MultiplyAdd(lanes.m[i][2], z, v);
+        ret[i] = _mm_add_ps(v, lanes.m[i][3]);
+    }
+}
+
+auto TransformPoint(Matrix4x4f const& matrix, Float32 const* point, Float32 * ret) -> void {
+    auto transformed = static_cast<Vector4f>(matrix * Vector4f{ point[0], point[1], point[2], 1.0f });
+    ret[0] = transformed(0);
+    ret[1] = transformed(1);
+    ret[2] = transformed(2);
+}
+
+}
+
+auto TransformPoints(Matrix4x4f const& matrix, Vector3f const* points, Vector3f * transformed, unsigned int count, unsigned int stride) -> void {
+    auto const lanes = MatrixLanes{ matrix };
+    auto i = 0u;
+    for (; i + 4 < count; i += 4) {
+        __m128 x, y, z;
+        LoadPoints(points, stride, i, x, y, z);
+        __m128 ret[4];
+        TransformLanes(lanes, x, y, z, ret);
+        ret[3] = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(ret[0], ret[1], ret[2], ret[3]);
+        // 3 floats of every point, writing the 4th would overwrite the next point
+        for (auto j = 0u; j < 4; ++j) {
+            auto * out = transformed[i + j].data();
+            _mm_storel_pi(reinterpret_cast<__m64 *>(out), ret[j]);
+            _mm_store_ss(out + 2, _mm_movehl_ps(ret[j], ret[j]));
+        }
+    }
+    for (; i < count; ++i) {
+        TransformPoint(matrix, PointAt(points, stride, i), transformed[i].data());
+    }
+}
+
+auto TransformBounds(Matrix4x4f const& matrix, Vector3f const* points, unsigned int count, unsigned int stride) -> Aabb {
+    auto const lanes = MatrixLanes{ matrix };
+    __m128 minLanes[3];
+    __m128 maxLanes[3];
+    for (auto axis = 0u; axis < 3; ++axis) {
+        minLanes[axis] = _mm_set1_ps(std::numeric_limits<Float32>::max());
+        maxLanes[axis] = _mm_set1_ps(std::numeric_limits<Float32>::lowest());
+    }
+    auto i = 0u;
+    for (; i + 4 < count; i += 4) {
+        __m128 x, y, z;
+        LoadPoints(points, stride, i, x, y, z);
+        __m128 ret[3];
+        TransformLanes(lanes, x, y, z, ret);
+        for (auto axis = 0u; axis < 3; ++axis) {
+            minLanes[axis] = _mm_min_ps(minLanes[axis], ret[axis]);
+            maxLanes[axis] = _mm_max_ps(maxLanes[axis], ret[axis]);
+        }
+    }
+    Float32 minVertex[3];
+    Float32 maxVertex[3];
+    for (auto axis = 0u; axis < 3; ++axis) {
+        Float32 minValues[4];
+        Float32 maxValues[4];
+        _mm_storeu_ps(minValues, minLanes[axis]);
+        _mm_storeu_ps(maxValues, maxLanes[axis]);
+        minVertex[axis] = std::min(std::min(minValues[0], minValues[1]), std::min(minValues[2], minValues[3]));
+        maxVertex[axis] = std::max(std::max(maxValues[0], maxValues[1]), std::max(maxValues[2], maxValues[3]));
+    }
+    for (; i < count; ++i) {
+        Float32 point[3];
+        TransformPoint(matrix, PointAt(points, stride, i), point);
+        for (auto axis = 0u; axis < 3; ++axis) {
+            minVertex[axis] = std::min(minVertex[axis], point[axis]);
+            maxVertex[axis] = std::max(maxVertex[axis], point[axis]);
+        }
+    }
+    auto ret = Aabb{};
+    if (count > 0) {
+        ret.SetMinVertex(Point4f{ minVertex[0], minVertex[1], minVertex[2], 1.0f });
+        ret.SetMaxVertex(Point4f{ maxVertex[0], maxVertex[1], maxVertex[2], 1.0f });
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Primitive.h"
+#include "Matrix.h"
+#include "Aabb.h"
+
+namespace core {
+
+// Affine transform of many points at once, 4 per iteration with x, y and z of the 4 points in one register each.
+// Points are read as 3 floats every stride bytes so that coordinates can be taken in place from vertex structs, e.g.
+// TransformPoints(m, &vertexes[0].coord, out, count, sizeof(Vertex)). Results match Matrix4x4f * Point4f.
+
+// transformed may alias points when stride is sizeof(Vector3f)
+auto TransformPoints(Matrix4x4f const& matrix, Vector3f const* points, Vector3f * transformed, unsigned int count, unsigned int stride = sizeof(Vector3f)) -> void;
+// bounds of the transformed points, without storing them. Empty AABB if count is 0.
+auto TransformBounds(Matrix4x4f const& matrix, Vector3f const* points, unsigned int count, unsigned int stride = sizeof(Vector3f)) -> Aabb;
+
+}
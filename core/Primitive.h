@@ -14,6 +14,7 @@ using openglEnum = unsigned int; // GLenum
 using Float32 = float;
 using size_type = unsigned int;
 using uint8 = std::uint8_t;
+using uint16 = std::uint16_t;
 using uint32 = std::uint32_t;
 using uint64 = std::uint64_t;
 using int8 = std::int8_t;
@@ -0,0 +1,164 @@
+#include "QuantizedVertex.h"
+
+#include <cstring>
+
+namespace core {
+
+namespace {
+
+auto SignNotZero(Float32 value) -> Float32 {
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+auto EncodeCoord(Vector3f const& coord, QuantizationBounds const& bounds, int16 (&encoded)[4]) -> void {
+    for (auto i = 0u; i < 3; ++i) {
+        encoded[i] = EncodeSnorm<int16>((coord(i) - bounds.center(i)) / bounds.halfExtent(i));
+    }
+    encoded[3] = 0;
+}
+
+auto DecodeCoord(int16 const (&encoded)[4], QuantizationBounds const& bounds) -> Vector3f {
+    return Vector3f{
+        DecodeSnorm(encoded[0]) * bounds.halfExtent(0) + bounds.center(0),
+        DecodeSnorm(encoded[1]) * bounds.halfExtent(1) + bounds.center(1),
+        DecodeSnorm(encoded[2]) * bounds.halfExtent(2) + bounds.center(2),
+    };
+}
+
+}
+
+auto EncodeHalf(Float32 value) -> uint16 {
+    auto bits = uint32{};
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto const sign = static_cast<uint16>((bits >> 16) & 0x8000u);
+    auto const exponent = static_cast<int>((bits >> 23) & 0xffu);
+    auto mantissa = bits & 0x7fffffu;
+    if (exponent == 0xff) {
+        // infinity stays infinity, NaN stays NaN
+        return sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u);
+    }
+    auto const halfExponent = exponent - 127 + 15;
+    if (halfExponent >= 0x1f) {
+        return sign | 0x7c00u;
+    }
+    if (halfExponent <= 0) {
+        // subnormal or zero
+        if (halfExponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000u;
+        auto const shift = static_cast<uint32>(14 - halfExponent);
+        auto half = mantissa >> shift;
+        auto const remainder = mantissa & ((1u << shift) - 1);
+        auto const halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1u) != 0)) {
+            ++half;
+        }
+        return static_cast<uint16>(sign | half);
+    }
+    // a carry out of the mantissa correctly increments the exponent, up to infinity
+    auto half = static_cast<uint32>(sign) | (static_cast<uint32>(halfExponent) << 10) | (mantissa >> 13);
+    auto const remainder = mantissa & 0x1fffu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u) != 0)) {
+        ++half;
+    }
+    return static_cast<uint16>(half);
+}
+
+auto DecodeHalf(uint16 value) -> Float32 {
+    auto const sign = static_cast<uint32>(value & 0x8000u) << 16;
+    auto const exponent = (value >> 10) & 0x1fu;
+    auto const mantissa = static_cast<uint32>(value & 0x3ffu);
+    auto bits = uint32{};
+    if (exponent == 0) {
+        auto const magnitude = std::ldexp(static_cast<Float32>(mantissa), -24);
+        return sign != 0 ? -magnitude : magnitude;
+    } else if (exponent == 0x1f) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    auto ret = Float32{};
+    std::memcpy(&ret, &bits, sizeof(ret));
+    return ret;
+}
+
+auto EncodeOctahedral(Vector3f const& normal) -> Vector2f {
+    auto const l1 = std::abs(normal(0)) + std::abs(normal(1)) + std::abs(normal(2));
+    auto x = normal(0) / l1;
+    auto y = normal(1) / l1;
+    if (normal(2) < 0.0f) {
+        // fold the lower hemisphere over the diagonals
+        auto const foldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+        auto const foldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+    return Vector2f{ x, y };
+}
+
+auto DecodeOctahedral(Vector2f const& encoded) -> Vector3f {
+    auto x = encoded(0);
+    auto y = encoded(1);
+    auto const z = 1.0f - std::abs(x) - std::abs(y);
+    if (z < 0.0f) {
+        auto const unfoldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+        auto const unfoldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+    auto const length = std::sqrt(x * x + y * y + z * z);
+    return Vector3f{ x / length, y / length, z / length };
+}
+
+auto QuantizationBounds::FromVertexes(std::vector<Vertex> const& vertexes) -> QuantizationBounds {
+    auto ret = QuantizationBounds{ Vector3f{ 0.0f, 0.0f, 0.0f }, Vector3f{ 1.0f, 1.0f, 1.0f } };
+    if (vertexes.empty()) {
+        return ret;
+    }
+    for (auto i = 0u; i < 3; ++i) {
+        auto min = vertexes.front().coord(i);
+        auto max = min;
+        for (auto const& vertex : vertexes) {
+            min = std::min(min, vertex.coord(i));
+            max = std::max(max, vertex.coord(i));
+        }
+        ret.center(i) = (min + max) * 0.5f;
+        // flat meshes keep a non zero extent so that encoding does not divide by 0
+        ret.halfExtent(i) = max > min ? (max - min) * 0.5f : 1.0f;
+    }
+    return ret;
+}
+
+auto VertexQ16::Encode(Vertex const& vertex, QuantizationBounds const& bounds) -> VertexQ16 {
+    auto ret = VertexQ16{};
+    EncodeCoord(vertex.coord, bounds, ret.coord);
+    EncodeOctahedralSnorm(vertex.normal, ret.normal);
+    ret.texCoord[0] = EncodeHalf(vertex.texCoord(0));
+    ret.texCoord[1] = EncodeHalf(vertex.texCoord(1));
+    return ret;
+}
+
+auto VertexQ16::Decode(QuantizationBounds const& bounds) const -> Vertex {
+    return Vertex{
+        DecodeCoord(coord, bounds),
+        DecodeOctahedralSnorm(normal),
+        Vector2f{ DecodeHalf(texCoord[0]), DecodeHalf(texCoord[1]) },
+    };
+}
+
+auto VertexCoordQ8::Encode(Vertex const& vertex, QuantizationBounds const& bounds) -> VertexCoordQ8 {
+    auto ret = VertexCoordQ8{};
+    EncodeCoord(vertex.coord, bounds, ret.coord);
+    return ret;
+}
+
+auto VertexCoordQ8::Decode(QuantizationBounds const& bounds) const -> Vertex {
+    return Vertex{
+        DecodeCoord(coord, bounds),
+        Vector3f{ 0.0f, 0.0f, 0.0f },
+        Vector2f{ 0.0f, 0.0f },
+    };
+}
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "Primitive.h"
+#include "Matrix.h"
+#include "Vertex.h"
+
+namespace core {
+
+// Compressed vertex layouts for bandwidth bound passes. All attributes are in formats the input assembler expands by
+// itself: positions are snorm16 relative to the bounds of the mesh (R16G16B16A16_SNORM, the shader scales them by
+// QuantizationBounds), normals are octahedral snorm16 (R16G16_SNORM, the shader unfolds them) and texture
+// coordinates are half floats (R16G16_FLOAT).
+
+template <typename I>
+auto EncodeSnorm(Float32 value) -> I {
+    static_assert(std::is_signed<I>::value && std::is_integral<I>::value, "snorm needs a signed integer type");
+    auto const max = static_cast<Float32>(std::numeric_limits<I>::max());
+    return static_cast<I>(std::round(std::min(std::max(value, -1.0f), 1.0f) * max));
+}
+
+// both -max - 1 and -max map to -1
+template <typename I>
+auto DecodeSnorm(I value) -> Float32 {
+    static_assert(std::is_signed<I>::value && std::is_integral<I>::value, "snorm needs a signed integer type");
+    return std::max(static_cast<Float32>(value) / std::numeric_limits<I>::max(), -1.0f);
+}
+
+// IEEE 754 binary16, rounded to nearest even, overflows to infinity
+auto EncodeHalf(Float32 value) -> uint16;
+auto DecodeHalf(uint16 value) -> Float32;
+
+// unit vector to the octahedral map in [-1, 1]^2
+auto EncodeOctahedral(Vector3f const& normal) -> Vector2f;
+// normalized
+auto DecodeOctahedral(Vector2f const& encoded) -> Vector3f;
+
+// octahedral snorm of the given type, of the 4 roundings of the map coordinates the one which decodes closest to normal
+template <typename I>
+auto EncodeOctahedralSnorm(Vector3f const& normal, I (&encoded)[2]) -> void {
+    auto const max = static_cast<Float32>(std::numeric_limits<I>::max());
+    auto const p = EncodeOctahedral(normal);
+    auto bestError = std::numeric_limits<Float32>::max();
+    for (auto i = 0u; i < 4; ++i) {
+        auto x = (i & 1u) == 0 ? std::floor(p(0) * max) : std::ceil(p(0) * max);
+        auto y = (i & 2u) == 0 ? std::floor(p(1) * max) : std::ceil(p(1) * max);
+        I candidate[2] = { static_cast<I>(std::max(x, -max)), static_cast<I>(std::max(y, -max)) };
+        auto decoded = DecodeOctahedral(Vector2f{ DecodeSnorm(candidate[0]), DecodeSnorm(candidate[1]) });
+        auto error = std::abs(decoded(0) - normal(0)) + std::abs(decoded(1) - normal(1)) + std::abs(decoded(2) - normal(2));
+        if (error < bestError) {
+            bestError = error;
+            encoded[0] = candidate[0];
+            encoded[1] = candidate[1];
+        }
+    }
+}
+
+template <typename I>
+auto DecodeOctahedralSnorm(I const (&encoded)[2]) -> Vector3f {
+    return DecodeOctahedral(Vector2f{ DecodeSnorm(encoded[0]), DecodeSnorm(encoded[1]) });
+}
+
+// positions are stored relative to center, divided by halfExtent
+struct QuantizationBounds {
+    Vector3f center;
+    Vector3f halfExtent;
+
+    static auto FromVertexes(std::vector<Vertex> const& vertexes) -> QuantizationBounds;
+};
+
+// 16 bytes, for passes which need all attributes
+struct VertexQ16 {
+    int16 coord[4]; // w is unused
+    int16 normal[2];
+    uint16 texCoord[2];
+
+    static auto Encode(Vertex const& vertex, QuantizationBounds const& bounds) -> VertexQ16;
+    auto Decode(QuantizationBounds const& bounds) const -> Vertex;
+};
+static_assert(sizeof(VertexQ16) == 16, "VertexQ16 is tightly packed");
+
+// 8 bytes, positions only for depth and shadow passes
+struct VertexCoordQ8 {
+    int16 coord[4]; // w is unused
+
+    static auto Encode(Vertex const& vertex, QuantizationBounds const& bounds) -> VertexCoordQ8;
+    // normal and texture coordinate are 0
+    auto Decode(QuantizationBounds const& bounds) const -> Vertex;
+};
+static_assert(sizeof(VertexCoordQ8) == 8, "VertexCoordQ8 is tightly packed");
+
+template <typename T>
+auto EncodeVertexes(std::vector<Vertex> const& vertexes, QuantizationBounds const& bounds) -> std::vector<T> {
+    auto ret = std::vector<T>{};
+    ret.reserve(vertexes.size());
+    for (auto const& vertex : vertexes) {
+        ret.push_back(T::Encode(vertex, bounds));
+    }
+    return ret;
+}
+
+template <typename T>
+auto DecodeVertexes(std::vector<T> const& vertexes, QuantizationBounds const& bounds) -> std::vector<Vertex> {
+    auto ret = std::vector<Vertex>{};
+    ret.reserve(vertexes.size());
+    for (auto const& vertex : vertexes) {
+        ret.push_back(vertex.Decode(bounds));
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cmath>
+
+#include "Matrix.h"
+
+namespace core {
+
+// unit quaternion representing a rotation, x, y, z is the vector part and w the scalar part
+struct Quaternion {
+public:
+    Float32 x = 0.0f;
+    Float32 y = 0.0f;
+    Float32 z = 0.0f;
+    Float32 w = 1.0f;
+public:
+    // counterclockwise rotation by angle around axis (x, y, z), which need not be normalized
+    static auto FromAxisAngle(Float32 axisX, Float32 axisY, Float32 axisZ, Float32 angle) -> Quaternion {
+        auto length = std::sqrt(axisX * axisX + axisY * axisY + axisZ * axisZ);
+        if (length == 0.0f) {
+            return Quaternion{};
+        }
+        auto s = std::sin(angle * 0.5f) / length;
+        return Quaternion{ axisX * s, axisY * s, axisZ * s, std::cos(angle * 0.5f) };
+    }
+    // rotation of an orthonormal row major 3x3 matrix, from the largest of w, x, y, z to keep the division accurate
+    static auto FromMatrix3x3(Float32 const (&m)[3][3]) -> Quaternion {
+        auto trace = m[0][0] + m[1][1] + m[2][2];
+        if (trace > 0.0f) {
+            auto s = 2.0f * std::sqrt(1.0f + trace);
+            return Quaternion{ (m[2][1] - m[1][2]) / s, (m[0][2] - m[2][0]) / s, (m[1][0] - m[0][1]) / s, 0.25f * s };
+        }
+        if (m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+            auto s = 2.0f * std::sqrt(1.0f + m[0][0] - m[1][1] - m[2][2]);
+            return Quaternion{ 0.25f * s, (m[0][1] + m[1][0]) / s, (m[0][2] + m[2][0]) / s, (m[2][1] - m[1][2]) / s };
+        }
+        if (m[1][1] > m[2][2]) {
+            auto s = 2.0f * std::sqrt(1.0f + m[1][1] - m[0][0] - m[2][2]);
+            return Quaternion{ (m[0][1] + m[1][0]) / s, 0.25f * s, (m[1][2] + m[2][1]) / s, (m[0][2] - m[2][0]) / s };
+        }
+        auto s = 2.0f * std::sqrt(1.0f + m[2][2] - m[0][0] - m[1][1]);
+        return Quaternion{ (m[0][2] + m[2][0]) / s, (m[1][2] + m[2][1]) / s, 0.25f * s, (m[1][0] - m[0][1]) / s };
+    }
+    // rotation by rhs followed by rotation by this
+    auto operator*(Quaternion const& rhs) const -> Quaternion {
+        return Quaternion{
+            w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+            w * rhs.y - x * rhs.z + y * rhs.w + z * rhs.x,
+            w * rhs.z + x * rhs.y - y * rhs.x + z * rhs.w,
+            w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z,
+        };
+    }
+    // inverse of a unit quaternion
+    auto Conjugate() const -> Quaternion {
+        return Quaternion{ -x, -y, -z, w };
+    }
+    // composed rotations drift from unit length through rounding, renormalize after composing
+    auto Normalize() const -> Quaternion {
+        auto lengthInverse = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+        return Quaternion{ x * lengthInverse, y * lengthInverse, z * lengthInverse, w * lengthInverse };
+    }
+    // v + 2w(q x v) + 2q x (q x v), q being the vector part
+    auto Rotate(Vector3f const& v) const -> Vector3f {
+        auto tx = 2 * (y * v(2) - z * v(1));
+        auto ty = 2 * (z * v(0) - x * v(2));
+        auto tz = 2 * (x * v(1) - y * v(0));
+        return Vector3f{
+            v(0) + w * tx + y * tz - z * ty,
+            v(1) + w * ty + z * tx - x * tz,
+            v(2) + w * tz + x * ty - y * tx,
+        };
+    }
+    // upper-left 3x3 of the rotation matrix, row major
+    auto ToMatrix3x3(Float32 (&m)[3][3]) const -> void {
+        auto xx = x * x, yy = y * y, zz = z * z;
+        auto xy = x * y, xz = x * z, yz = y * z;
+        auto wx = w * x, wy = w * y, wz = w * z;
+        m[0][0] = 1 - 2 * (yy + zz);
+        m[0][1] = 2 * (xy - wz);
+        m[0][2] = 2 * (xz + wy);
+        m[1][0] = 2 * (xy + wz);
+        m[1][1] = 1 - 2 * (xx + zz);
+        m[1][2] = 2 * (yz - wx);
+        m[2][0] = 2 * (xz - wy);
+        m[2][1] = 2 * (yz + wx);
+        m[2][2] = 1 - 2 * (xx + yy);
+    }
+};
+
+}
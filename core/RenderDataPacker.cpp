@@ -0,0 +1,56 @@
+#include "RenderDataPacker.h"
+
+#include <cstring>
+
+namespace core {
+
+namespace {
+
+auto PackTransform(Movable const& movable, PackedTransform * dest) -> void {
+    auto const& world = movable.GetTransform();
+    auto packed = PackedTransform{};
+    for (auto r = 0u; r < 3; ++r) {
+        for (auto c = 0u; c < 4; ++c) {
+            packed.worldTransform(r, c) = world(r, c);
+        }
+    }
+    std::memcpy(dest, &packed, sizeof(PackedTransform));
+}
+
+}
+
+auto PackTransforms(Movable * const* movables, unsigned int count, PackedTransform * dest) -> void {
+    for (auto i = 0u; i < count; ++i) {
+        PackTransform(*movables[i], dest + i);
+    }
+}
+
+auto PackTransforms(Movable * const* movables, TransformChangeTracker::Range const* ranges, unsigned int rangeCount, PackedTransform * dest) -> void {
+    for (auto r = 0u; r < rangeCount; ++r) {
+        auto const& range = ranges[r];
+        PackTransforms(movables + range.first, range.count, dest + range.first);
+    }
+}
+
+auto PackMaterials(Material * const* materials, unsigned int count, PackedMaterial * dest) -> void {
+    for (auto i = 0u; i < count; ++i) {
+        auto const& material = *materials[i];
+        auto flags = uint32{ 0u };
+        flags |= material._hasDiffuseMap ? PackedMaterial::HasDiffuseMap : 0u;
+        flags |= material._hasEmissiveMap ? PackedMaterial::HasEmissiveMap : 0u;
+        flags |= material._hasSpecularMap ? PackedMaterial::HasSpecularMap : 0u;
+        flags |= material._hasNormalMap ? PackedMaterial::HasNormalMap : 0u;
+        // assemble on the stack, then write the whole element at once
+        auto const packed = PackedMaterial{
+            material.GetDiffuse(),
+            flags,
+            material.GetEmissive(),
+            material.GetShininess(),
+            material.GetSpecular(),
+            material.GetTransparency(),
+        };
+        std::memcpy(dest + i, &packed, sizeof(PackedMaterial));
+    }
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Primitive.h"
+#include "Matrix.h"
+#include "Movable.h"
+#include "Material.h"
+#include "TransformChangeTracker.h"
+
+namespace core {
+
+// Tightly packed per object data for renderers which bind one structured buffer of transforms and one of materials
+// and fetch them by instance or draw id, instead of one 256 byte aligned constant buffer per object.
+
+// first 3 rows of the world transform, row major; the last row of an affine transform is always 0, 0, 0, 1. Shaders
+// transform normals by the cofactor matrix of the upper 3x3, which they compute from cross products of its rows.
+struct PackedTransform {
+    Matrix3x4f worldTransform;
+};
+static_assert(sizeof(PackedTransform) == 48, "transforms are fetched from a structured buffer with a 48 byte stride");
+
+struct PackedMaterial {
+    enum Flag : uint32 {
+        HasDiffuseMap = 0x1u,
+        HasEmissiveMap = 0x2u,
+        HasSpecularMap = 0x4u,
+        HasNormalMap = 0x8u,
+    };
+    Vector3f diffuse;
+    uint32 flags;
+    Vector3f emissive;
+    Float32 shininess;
+    Vector3f specular;
+    Float32 transparency;
+};
+static_assert(sizeof(PackedMaterial) == 48, "materials are fetched from a structured buffer with a 48 byte stride");
+
+// The packers write every element once and in order and never read dest back, so dest can be mapped write-combined
+// upload memory.
+auto PackTransforms(Movable * const* movables, unsigned int count, PackedTransform * dest) -> void;
+// only the given ranges of movables, each written at the movables' index in dest
+auto PackTransforms(Movable * const* movables, TransformChangeTracker::Range const* ranges, unsigned int rangeCount, PackedTransform * dest) -> void;
+auto PackMaterials(Material * const* materials, unsigned int count, PackedMaterial * dest) -> void;
+
+}
@@ -13,8 +13,24 @@ auto Renderer::DrawScene(Renderer * renderer, Scene const * scene) -> void {
     if (nullptr != scene->_terrain) {
         renderer->DrawTerrain(scene->_terrain.get());
     }
-    for (auto const& shape : scene->_staticModelGroup->GetShapes()) {
-        renderer->Render(shape.get());
+    // only shapes intersecting the view frustum and not hidden by the largest of them are drawn, the list is rebuilt every frame
+    auto & visibleShapes = renderer->_visibleShapes;
+    visibleShapes.clear();
+    auto const* bvh = scene->_staticModelGroup->GetBvh();
+    auto const* camera = scene->GetActiveCamera();
+    if (bvh != nullptr && camera != nullptr) {
+        auto frustum = camera->GetViewFrustum();
+        bvh->CullFrustum(frustum, visibleShapes);
+        renderer->_occlusionBuffer.Render(camera->GetViewProjectTransform(), camera->GetPosition(), visibleShapes.data(), visibleShapes.size());
+        visibleShapes.clear();
+        bvh->CullFrustum(frustum, visibleShapes, &renderer->_occlusionBuffer);
+    } else {
+        for (auto const& shape : scene->_staticModelGroup->GetShapes()) {
+            visibleShapes.push_back(shape.get());
+        }
+    }
+    for (auto const* shape : visibleShapes) {
+        renderer->Render(shape);
     }
     if (scene->_drawBvh) {
         auto const& aabbs = scene->_staticModelGroup->GetBvh()->GetAabbs();
@@ -75,7 +91,7 @@ auto Renderer::Render(Shape const* shape) -> void {
     auto const& meshRenderData = mesh->GetRenderData();
 
     glBindVertexArray(meshRenderData._vao);
-    glDrawElementsBaseVertex(GL_TRIANGLES, mesh->GetIndex().size(), GL_UNSIGNED_INT, reinterpret_cast<GLvoid*>(meshRenderData._indexOffset), meshRenderData._baseVertex);
+    glDrawElementsBaseVertex(GL_TRIANGLES, mesh->GetIndex().size(), meshRenderData._indexType, reinterpret_cast<GLvoid*>(meshRenderData._indexOffset), meshRenderData._baseVertex);
     glBindVertexArray(0);
 
     auto error = glGetError();
@@ -124,7 +140,7 @@ auto Renderer::DrawTerrain(Terrain const * terrain) -> void {
     for (auto & mesh : terrain->GetSpecialTiles()) {
         auto const& renderData = mesh->GetRenderData();
         glBindVertexArray(renderData._vao);
-        glDrawElementsBaseVertex(GL_PATCHES, mesh->GetIndex().size(), GL_UNSIGNED_INT, reinterpret_cast<GLvoid*>(renderData._indexOffset), renderData._baseVertex);
+        glDrawElementsBaseVertex(GL_PATCHES, mesh->GetIndex().size(), renderData._indexType, reinterpret_cast<GLvoid*>(renderData._indexOffset), renderData._baseVertex);
         glBindVertexArray(0);
     }
     auto error = glGetError();
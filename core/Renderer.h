@@ -1,11 +1,14 @@
 #pragma once
 
+#include <thread>
+
 #include "Scene.h"
 #include "Shape.h"
 #include "SkyBox.h"
 #include "ShaderProgram.h"
 #include "TextureArray.h"
 #include "Terrain.h"
+#include "OcclusionBuffer.h"
 
 namespace core {
 class IRenderer {
@@ -39,6 +42,8 @@ private:
 private:
     ShaderProgram const* _currentShaderProgram = nullptr;
     std::vector<std::unique_ptr<ShaderProgram>> _shaderPrograms;
+    std::vector<Shape *> _visibleShapes;
+    OcclusionBuffer _occlusionBuffer{ std::thread::hardware_concurrency() };
     bool _wireframeMode = false;
     bool _renderBackFace = false;
 };
@@ -4,11 +4,21 @@
 
 #include <GL/glew.h>
 
+#include "IndexBuffer.h"
+
 using std::vector;
 using std::unique_ptr;
 
 namespace core {
 
+namespace {
+
+auto GetIndexType(IndexFormat format) -> openglEnum {
+    return format == IndexFormat::Uint16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+}
+
 auto ResourceManager::UpdateScene(ResourceManager * resourceManager, Scene const* scene) -> void {
     //updates
     resourceManager->UpdateCameraData(scene->_cameras);
@@ -76,18 +86,21 @@ auto ResourceManager::LoadMeshes(vector<unique_ptr<Mesh<Vertex>>> const& meshes)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vertexBuffer._veo);
 
     auto vertexData = vector<Vertex>();
-    auto indexData = vector<unsigned int>();
-    for (auto const& mesh : meshes) {
+    auto const indexLayout = LayoutIndexBuffer(meshes.cbegin(), meshes.cend());
+    auto indexData = vector<uint8>(indexLayout.GetSize());
+    WriteIndexBuffer(meshes.cbegin(), meshes.cend(), indexLayout, indexData.data());
+    for (auto i = 0u; i < meshes.size(); ++i) {
+        auto const& mesh = meshes[i];
         mesh->SetRenderData(Mesh<Vertex>::RenderData{
             vertexBuffer._vao,
-            indexData.size() * sizeof(unsigned int),
+            indexLayout.GetByteOffset(i),
             static_cast<GLint>(vertexData.size()),
+            GetIndexType(mesh->GetIndexFormat()),
         });
         vertexData.insert(vertexData.end(), mesh->GetVertex().cbegin(), mesh->GetVertex().cend());
-        indexData.insert(indexData.end(), mesh->GetIndex().cbegin(), mesh->GetIndex().cend());
     }
     glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(Vertex), vertexData.data(), GL_STATIC_DRAW);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size() * sizeof(unsigned int), indexData.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size(), indexData.data(), GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)0);
     glEnableVertexAttribArray(0);
@@ -380,24 +393,27 @@ auto ResourceManager::LoadTerrainSpecialTiles(std::vector<Mesh<Vertex> *> terrai
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vertexBuffer._veo);
 
     auto vertexData = vector<Vector2f>();
-    auto indexData = vector<unsigned int>();
-    for (auto mesh : terrainSpecialTiles) {
+    auto const indexLayout = LayoutIndexBuffer(terrainSpecialTiles.cbegin(), terrainSpecialTiles.cend());
+    auto indexData = vector<uint8>(indexLayout.GetSize());
+    WriteIndexBuffer(terrainSpecialTiles.cbegin(), terrainSpecialTiles.cend(), indexLayout, indexData.data());
+    for (auto i = 0u; i < terrainSpecialTiles.size(); ++i) {
+        auto mesh = terrainSpecialTiles[i];
         mesh->SetRenderData(Mesh<Vertex>::RenderData{
             vertexBuffer._vao,
-            indexData.size() * sizeof(unsigned int),
+            indexLayout.GetByteOffset(i),
             static_cast<openglInt>(vertexData.size()),
+            GetIndexType(mesh->GetIndexFormat()),
         });
         for (auto const& vertex : mesh->GetVertex()) {
             vertexData.push_back(Vector2f{ vertex.coord(0), vertex.coord(1) });
         }
-        indexData.insert(indexData.end(), mesh->GetIndex().cbegin(), mesh->GetIndex().cend());
     }
     auto tileCoordData = vector<Vector2i>(vertexData.size(), Vector2i{ 0, 0 });
     glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(Vector2f) + tileCoordData.size() * sizeof(Vector2i), vertexData.data(), GL_STATIC_DRAW);
     glBufferSubData(GL_ARRAY_BUFFER, 0, vertexData.size() * sizeof(Vector2f), vertexData.data());
     glBufferSubData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(Vector2f), tileCoordData.size() * sizeof(Vector2i), tileCoordData.data());
 
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size() * sizeof(unsigned int), indexData.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size(), indexData.data(), GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vector2f), (GLvoid*)0);
     glEnableVertexAttribArray(0);
@@ -1,9 +1,10 @@
 #include "Scene.h"
 
 #include <algorithm>
-#include <stack>
+#include <limits>
+#include <utility>
 
-#include "Triangle.h"
+#include "MeshBvh.h"
 
 using std::string;
 using std::make_unique;
@@ -11,6 +12,212 @@ using std::array;
 
 namespace core {
 
+namespace {
+
+// Conservative bounds of a packet's origins and reciprocal directions. Testing them against a node
+// gives a lower bound of every ray's entry distance and an upper bound of every exit distance, so a
+// miss culls the node for the whole packet without testing single rays.
+struct PacketInterval {
+public:
+    Float32 originMin[3];
+    Float32 originMax[3];
+    Float32 inverseDirectionMin[3];
+    Float32 inverseDirectionMax[3];
+    Float32 length; // of the longest ray
+public:
+    auto IntersectNode(BvhNode const& node) const -> bool {
+        auto tNear = std::numeric_limits<Float32>::lowest();
+        auto tFar = std::numeric_limits<Float32>::max();
+        for (auto axis = 0u; axis < 3; ++axis) {
+            Float32 t1[2];
+            Float32 t2[2];
+            Multiply(node.minVertex[axis] - originMax[axis], node.minVertex[axis] - originMin[axis], axis, t1);
+            Multiply(node.maxVertex[axis] - originMax[axis], node.maxVertex[axis] - originMin[axis], axis, t2);
+            // all directions share their sign on this axis, which tells the entering plane
+            if (inverseDirectionMin[axis] > 0) {
+                tNear = std::max(tNear, t1[0]);
+                tFar = std::min(tFar, t2[1]);
+            } else {
+                tNear = std::max(tNear, t2[0]);
+                tFar = std::min(tFar, t1[1]);
+            }
+        }
+        return tFar >= 0 && tNear <= tFar && tNear < length;
+    }
+private:
+    // interval product of [min, max] with the inverse directions on axis
+    auto Multiply(Float32 min, Float32 max, unsigned int axis, Float32 result[2]) const -> void {
+        auto p0 = min * inverseDirectionMin[axis];
+        auto p1 = min * inverseDirectionMax[axis];
+        auto p2 = max * inverseDirectionMin[axis];
+        auto p3 = max * inverseDirectionMax[axis];
+        result[0] = std::min(std::min(p0, p1), std::min(p2, p3));
+        result[1] = std::max(std::max(p0, p1), std::max(p2, p3));
+    }
+};
+
+// false if directions of the rays differ in sign on any axis, such packets are too incoherent to share traversal
+auto MakePacketInterval(Ray const* rays, SlabRay const* slabRays, unsigned int count, PacketInterval & interval) -> bool {
+    Float32 inverseDirection[4];
+    _mm_storeu_ps(inverseDirection, slabRays[0].inverseDirection);
+    for (auto axis = 0u; axis < 3; ++axis) {
+        interval.originMin[axis] = interval.originMax[axis] = rays[0].origin(axis);
+        interval.inverseDirectionMin[axis] = interval.inverseDirectionMax[axis] = inverseDirection[axis];
+    }
+    interval.length = rays[0].length;
+    for (auto i = 1u; i < count; ++i) {
+        _mm_storeu_ps(inverseDirection, slabRays[i].inverseDirection);
+        for (auto axis = 0u; axis < 3; ++axis) {
+            if ((inverseDirection[axis] > 0) != (interval.inverseDirectionMin[axis] > 0)) {
+                return false;
+            }
+            interval.originMin[axis] = std::min(interval.originMin[axis], rays[i].origin(axis));
+            interval.originMax[axis] = std::max(interval.originMax[axis], rays[i].origin(axis));
+            interval.inverseDirectionMin[axis] = std::min(interval.inverseDirectionMin[axis], inverseDirection[axis]);
+            interval.inverseDirectionMax[axis] = std::max(interval.inverseDirectionMax[axis], inverseDirection[axis]);
+        }
+        interval.length = std::max(interval.length, rays[i].length);
+    }
+    return true;
+}
+
+// updates hit with the closest triangle of the leaf's instances hit by ray, shortening slabRay to it
+auto IntersectLeaf(Bvh const& bvh, BvhNode const& leaf, Ray const& ray, SlabRay & slabRay, Scene::Hit & hit) -> void {
+    auto const& instances = bvh.GetInstances();
+    auto const leafEnd = leaf.offset + leaf.primitiveCount;
+    // test AABBs of the leaf's instances 4 at a time
+    for (auto first = leaf.offset; first < leafEnd; first += 4) {
+        Float32 distanceToShapeAabb[4];
+        auto count = std::min(4u, leafEnd - first);
+        auto hitMask = bvh.IntersectInstances(slabRay, first, distanceToShapeAabb) & ((1 << count) - 1);
+        while (hitMask != 0) {
+            // nearest instance first
+            auto nearest = 0u;
+            while ((hitMask & (1 << nearest)) == 0) {
+                ++nearest;
+            }
+            for (auto i = nearest + 1; i < count; ++i) {
+                if ((hitMask & (1 << i)) != 0 && distanceToShapeAabb[i] < distanceToShapeAabb[nearest]) {
+                    nearest = i;
+                }
+            }
+            hitMask &= ~(1 << nearest);
+            auto const& instance = instances[first + nearest];
+            // transform ray into model space once, and let mesh BVH find triangles. distances along the ray
+            // are measured in multiples of its direction, so they are the same in both spaces.
+            auto modelSpaceRay = Ray{
+                static_cast<Point4f>(instance.transformInverse * ray.origin),
+                static_cast<Vector4f>(instance.transformInverse * ray.direction),
+                slabRay.length,
+            };
+            auto triangleIndex = 0u;
+            auto u = 0.0f;
+            auto v = 0.0f;
+            auto distanceToTriangle = instance.meshBvh->IntersectRay(modelSpaceRay, triangleIndex, u, v);
+            if (distanceToTriangle > 0 && (hit.shape == nullptr || distanceToTriangle < hit.distance)) {
+                hit = Scene::Hit{ instance.shape, triangleIndex, distanceToTriangle, u, v };
+                // drop the remaining instances that start beyond the new hit
+                slabRay.length = distanceToTriangle;
+                hitMask &= bvh.IntersectInstances(slabRay, first, distanceToShapeAabb);
+            }
+        }
+    }
+}
+
+// single ray closest-hit traversal of the subtree rooted at rootIndex: nodes are visited front to back,
+// every hit shortens the ray and nodes entered beyond it are skipped
+auto PickRay(Bvh const& bvh, unsigned int rootIndex, Ray const& ray, SlabRay & slabRay, Scene::Hit & hit) -> void {
+    auto const& nodes = bvh.GetNodes();
+    auto nodeStack = array<unsigned int, Bvh::MaxDepth>{};
+    auto stackSize = 0u;
+    nodeStack[stackSize++] = rootIndex;
+    while (stackSize > 0) {
+        auto nodeIndex = nodeStack[--stackSize];
+        auto const& currentNode = nodes[nodeIndex];
+        if (currentNode.IntersectRay(slabRay) < 0) {
+            continue;
+        }
+        if (!currentNode.IsLeaf()) {
+            auto nearChild = 0u;
+            auto farChild = 0u;
+            currentNode.GetOrderedChildren(nodeIndex, slabRay, nearChild, farChild);
+            nodeStack[stackSize++] = farChild;
+            nodeStack[stackSize++] = nearChild;
+            continue;
+        }
+        IntersectLeaf(bvh, currentNode, ray, slabRay, hit);
+    }
+}
+
+constexpr const unsigned int PacketSize = 16u;
+
+// traverses up to PacketSize rays together front to back: a node is visited once for all rays that hit it,
+// and the rays that hit it are tested against its children. rays of incoherent packets,
+// and the last active ray of a packet, continue alone.
+auto PickPacket(Bvh const& bvh, Ray const* rays, Scene::Hit * hits, unsigned int count) -> void {
+    SlabRay slabRays[PacketSize];
+    for (auto i = 0u; i < count; ++i) {
+        slabRays[i] = SlabRay{ rays[i] };
+    }
+    auto interval = PacketInterval{};
+    if (count == 1 || !MakePacketInterval(rays, slabRays, count, interval)) {
+        for (auto i = 0u; i < count; ++i) {
+            PickRay(bvh, 0u, rays[i], slabRays[i], hits[i]);
+        }
+        return;
+    }
+    auto const& nodes = bvh.GetNodes();
+    // node index and mask of active rays
+    auto nodeStack = array<std::pair<unsigned int, unsigned int>, Bvh::MaxDepth>{};
+    auto stackSize = 0u;
+    nodeStack[stackSize++] = std::make_pair(0u, (1u << count) - 1);
+    while (stackSize > 0) {
+        auto nodeIndex = nodeStack[stackSize - 1].first;
+        auto activeMask = nodeStack[stackSize - 1].second;
+        --stackSize;
+        auto const& currentNode = nodes[nodeIndex];
+        if (!interval.IntersectNode(currentNode)) {
+            continue;
+        }
+        auto hitMask = 0u;
+        auto lastHit = 0u;
+        for (auto i = 0u; i < count; ++i) {
+            if ((activeMask & (1u << i)) == 0) {
+                continue;
+            }
+            if (currentNode.IntersectRay(slabRays[i]) >= 0) {
+                hitMask |= 1u << i;
+                lastHit = i;
+            }
+        }
+        if (hitMask == 0) {
+            continue;
+        }
+        if ((hitMask & (hitMask - 1)) == 0) {
+            PickRay(bvh, nodeIndex, rays[lastHit], slabRays[lastHit], hits[lastHit]);
+            continue;
+        }
+        if (!currentNode.IsLeaf()) {
+            // rays of the packet share direction signs, so they agree on the nearer child
+            auto nearChild = 0u;
+            auto farChild = 0u;
+            currentNode.GetOrderedChildren(nodeIndex, slabRays[lastHit], nearChild, farChild);
+            nodeStack[stackSize++] = std::make_pair(farChild, hitMask);
+            nodeStack[stackSize++] = std::make_pair(nearChild, hitMask);
+            continue;
+        }
+        interval.length = 0.0f;
+        for (auto i = 0u; i < count; ++i) {
+            if ((hitMask & (1u << i)) != 0) {
+                IntersectLeaf(bvh, currentNode, rays[i], slabRays[i], hits[i]);
+            }
+            interval.length = std::max(interval.length, slabRays[i].length);
+        }
+    }
+}
+
+}
+
 Scene::Scene() {
     _staticModelGroup = make_unique<StaticModelGroup>();
 }
@@ -77,89 +284,71 @@ auto Scene::CreateSkyBox(std::string const & filename) -> void {
 }
 
 auto Scene::Picking(Ray & ray) -> bool {
-    auto ret = false;
-    auto resultLength = ray.length;
-    auto bvhRoot = _staticModelGroup->GetBvh()->GetRoot();
-    auto nodeStack = std::stack<BvhNode *>{};
-    nodeStack.push(bvhRoot);
-    while (!nodeStack.empty()) {
-        auto currentNode = nodeStack.top();
-        nodeStack.pop();
-        auto length = currentNode->GetAabb().IntersectRay(ray);
-        if (length < 0) {
-            continue;
-        }
-        if (currentNode->RightChild() != nullptr) {
-            nodeStack.push(currentNode->RightChild());
-        }
-        if (currentNode->LeftChild() != nullptr) {
-            nodeStack.push(currentNode->LeftChild());
-        }
-        if (currentNode->IsLeaf()) {
-            auto shapes = currentNode->GetShapes();
-            for (auto shape : shapes) {
-                auto distanceToShapeAabb = shape->GetAabb().IntersectRay(ray);
-                if (distanceToShapeAabb < 0) {
-                    continue;
-                }
-                auto const& vertex = shape->GetMesh()->GetVertex();
-                auto const& index = shape->GetMesh()->GetIndex();
-                for (auto i = 0u; i < index.size(); i += 3) {
-                    auto const& transform = shape->GetModel()->GetTransform();
-                    auto index0 = index[i];
-                    auto index1 = index[i + 1];
-                    auto index2 = index[i + 2];
-                    auto triangle = array<Point4f, 3>{
-                        transform * Point4f{ vertex[index0].coord(0),vertex[index0].coord(1),vertex[index0].coord(2), 1.0f },
-                            transform * Point4f{ vertex[index1].coord(0),vertex[index1].coord(1),vertex[index1].coord(2), 1.0f },
-                            transform * Point4f{ vertex[index2].coord(0),vertex[index2].coord(1),vertex[index2].coord(2), 1.0f },
-                    };
-                    auto distanceToTriangleAabb = Triangle::IntersectRay(ray, triangle);
-                    if (distanceToTriangleAabb  > 0) {
-                        resultLength = std::min(resultLength, distanceToTriangleAabb);
-                        ret = true;
-                    }
-                }
-            }
-        }
+    auto const* bvh = _staticModelGroup->GetBvh();
+    if (bvh->GetNodes().empty()) {
+        return false;
+    }
+    auto hit = Hit{ nullptr, 0u, ray.length, 0.0f, 0.0f };
+    auto slabRay = SlabRay{ ray };
+    PickRay(*bvh, 0u, ray, slabRay, hit);
+    if (hit.shape == nullptr) {
+        return false;
+    }
+    ray.length = hit.distance;
+    return true;
+}
+
+auto Scene::PickBatch(Ray const* rays, Hit * hits, unsigned int count) -> void {
+    auto const* bvh = _staticModelGroup->GetBvh();
+    for (auto i = 0u; i < count; ++i) {
+        hits[i] = Hit{ nullptr, 0u, rays[i].length, 0.0f, 0.0f };
+    }
+    if (bvh->GetNodes().empty()) {
+        return;
+    }
+    for (auto first = 0u; first < count; first += PacketSize) {
+        PickPacket(*bvh, rays + first, hits + first, std::min(PacketSize, count - first));
     }
-    ray.length = resultLength;
-    return ret;
 }
 
 auto Scene::Intersect(Aabb & aabb) -> bool {
-    auto ret = false;
-    auto bvhRoot = _staticModelGroup->GetBvh()->GetRoot();
-    auto nodeStack = std::stack<BvhNode *>{};
-    nodeStack.push(bvhRoot);
-    while (!nodeStack.empty()) {
-        auto currentNode = nodeStack.top();
-        nodeStack.pop();
-        if (!aabb.IntersectAabb(currentNode->GetAabb())) {
+    auto const* bvh = _staticModelGroup->GetBvh();
+    auto const& nodes = bvh->GetNodes();
+    auto const& instances = bvh->GetInstances();
+    if (nodes.empty()) {
+        return false;
+    }
+    auto nodeStack = array<unsigned int, Bvh::MaxDepth>{};
+    auto stackSize = 0u;
+    nodeStack[stackSize++] = 0u;
+    while (stackSize > 0) {
+        auto const& currentNode = nodes[nodeStack[--stackSize]];
+        if (!currentNode.IntersectAabb(aabb)) {
             continue;
         }
-        if (currentNode->RightChild() != nullptr) {
-            nodeStack.push(currentNode->RightChild());
-        }
-        if (currentNode->LeftChild() != nullptr) {
-            nodeStack.push(currentNode->LeftChild());
+        if (!currentNode.IsLeaf()) {
+            auto currentIndex = static_cast<unsigned int>(&currentNode - nodes.data());
+            nodeStack[stackSize++] = currentNode.offset;
+            nodeStack[stackSize++] = currentIndex + 1;
+            continue;
         }
-        if (currentNode->IsLeaf()) {
-            auto shapes = currentNode->GetShapes();
-            for (auto shape : shapes) {
-                auto const& vertex = shape->GetMesh()->GetVertex();
-                auto const& index = shape->GetMesh()->GetIndex();
-                for (auto i = 0u; i < index.size(); i += 3) {
-                    auto const& transform = shape->GetModel()->GetTransform();
-                    auto intersected = aabb.IntersectTriangle(std::array<Point4f, 3>{
-                        transform * Point4f{ vertex[i].coord(0),vertex[i].coord(1),vertex[i].coord(2), 1.0f },
-                            transform * Point4f{ vertex[i + 1].coord(0),vertex[i + 1].coord(1),vertex[i + 1].coord(2), 1.0f },
-                            transform * Point4f{ vertex[i + 2].coord(0),vertex[i + 2].coord(1),vertex[i + 2].coord(2), 1.0f},
-                    });
-                    if (intersected) {
-                        return true;
-                    }
-                }
+        for (auto instanceIndex = currentNode.offset; instanceIndex < currentNode.offset + currentNode.primitiveCount; ++instanceIndex) {
+            auto const& instance = instances[instanceIndex];
+            if (!aabb.IntersectAabb(instance.aabb)) {
+                continue;
+            }
+            // query mesh BVH with aabb's bounding box in model space, test candidate triangles in world space
+            auto const& transform = instance.transform;
+            auto modelSpaceAabb = aabb.Transform(instance.transformInverse);
+            auto intersected = instance.meshBvh->ForEachTriangle(modelSpaceAabb, [&aabb, &transform](array<Point4f, 3> const& triangle, unsigned int) {
+                return aabb.IntersectTriangle(array<Point4f, 3>{
+                    transform * triangle[0],
+                    transform * triangle[1],
+                    transform * triangle[2],
+                });
+            });
+            if (intersected) {
+                return true;
             }
         }
     }
@@ -21,6 +21,16 @@
 namespace core {
 
 class Scene {
+public:
+    // closest hit of a ray, u and v are barycentric coordinates of the hit point weighting the triangle's 2nd and 3rd vertex
+    struct Hit {
+    public:
+        Shape * shape; // nullptr if missed
+        unsigned int triangleIndex; // index of triangle in shape's mesh
+        Float32 distance;
+        Float32 u;
+        Float32 v;
+    };
 public:
     Scene();
     Scene(Scene const&) = delete;
@@ -46,6 +56,9 @@ public:
     auto CreateSkyBox(std::array<std::string, 6>&& filenames) -> void;
     auto CreateSkyBox(std::string const& filename) -> void;
     auto Picking(Ray & ray) -> bool;
+    // picks count rays at once, hits[i] receives the closest hit of rays[i]. neighbouring rays are traversed
+    // together as packets, so pass them in coherent order, e.g. tile by tile or row by row of a grid.
+    auto PickBatch(Ray const* rays, Hit * hits, unsigned int count) -> void;
     auto Intersect(Aabb & aabb) -> bool;
 
     auto ToggleBvh() -> void;
@@ -7,46 +7,77 @@ using std::unique_ptr;
 namespace core {
 
 SceneNode::SceneNode() = default;
-SceneNode::~SceneNode() = default;
-
-auto SceneNode::MoveAlong(Vector4f const& forwardDirection, Float32 length) -> void {
-    _transform = _transform * Matrix4x4f{
-        1, 0, 0, forwardDirection(0) * length,
-        0, 1, 0, forwardDirection(1) * length,
-        0, 0, 1, forwardDirection(2) * length,
-        0, 0, 0, 1
-    };
+SceneNode::~SceneNode() {
+    // children keep their local transforms as world transforms
+    if (_parent != nullptr) {
+        _parent->_children.remove(this);
+    }
     for (auto c : _children) {
-        c->MoveAlong(forwardDirection, length);
+        c->_parent = nullptr;
+        c->_dirty = true;
     }
 }
 
+auto SceneNode::MoveAlong(Vector4f const& forwardDirection, Float32 length) -> void {
+    _transform.MoveAlong(Vector3f{ forwardDirection(0) * length, forwardDirection(1) * length, forwardDirection(2) * length });
+    _dirty = true;
+}
+
 auto SceneNode::Translate(Float32 x, Float32 y, Float32 z) -> void {
-    _transform = Matrix4x4f{
-        1, 0, 0, x,
-        0, 1, 0, y,
-        0, 0, 1, z,
-        0, 0, 0, 1
-    } *_transform;
-    for (auto c : _children) {
-        c->Translate(x, y, z);
-    }
+    _transform.Translate(x, y, z);
+    _dirty = true;
 }
 
 auto SceneNode::Rotate(Float32 x, Float32 y, Float32 z, Float32 r, bool rotateSelf) -> void {
-    auto a = cos(r);
-    auto b = sin(r);
-    auto c = 1 - a;
-    auto rotateMatrix = Matrix4x4f{
-        a + c*x*x,		c*x*y - b*z,	c*x*z + b*y,	0,
-        c*x*y + b*z,	a + c*y*y,		c*y*z - b*x,	0,
-        c*x*z - b*y,	c*y*z + b*x,	a + c*z*z,		0,
-        0,				0,				0,				1
-    };
-    _transform = rotateSelf ? _transform * rotateMatrix : rotateMatrix *_transform;
-    for (auto c : _children) {
-        c->Rotate(x, y, z, r, rotateSelf);
+    auto rotation = Quaternion::FromAxisAngle(x, y, z, r);
+    if (rotateSelf) {
+        _transform.RotateSelf(rotation);
+    } else {
+        _transform.Rotate(rotation);
+    }
+    _dirty = true;
+}
+
+auto SceneNode::Scale(Float32 x, Float32 y, Float32 z) -> void {
+    _transform.Scale(x, y, z);
+    _dirty = true;
+}
+
+auto SceneNode::SetParent(SceneNode * parent) -> void {
+    if (_parent != nullptr) {
+        _parent->_children.remove(this);
+    }
+    _parent = parent;
+    if (_parent != nullptr) {
+        _parent->_children.push_front(this);
+    }
+    _dirty = true;
+}
+
+auto SceneNode::GetWorldMatrix() const -> Matrix4x4f const& {
+    UpdateWorld();
+    return _world;
+}
+
+auto SceneNode::GetWorldVersion() const -> unsigned int {
+    UpdateWorld();
+    return _version;
+}
+
+auto SceneNode::UpdateWorld() const -> void {
+    // walks up to the root to find out whether an ancestor moved, descendants of a moved node are not visited
+    auto parentVersion = 0u;
+    if (_parent != nullptr) {
+        _parent->UpdateWorld();
+        parentVersion = _parent->_version;
+    }
+    if (!_dirty && parentVersion == _parentVersion) {
+        return;
     }
+    _world = _parent == nullptr ? _transform.ToMatrix() : _parent->_world * _transform.ToMatrix();
+    _parentVersion = parentVersion;
+    _dirty = false;
+    ++_version;
 }
 
 }
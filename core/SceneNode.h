@@ -5,6 +5,7 @@
 #include <forward_list>
 
 #include "Matrix.h"
+#include "Transform.h"
 
 namespace core {
 
@@ -19,14 +20,27 @@ public:
     ~SceneNode();
 
 private:
+    // operations on the transform relative to the parent, children follow through their world transforms
     auto MoveAlong(Vector4f const& forwardDirection, Float32 length) -> void;
     auto Translate(Float32, Float32, Float32) -> void;
     auto Rotate(Float32 x, Float32 y, Float32 z, Float32 r, bool rotateSelf) -> void;
+    auto Scale(Float32 x, Float32 y, Float32 z) -> void;
+    auto SetParent(SceneNode * parent) -> void;
+    // world matrix is the parent's world matrix times the local one, recomputed on first use after either changed.
+    // not thread safe, call from one thread before others read it
+    auto GetWorldMatrix() const -> Matrix4x4f const&;
+    // incremented whenever the world matrix changes
+    auto GetWorldVersion() const -> unsigned int;
+    auto UpdateWorld() const -> void;
 
 private:
     SceneNode* _parent = nullptr;
     std::forward_list<SceneNode*> _children;
-    Matrix4x4f _transform;
+    Transform _transform; // relative to the parent
+    mutable bool _dirty = false; // _transform or _parent changed since _world was computed
+    mutable Matrix4x4f _world;
+    mutable unsigned int _version = 0u;
+    mutable unsigned int _parentVersion = 0u; // version of the parent's world matrix _world was computed from
 };
 
 }
\ No newline at end of file
@@ -10,9 +10,12 @@
 #include "Model.h"
 #include "ShaderProgram.h"
 #include "Aabb.h"
+#include "PointTransform.h"
 
 namespace core {
 
+class MeshBvh;
+
 class Shape {
     friend class Scene;
 public:
@@ -26,6 +29,9 @@ public:
     auto SetMesh(Mesh<Vertex> * mesh) -> void {
         _mesh = mesh;
     }
+    auto SetMeshBvh(MeshBvh const* meshBvh) -> void {
+        _meshBvh = meshBvh;
+    }
     auto SetShaderProgram(ShaderProgram * shaderProgram) -> void {
         _shaderProgram = shaderProgram;
     }
@@ -35,6 +41,9 @@ public:
     auto GetMesh() const -> Mesh<Vertex> const* {
         return _mesh;
     }
+    auto GetMeshBvh() const -> MeshBvh const* {
+        return _meshBvh;
+    }
     auto GetShaderProgram() const -> ShaderProgram const * {
         return _shaderProgram;
     }
@@ -48,23 +57,23 @@ public:
         _textures.push_back(texture);
     }
     auto GetAabb() -> Aabb const& {
-        // todo: need to update Aabb when shape's model is transformed
-        if (_aabb == nullptr) {
-            _aabb = std::make_unique<Aabb>();
-            for (auto const& vertex : _mesh->GetVertex()) {
-                auto transformedVertex = _model->GetTransform() * Point4f { vertex.coord(0), vertex.coord(1), vertex.coord(2), 1.0f };
-                _aabb->Expand(transformedVertex);
-            }
+        if (_aabb == nullptr || _aabbTransformVersion != _model->GetTransformVersion()) {
+            _aabbTransformVersion = _model->GetTransformVersion();
+            auto const& vertexes = _mesh->GetVertex();
+            _aabb = std::make_unique<Aabb>(vertexes.empty() ? Aabb{} :
+                TransformBounds(_model->GetTransform(), &vertexes[0].coord, static_cast<unsigned int>(vertexes.size()), sizeof(Vertex)));
         }
         return *_aabb;
     }
 private:
-    Material * _material;
+    Material * _material = nullptr;
     Model * _model;
     Mesh<Vertex> * _mesh;
+    MeshBvh const* _meshBvh = nullptr;
     std::vector<Texture *> _textures;
     ShaderProgram * _shaderProgram;
     std::unique_ptr<Aabb> _aabb = nullptr;
+    unsigned int _aabbTransformVersion = 0u;
 };
 
 
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <limits>
+#include <xmmintrin.h>
+
+#include "Primitive.h"
+#include "Ray.h"
+
+namespace core {
+
+// Ray prepared for slab tests against axis-aligned boxes. The reciprocal of the direction is computed once
+// per ray instead of dividing per box and axis; components parallel to an axis get a huge reciprocal of the
+// same sign (a positive one for zeros of either sign), so that the test degenerates to a containment test on
+// that axis without any branch.
+struct SlabRay {
+public:
+    SlabRay() = default;
+    explicit SlabRay(Ray const& ray)
+        : length(ray.length)
+        , negativeAxes(0u) {
+        Float32 inverse[4];
+        for (auto i = 0u; i < 3; ++i) {
+            auto component = ray.direction(i);
+            if (abs(component) > std::numeric_limits<Float32>::epsilon()) {
+                inverse[i] = 1.0f / component;
+            } else {
+                inverse[i] = component < 0 ? std::numeric_limits<Float32>::lowest() : std::numeric_limits<Float32>::max();
+            }
+            if (inverse[i] < 0) {
+                negativeAxes |= 1u << i;
+            }
+        }
+        inverse[3] = 0.0f;
+        origin = _mm_setr_ps(ray.origin(0), ray.origin(1), ray.origin(2), 0.0f);
+        inverseDirection = _mm_loadu_ps(inverse);
+    }
+public:
+    __m128 origin;
+    __m128 inverseDirection;
+    Float32 length; // shrink it to the closest hit found so far to prune farther boxes
+    unsigned int negativeAxes; // bit i is set if direction points to negative side of axis i
+};
+
+// Slab test of one ray against one box, same semantic as Aabb::IntersectRay: distance to entry point
+// (or exit point if origin is inside), -1 if missed or farther than ray length.
+// Reads 4 floats from both vertexes, the 4th one is ignored.
+inline auto IntersectSlab(SlabRay const& ray, Float32 const* minVertex, Float32 const* maxVertex) -> Float32 {
+    auto t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(minVertex), ray.origin), ray.inverseDirection);
+    auto t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(maxVertex), ray.origin), ray.inverseDirection);
+    auto tNear = _mm_min_ps(t1, t2);
+    auto tFar = _mm_max_ps(t1, t2);
+    // reduce x, y and z lanes
+    tNear = _mm_max_ss(tNear, _mm_max_ss(_mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(3, 1, 0, 2))));
+    tFar = _mm_min_ss(tFar, _mm_min_ss(_mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(3, 1, 0, 2))));
+    auto tMin = _mm_cvtss_f32(tNear);
+    auto tMax = _mm_cvtss_f32(tFar);
+    if (tMax < 0 || tMin > tMax || tMin >= ray.length) {
+        return -1;
+    }
+    return tMin > 0 ? tMin : tMax;
+}
+
+// Slab test of one ray against 4 boxes stored as structure of arrays: minVertex[axis][box], maxVertex[axis][box].
+// Returns a mask with bit i set if box i is hit, and writes distances with IntersectSlab's semantic to t.
+inline auto IntersectSlab4(SlabRay const& ray, Float32 const* const minVertex[3], Float32 const* const maxVertex[3], Float32 t[4]) -> int {
+    auto tNear = _mm_set1_ps(std::numeric_limits<Float32>::lowest());
+    auto tFar = _mm_set1_ps(std::numeric_limits<Float32>::max());
+    auto const rayOrigin = ray.origin;
+    auto const rayInverseDirection = ray.inverseDirection;
+    __m128 const origin[3] = {
+        _mm_shuffle_ps(rayOrigin, rayOrigin, _MM_SHUFFLE(0, 0, 0, 0)),
+        _mm_shuffle_ps(rayOrigin, rayOrigin, _MM_SHUFFLE(1, 1, 1, 1)),
+        _mm_shuffle_ps(rayOrigin, rayOrigin, _MM_SHUFFLE(2, 2, 2, 2)),
+    };
+    __m128 const inverseDirection[3] = {
+        _mm_shuffle_ps(rayInverseDirection, rayInverseDirection, _MM_SHUFFLE(0, 0, 0, 0)),
+        _mm_shuffle_ps(rayInverseDirection, rayInverseDirection, _MM_SHUFFLE(1, 1, 1, 1)),
+        _mm_shuffle_ps(rayInverseDirection, rayInverseDirection, _MM_SHUFFLE(2, 2, 2, 2)),
+    };
+    for (auto axis = 0u; axis < 3; ++axis) {
+        auto t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(minVertex[axis]), origin[axis]), inverseDirection[axis]);
+        auto t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(maxVertex[axis]), origin[axis]), inverseDirection[axis]);
+        tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+        tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+    }
+    auto hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(tFar, _mm_setzero_ps()), _mm_cmple_ps(tNear, tFar)), _mm_cmplt_ps(tNear, _mm_set1_ps(ray.length)));
+    auto entered = _mm_cmpgt_ps(tNear, _mm_setzero_ps());
+    _mm_storeu_ps(t, _mm_or_ps(_mm_and_ps(entered, tNear), _mm_andnot_ps(entered, tFar)));
+    return _mm_movemask_ps(hit);
+}
+
+}
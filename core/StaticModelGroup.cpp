@@ -1,6 +1,17 @@
 #include "StaticModelGroup.h"
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+
+#include "MeshOptimizer.h"
+#include "MessageLogger.h"
+#include "Parallel.h"
+
 using std::make_unique;
+using std::unique_ptr;
+using std::vector;
 using std::string;
 
 namespace core {
@@ -10,6 +21,8 @@ auto StaticModelGroup::Load() -> void {
     for (auto & t : _textures) {
         t->Load();
     }
+    // optimize meshes, before BVHs refer to their triangles
+    OptimizeMeshes();
     // build BVH
     BuildBvh();
 
@@ -20,12 +33,81 @@ auto StaticModelGroup::Load() -> void {
     }
 }
 
-auto StaticModelGroup::BuildBvh() -> void {
+auto StaticModelGroup::OptimizeMeshes() -> void {
+    if (_meshesOptimized) {
+        return;
+    }
+    _meshesOptimized = true;
+    auto before = VertexCacheStatistics{ 0.0f, 0.0f };
+    auto after = VertexCacheStatistics{ 0.0f, 0.0f };
+    auto triangleCount = size_t{ 0 };
+    auto vertexCount = size_t{ 0 };
+    for (auto & mesh : _meshes) {
+        if (mesh->GetIndex().size() % 3 != 0) {
+            continue;
+        }
+        auto statistics = OptimizeMesh(*mesh);
+        // weighted so that the totals are ratios of the sums over all meshes; unused vertexes have been removed
+        auto const meshTriangleCount = mesh->GetIndex().size() / 3;
+        auto const meshVertexCount = mesh->GetVertex().size();
+        before.acmr += statistics.before.acmr * meshTriangleCount;
+        before.atvr += statistics.before.atvr * meshVertexCount;
+        after.acmr += statistics.after.acmr * meshTriangleCount;
+        after.atvr += statistics.after.atvr * meshVertexCount;
+        triangleCount += meshTriangleCount;
+        vertexCount += meshVertexCount;
+    }
+    if (triangleCount == 0) {
+        return;
+    }
+    MessageLogger::Log(MessageLogger::Info, "mesh optimization: ACMR " + std::to_string(before.acmr / triangleCount) + " -> " + std::to_string(after.acmr / triangleCount)
+        + ", ATVR " + std::to_string(before.atvr / vertexCount) + " -> " + std::to_string(after.atvr / vertexCount));
+}
+
+auto StaticModelGroup::BuildBvh(Bvh::SplitMethod splitMethod) -> void {
+    auto const threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // bottom level: one triangle BVH per mesh, shared by all shapes using it.
+    // large meshes are built one after another with all threads, small ones are spread over the threads.
+    auto largeMeshes = vector<Mesh<Vertex> const*>{};
+    auto smallMeshes = vector<Mesh<Vertex> const*>{};
+    for (auto const& s : _shapes) {
+        auto const* mesh = s->GetMesh();
+        if (_meshBvhs.emplace(mesh, nullptr).second) {
+            (mesh->GetIndex().size() / 3 >= ParallelRangeSize ? largeMeshes : smallMeshes).push_back(mesh);
+        }
+    }
+    for (auto const* mesh : largeMeshes) {
+        _meshBvhs[mesh] = make_unique<MeshBvh>(*mesh, threadCount);
+    }
+    auto smallMeshBvhs = vector<unique_ptr<MeshBvh>>(smallMeshes.size());
+    auto nextMesh = std::atomic<unsigned int>{ 0u };
+    auto buildSmallMeshes = [&smallMeshes, &smallMeshBvhs, &nextMesh] {
+        for (auto i = nextMesh++; i < smallMeshes.size(); i = nextMesh++) {
+            smallMeshBvhs[i] = make_unique<MeshBvh>(*smallMeshes[i]);
+        }
+    };
+    auto tasks = vector<std::future<void>>{};
+    for (auto i = 1u; i < std::min(threadCount, static_cast<unsigned int>(smallMeshes.size())); ++i) {
+        tasks.push_back(std::async(std::launch::async, buildSmallMeshes));
+    }
+    buildSmallMeshes();
+    for (auto & task : tasks) {
+        task.get();
+    }
+    for (auto i = 0u; i < smallMeshes.size(); ++i) {
+        _meshBvhs[smallMeshes[i]] = move(smallMeshBvhs[i]);
+    }
+    for (auto const& s : _shapes) {
+        s->SetMeshBvh(_meshBvhs[s->GetMesh()].get());
+    }
+
+    // top level: BVH over shapes
     auto shapes = vector<Shape *>{};
     for (auto const& s : _shapes) {
         shapes.push_back(s.get());
     }
-    _bvh = make_unique<Bvh>(move(shapes));
+    _bvh = make_unique<Bvh>(move(shapes), splitMethod, threadCount);
 }
 
 auto StaticModelGroup::GetShapes() -> std::vector<std::unique_ptr<Shape>>& {
@@ -8,13 +8,16 @@
 #include "Model.h"
 #include "Shape.h"
 #include "Bvh.h"
+#include "MeshBvh.h"
 
 namespace core {
 
 class StaticModelGroup {
 public:
     auto Load() -> void;
-    auto BuildBvh() -> void;
+    // reorders triangles and vertexes of all meshes for the vertex cache, overdraw and vertex fetch, once
+    auto OptimizeMeshes() -> void;
+    auto BuildBvh(Bvh::SplitMethod splitMethod = Bvh::SplitMethod::Sah) -> void;
     auto GetShapes()->std::vector<std::unique_ptr<Shape>>&;
     auto AcquireShapes()->std::vector<std::unique_ptr<Shape>>;
     auto AcquireMeshes()->std::vector<std::unique_ptr<Mesh<Vertex>>>;
@@ -61,8 +64,10 @@ public:
     std::vector<std::unique_ptr<Mesh<Vertex>>> _meshes;
     std::unordered_map<std::string, std::unique_ptr < ShaderProgram >> _shaderProgram;
     std::unique_ptr<Bvh> _bvh = nullptr;
+    std::unordered_map<Mesh<Vertex> const*, std::unique_ptr<MeshBvh>> _meshBvhs;
 
     size_t _vertexCount = 0;
+    bool _meshesOptimized = false;
 };
 
 }
\ No newline at end of file
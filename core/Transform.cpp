@@ -0,0 +1,146 @@
+#include "Transform.h"
+
+#include <cmath>
+
+namespace core {
+
+auto Transform::FromMatrix(Matrix4x4f const& matrix) -> Transform {
+    auto scale = Vector3f{ 0.0f, 0.0f, 0.0f };
+    Float32 r[3][3];
+    for (auto j = 0u; j < 3; ++j) {
+        scale(j) = std::sqrt(matrix(0, j) * matrix(0, j) + matrix(1, j) * matrix(1, j) + matrix(2, j) * matrix(2, j));
+    }
+    // a mirroring matrix has a negative determinant, which is put into the scale to keep the rotation proper
+    auto determinant = matrix(0, 0) * (matrix(1, 1) * matrix(2, 2) - matrix(1, 2) * matrix(2, 1))
+        - matrix(0, 1) * (matrix(1, 0) * matrix(2, 2) - matrix(1, 2) * matrix(2, 0))
+        + matrix(0, 2) * (matrix(1, 0) * matrix(2, 1) - matrix(1, 1) * matrix(2, 0));
+    if (determinant < 0.0f) {
+        scale(0) = -scale(0);
+    }
+    for (auto i = 0u; i < 3; ++i) {
+        for (auto j = 0u; j < 3; ++j) {
+            r[i][j] = scale(j) == 0.0f ? (i == j ? 1.0f : 0.0f) : matrix(i, j) / scale(j);
+        }
+    }
+    return Transform{
+        Vector3f{ matrix(0, 3), matrix(1, 3), matrix(2, 3) },
+        Quaternion::FromMatrix3x3(r).Normalize(),
+        scale,
+    };
+}
+
+auto Transform::IsDecomposable(Matrix4x4f const& matrix) -> bool {
+    Float32 columns[3][3];
+    Float32 lengths[3];
+    for (auto j = 0u; j < 3; ++j) {
+        for (auto i = 0u; i < 3; ++i) {
+            columns[j][i] = matrix(i, j);
+        }
+        lengths[j] = std::sqrt(columns[j][0] * columns[j][0] + columns[j][1] * columns[j][1] + columns[j][2] * columns[j][2]);
+    }
+    for (auto j = 0u; j < 3; ++j) {
+        for (auto k = j + 1; k < 3; ++k) {
+            auto dot = columns[j][0] * columns[k][0] + columns[j][1] * columns[k][1] + columns[j][2] * columns[k][2];
+            if (std::abs(dot) > 1e-4f * lengths[j] * lengths[k]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+auto Transform::operator*(Transform const& rhs) const -> Transform {
+    auto scaledTranslation = Vector3f{ _scale(0) * rhs._translation(0), _scale(1) * rhs._translation(1), _scale(2) * rhs._translation(2) };
+    auto translation = _rotation.Rotate(scaledTranslation);
+    return Transform{
+        Vector3f{ _translation(0) + translation(0), _translation(1) + translation(1), _translation(2) + translation(2) },
+        (_rotation * rhs._rotation).Normalize(),
+        Vector3f{ _scale(0) * rhs._scale(0), _scale(1) * rhs._scale(1), _scale(2) * rhs._scale(2) },
+    };
+}
+
+auto Transform::Inverse() const -> Transform {
+    auto rotation = _rotation.Conjugate();
+    auto scale = Vector3f{ 1.0f / _scale(0), 1.0f / _scale(1), 1.0f / _scale(2) };
+    auto translation = rotation.Rotate(Vector3f{ -_translation(0), -_translation(1), -_translation(2) });
+    return Transform{
+        Vector3f{ scale(0) * translation(0), scale(1) * translation(1), scale(2) * translation(2) },
+        rotation,
+        scale,
+    };
+}
+
+auto Transform::TransformPoint(Vector3f const& point) const -> Vector3f {
+    auto rotated = _rotation.Rotate(Vector3f{ _scale(0) * point(0), _scale(1) * point(1), _scale(2) * point(2) });
+    return Vector3f{ rotated(0) + _translation(0), rotated(1) + _translation(1), rotated(2) + _translation(2) };
+}
+
+auto Transform::Translate(Float32 x, Float32 y, Float32 z) -> void {
+    _translation(0) += x;
+    _translation(1) += y;
+    _translation(2) += z;
+}
+
+auto Transform::Rotate(Quaternion const& rotation) -> void {
+    _translation = rotation.Rotate(_translation);
+    _rotation = (rotation * _rotation).Normalize();
+}
+
+auto Transform::Scale(Float32 x, Float32 y, Float32 z) -> void {
+    _translation(0) *= x;
+    _translation(1) *= y;
+    _translation(2) *= z;
+    _scale(0) *= x;
+    _scale(1) *= y;
+    _scale(2) *= z;
+}
+
+auto Transform::MoveAlong(Vector3f const& translation) -> void {
+    auto worldTranslation = _rotation.Rotate(Vector3f{ _scale(0) * translation(0), _scale(1) * translation(1), _scale(2) * translation(2) });
+    Translate(worldTranslation(0), worldTranslation(1), worldTranslation(2));
+}
+
+auto Transform::RotateSelf(Quaternion const& rotation) -> void {
+    _rotation = (_rotation * rotation).Normalize();
+}
+
+auto Transform::ToMatrix() const -> Matrix4x4f {
+    Float32 r[3][3];
+    _rotation.ToMatrix3x3(r);
+    return Matrix4x4f{
+        r[0][0] * _scale(0), r[0][1] * _scale(1), r[0][2] * _scale(2), _translation(0),
+        r[1][0] * _scale(0), r[1][1] * _scale(1), r[1][2] * _scale(2), _translation(1),
+        r[2][0] * _scale(0), r[2][1] * _scale(1), r[2][2] * _scale(2), _translation(2),
+        0, 0, 0, 1,
+    };
+}
+
+auto Transform::ToInverseMatrix() const -> Matrix4x4f {
+    // S^-1 * R^T * T^-1: rows of R^T are columns of R
+    Float32 r[3][3];
+    _rotation.ToMatrix3x3(r);
+    auto ret = Matrix4x4f{};
+    for (auto i = 0u; i < 3; ++i) {
+        auto scaleInverse = 1.0f / _scale(i);
+        ret(i, 3) = 0.0f;
+        for (auto j = 0u; j < 3; ++j) {
+            ret(i, j) = r[j][i] * scaleInverse;
+            ret(i, 3) -= ret(i, j) * _translation(j);
+        }
+    }
+    return ret;
+}
+
+auto Transform::ToNormalMatrix() const -> Matrix4x4f {
+    // (R * S)^-T = R * S^-1
+    Float32 r[3][3];
+    _rotation.ToMatrix3x3(r);
+    return Matrix4x4f{
+        r[0][0] / _scale(0), r[0][1] / _scale(1), r[0][2] / _scale(2), 0,
+        r[1][0] / _scale(0), r[1][1] / _scale(1), r[1][2] / _scale(2), 0,
+        r[2][0] / _scale(0), r[2][1] / _scale(1), r[2][2] / _scale(2), 0,
+        0, 0, 0, 1,
+    };
+}
+
+}
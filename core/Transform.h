@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Matrix.h"
+#include "Quaternion.h"
+
+namespace core {
+
+// Translation, rotation and scale, the matrix being T * R * S: points are scaled, then rotated, then translated.
+// Composing is a quaternion product instead of a 4x4 matrix product and rotations stay orthonormal however often
+// they are composed. A non-uniform scale followed by a rotation (shear) cannot be represented, so compose and inverse
+// are exact only if the scale of the transform applied last is uniform, which holds for everything but X3D files
+// nesting non-uniformly scaled transforms.
+class Transform {
+public:
+    Transform() = default;
+    Transform(Vector3f const& translation, Quaternion const& rotation, Vector3f const& scale)
+        : _translation(translation)
+        , _rotation(rotation)
+        , _scale(scale) {
+    }
+public:
+    // decomposes T * R * S, exact if the columns of the upper-left 3x3 are orthogonal, which they are unless a
+    // non-uniform scale is followed by a rotation
+    static auto FromMatrix(Matrix4x4f const& matrix) -> Transform;
+    // whether FromMatrix() reproduces matrix up to rounding
+    static auto IsDecomposable(Matrix4x4f const& matrix) -> bool;
+public:
+    auto GetTranslation() const -> Vector3f const& {
+        return _translation;
+    }
+    auto GetRotation() const -> Quaternion const& {
+        return _rotation;
+    }
+    auto GetScale() const -> Vector3f const& {
+        return _scale;
+    }
+    // rhs followed by this
+    auto operator*(Transform const& rhs) const -> Transform;
+    auto Inverse() const -> Transform;
+    auto TransformPoint(Vector3f const& point) const -> Vector3f;
+
+    // world space operations, the same as multiplying the matrix from the left
+    auto Translate(Float32 x, Float32 y, Float32 z) -> void;
+    auto Rotate(Quaternion const& rotation) -> void;
+    // exact if the transform is not rotated or the scale is uniform
+    auto Scale(Float32 x, Float32 y, Float32 z) -> void;
+    // local space operations, the same as multiplying the matrix from the right
+    auto MoveAlong(Vector3f const& translation) -> void;
+    auto RotateSelf(Quaternion const& rotation) -> void;
+
+    auto ToMatrix() const -> Matrix4x4f;
+    // exact inverse of ToMatrix(), whatever the scale
+    auto ToInverseMatrix() const -> Matrix4x4f;
+    // transpose of the inverse of the upper-left 3x3 of ToMatrix(), transforms normals
+    auto ToNormalMatrix() const -> Matrix4x4f;
+private:
+    Vector3f _translation = Vector3f{ 0.0f, 0.0f, 0.0f };
+    Quaternion _rotation;
+    Vector3f _scale = Vector3f{ 1.0f, 1.0f, 1.0f };
+};
+
+}
@@ -0,0 +1,32 @@
+#include "TransformChangeTracker.h"
+
+namespace core {
+
+auto TransformChangeTracker::CollectChanges(Movable const* const* movables, unsigned int count) -> std::vector<Range> const& {
+    _ranges.clear();
+    if (_versions.size() != count) {
+        _versions.resize(count);
+        for (auto i = 0u; i < count; ++i) {
+            _versions[i] = movables[i]->GetTransformVersion();
+        }
+        if (count > 0) {
+            _ranges.push_back(Range{ 0u, count });
+        }
+        return _ranges;
+    }
+    for (auto i = 0u; i < count; ++i) {
+        auto version = movables[i]->GetTransformVersion();
+        if (version == _versions[i]) {
+            continue;
+        }
+        _versions[i] = version;
+        if (!_ranges.empty() && _ranges.back().first + _ranges.back().count == i) {
+            ++_ranges.back().count;
+        } else {
+            _ranges.push_back(Range{ i, 1u });
+        }
+    }
+    return _ranges;
+}
+
+}
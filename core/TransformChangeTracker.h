@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+
+#include "Movable.h"
+
+namespace core {
+
+// Finds the movables whose world transform changed since the last call by comparing transform versions, so that
+// renderers can upload per object data of moved objects only.
+class TransformChangeTracker {
+public:
+    struct Range {
+        unsigned int first;
+        unsigned int count;
+    };
+public:
+    // runs of consecutive changed movables, all of them on the first call or when the number of movables changed
+    auto CollectChanges(Movable const* const* movables, unsigned int count) -> std::vector<Range> const&;
+    auto Reset() -> void {
+        _versions.clear();
+    }
+private:
+    std::vector<unsigned int> _versions;
+    std::vector<Range> _ranges;
+};
+
+}
@@ -0,0 +1,101 @@
+#include "TransformSystem.h"
+
+#include <algorithm>
+
+#include "Parallel.h"
+
+using std::vector;
+
+namespace core {
+
+TransformSystem::TransformSystem(unsigned int threadCount)
+    : _threadCount(std::max(threadCount, 1u)) {
+}
+
+auto TransformSystem::Create(Transform const& local, Handle parent) -> Handle {
+    auto const handle = static_cast<Handle>(_indexes.size());
+    auto const index = static_cast<unsigned int>(_handles.size());
+    _indexes.push_back(index);
+    _depths.push_back(parent == NoParent ? 0u : _depths[parent] + 1);
+    _handles.push_back(handle);
+    _parents.push_back(parent == NoParent ? NoParent : _indexes[parent]);
+    _locals.push_back(local);
+    _worlds.push_back(Matrix4x4f{});
+    _dirty.push_back(1);
+    _sorted = false;
+    return handle;
+}
+
+auto TransformSystem::Update() -> void {
+    if (!_sorted) {
+        SortByDepth();
+    }
+    for (auto level = 0u; level + 1 < _levelBegins.size(); ++level) {
+        UpdateLevel(_levelBegins[level], _levelBegins[level + 1]);
+    }
+    std::fill(_dirty.begin(), _dirty.end(), uint8{ 0 });
+}
+
+auto TransformSystem::SortByDepth() -> void {
+    // counting sort, stable so that an already sorted hierarchy keeps its order
+    auto const count = static_cast<unsigned int>(_handles.size());
+    auto levelCount = 0u;
+    for (auto depth : _depths) {
+        levelCount = std::max(levelCount, depth + 1);
+    }
+    _levelBegins.assign(levelCount + 1, 0u);
+    for (auto depth : _depths) {
+        ++_levelBegins[depth + 1];
+    }
+    for (auto level = 0u; level < levelCount; ++level) {
+        _levelBegins[level + 1] += _levelBegins[level];
+    }
+    auto next = vector<unsigned int>(_levelBegins.begin(), _levelBegins.end() - 1);
+    auto handles = vector<Handle>(count);
+    for (auto index = 0u; index < count; ++index) {
+        auto handle = _handles[index];
+        handles[next[_depths[handle]]++] = handle;
+    }
+
+    auto indexes = vector<unsigned int>(count);
+    for (auto index = 0u; index < count; ++index) {
+        indexes[handles[index]] = index;
+    }
+    auto parents = vector<unsigned int>(count);
+    auto locals = vector<Transform>(count);
+    auto worlds = vector<Matrix4x4f>(count);
+    auto dirty = vector<uint8>(count);
+    for (auto index = 0u; index < count; ++index) {
+        auto oldIndex = _indexes[handles[index]];
+        auto oldParent = _parents[oldIndex];
+        parents[index] = oldParent == NoParent ? NoParent : indexes[_handles[oldParent]];
+        locals[index] = _locals[oldIndex];
+        worlds[index] = _worlds[oldIndex];
+        dirty[index] = _dirty[oldIndex];
+    }
+    _indexes = std::move(indexes);
+    _handles = std::move(handles);
+    _parents = std::move(parents);
+    _locals = std::move(locals);
+    _worlds = std::move(worlds);
+    _dirty = std::move(dirty);
+    _sorted = true;
+}
+
+auto TransformSystem::UpdateLevel(unsigned int begin, unsigned int end) -> void {
+    auto const chunkCount = std::min(_threadCount, (end - begin + ParallelRangeSize - 1) / ParallelRangeSize);
+    // nodes of a level only read their parents, which are in the level before
+    ForEachChunk(begin, end, chunkCount, [this](unsigned int, unsigned int first, unsigned int last) {
+        for (auto i = first; i < last; ++i) {
+            auto parent = _parents[i];
+            if (parent != NoParent && _dirty[parent] != 0) {
+                _dirty[i] = 1;
+            }
+            if (_dirty[i] != 0) {
+                _worlds[i] = parent == NoParent ? _locals[i].ToMatrix() : _worlds[parent] * _locals[i].ToMatrix();
+            }
+        }
+    });
+}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "Primitive.h"
+#include "Matrix.h"
+#include "Transform.h"
+
+namespace core {
+
+// Transform hierarchy of many nodes in contiguous arrays, an alternative to a heap allocated SceneNode per node for
+// scenes with large numbers of moving objects. Nodes are sorted by depth, so that a node's parent is updated in the
+// level before its own and every level is updated in parallel chunks. Nodes are referred to by handles, which stay
+// valid when nodes are resorted.
+class TransformSystem {
+public:
+    using Handle = unsigned int;
+    static constexpr const Handle NoParent = 0xffffffffu;
+public:
+    explicit TransformSystem(unsigned int threadCount = 1u);
+public:
+    // parent must have been created before
+    auto Create(Transform const& local, Handle parent = NoParent) -> Handle;
+    auto GetLocal(Handle node) const -> Transform const& {
+        return _locals[_indexes[node]];
+    }
+    auto SetLocal(Handle node, Transform const& local) -> void {
+        _locals[_indexes[node]] = local;
+        _dirty[_indexes[node]] = 1;
+    }
+    // as of the last Update()
+    auto GetWorld(Handle node) const -> Matrix4x4f const& {
+        return _worlds[_indexes[node]];
+    }
+    auto GetNodeCount() const -> unsigned int {
+        return static_cast<unsigned int>(_indexes.size());
+    }
+    // recomputes world matrices of nodes whose local transform changed and of their descendants
+    auto Update() -> void;
+private:
+    auto SortByDepth() -> void;
+    auto UpdateLevel(unsigned int begin, unsigned int end) -> void;
+private:
+    unsigned int _threadCount;
+    bool _sorted = true;
+    // by handle
+    std::vector<unsigned int> _indexes;
+    std::vector<unsigned int> _depths;
+    // by index, sorted by depth
+    std::vector<Handle> _handles;
+    std::vector<unsigned int> _parents; // index of the parent or NoParent
+    std::vector<Transform> _locals;
+    std::vector<Matrix4x4f> _worlds;
+    std::vector<uint8> _dirty;
+    std::vector<unsigned int> _levelBegins; // first index of every depth, followed by the node count
+};
+
+}
@@ -1,13 +1,46 @@
 #pragma once
 
+#include <limits>
+#include <emmintrin.h>
+
 #include "Matrix.h"
 #include "Ray.h"
 
 namespace core {
 
+// 4 triangles as structure of arrays, [axis][triangle]: first vertex and the edges from it to the other two
+struct TriangleBlock {
+public:
+    static constexpr const unsigned int Size = 4u;
+public:
+    Float32 p0[3][Size];
+    Float32 e1[3][Size];
+    Float32 e2[3][Size];
+};
+
+// ray with every coordinate broadcast to 4 lanes, prepared once for many Triangle::IntersectRay4 calls
+struct RayLanes {
+public:
+    explicit RayLanes(Ray const& ray) {
+        for (auto axis = 0u; axis < 3; ++axis) {
+            origin[axis] = _mm_set1_ps(ray.origin(axis));
+            direction[axis] = _mm_set1_ps(ray.direction(axis));
+        }
+    }
+public:
+    __m128 origin[3];
+    __m128 direction[3];
+};
+
 class Triangle {
 public:
     static auto IntersectRay(Ray ray, std::array<Point4f, 3> const& triangle) -> Float32 {
+        auto u = 0.0f;
+        auto v = 0.0f;
+        return IntersectRay(ray, triangle, u, v);
+    }
+    // also returns barycentric coordinates of the hit point, u and v weight the 2nd and 3rd vertex
+    static auto IntersectRay(Ray ray, std::array<Point4f, 3> const& triangle, Float32 & u, Float32 & v) -> Float32 {
         auto const& p0 = triangle[0];
         auto const& p1 = triangle[1];
         auto const& p2 = triangle[2];
@@ -20,17 +53,70 @@ public:
         }
         auto f = 1.0f / a;
         auto s = static_cast<Vector4f>(ray.origin - p0);
-        auto u = f * DotProduct(s, q);
+        u = f * DotProduct(s, q);
         if (u < 0) {
             return -1.0;
         }
         auto r = static_cast<Vector4f>(CrossProduct(s, e1));
-        auto v = f * DotProduct(ray.direction, r);
+        v = f * DotProduct(ray.direction, r);
         if (v < 0 || u + v > 1.0) {
             return -1.0;
         }
         return f * DotProduct(e2, r);
     }
+    // Moller-Trumbore test of one ray against the first count triangles of block at once. returns the distance
+    // of the nearest hit within (0, length] and its lane in block, with barycentric coordinates as above, -1 if missed.
+    static auto IntersectRay4(RayLanes const& ray, Float32 length, TriangleBlock const& block, unsigned int count, unsigned int & lane, Float32 & u, Float32 & v) -> Float32 {
+        auto const& d = ray.direction;
+        __m128 e1[3];
+        __m128 e2[3];
+        __m128 s[3];
+        for (auto axis = 0u; axis < 3; ++axis) {
+            e1[axis] = _mm_loadu_ps(block.e1[axis]);
+            e2[axis] = _mm_loadu_ps(block.e2[axis]);
+            s[axis] = _mm_sub_ps(ray.origin[axis], _mm_loadu_ps(block.p0[axis]));
+        }
+        // q = direction x e2, a = e1 . q
+        auto qx = _mm_sub_ps(_mm_mul_ps(d[1], e2[2]), _mm_mul_ps(d[2], e2[1]));
+        auto qy = _mm_sub_ps(_mm_mul_ps(d[2], e2[0]), _mm_mul_ps(d[0], e2[2]));
+        auto qz = _mm_sub_ps(_mm_mul_ps(d[0], e2[1]), _mm_mul_ps(d[1], e2[0]));
+        auto a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1[0], qx), _mm_mul_ps(e1[1], qy)), _mm_mul_ps(e1[2], qz));
+        auto f = _mm_div_ps(_mm_set1_ps(1.0f), a);
+        auto laneU = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(s[0], qx), _mm_mul_ps(s[1], qy)), _mm_mul_ps(s[2], qz)));
+        // r = s x e1
+        auto rx = _mm_sub_ps(_mm_mul_ps(s[1], e1[2]), _mm_mul_ps(s[2], e1[1]));
+        auto ry = _mm_sub_ps(_mm_mul_ps(s[2], e1[0]), _mm_mul_ps(s[0], e1[2]));
+        auto rz = _mm_sub_ps(_mm_mul_ps(s[0], e1[1]), _mm_mul_ps(s[1], e1[0]));
+        auto laneV = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(d[0], rx), _mm_mul_ps(d[1], ry)), _mm_mul_ps(d[2], rz)));
+        auto t = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2[0], rx), _mm_mul_ps(e2[1], ry)), _mm_mul_ps(e2[2], rz)));
+
+        auto const zero = _mm_setzero_ps();
+        auto absA = _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+        auto valid = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(static_cast<int>(count))));
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(absA, _mm_set1_ps(std::numeric_limits<Float32>::min())));
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(laneU, zero), _mm_cmpge_ps(laneV, zero)));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(laneU, laneV), _mm_set1_ps(1.0f)));
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmple_ps(t, _mm_set1_ps(length))));
+        if (_mm_movemask_ps(valid) == 0) {
+            return -1.0f;
+        }
+        // nearest valid lane
+        auto validT = _mm_or_ps(_mm_and_ps(valid, t), _mm_andnot_ps(valid, _mm_set1_ps(std::numeric_limits<Float32>::max())));
+        auto minT = _mm_min_ps(validT, _mm_shuffle_ps(validT, validT, _MM_SHUFFLE(2, 3, 0, 1)));
+        minT = _mm_min_ps(minT, _mm_shuffle_ps(minT, minT, _MM_SHUFFLE(1, 0, 3, 2)));
+        auto nearestMask = _mm_movemask_ps(_mm_and_ps(valid, _mm_cmpeq_ps(validT, minT)));
+        lane = 0u;
+        while ((nearestMask & (1 << lane)) == 0) {
+            ++lane;
+        }
+        Float32 lanes[3][TriangleBlock::Size];
+        _mm_storeu_ps(lanes[0], t);
+        _mm_storeu_ps(lanes[1], laneU);
+        _mm_storeu_ps(lanes[2], laneV);
+        u = lanes[1][lane];
+        v = lanes[2][lane];
+        return lanes[0][lane];
+    }
 };
 
 }
\ No newline at end of file
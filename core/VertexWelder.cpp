@@ -0,0 +1,98 @@
+#include "VertexWelder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace core {
+
+VertexWelder::VertexWelder(std::vector<Vector3f> const* coords, std::vector<Vector3f> const* normals, std::vector<Vector2f> const* texCoords, Float32 positionEpsilon)
+    : _coords(coords)
+    , _normals(normals)
+    , _texCoords(texCoords)
+    , _positionEpsilon(positionEpsilon) {
+}
+
+auto VertexWelder::AddTriangle(Corner const& a, Corner const& b, Corner const& c) -> bool {
+    unsigned int triangle[3] = { GetVertex(a), GetVertex(b), GetVertex(c) };
+    if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0]) {
+        return false;
+    }
+    auto const& p0 = _vertices[triangle[0]].coord;
+    auto const& p1 = _vertices[triangle[1]].coord;
+    auto const& p2 = _vertices[triangle[2]].coord;
+    auto e1 = Vector3f{ p1(0) - p0(0), p1(1) - p0(1), p1(2) - p0(2) };
+    auto e2 = Vector3f{ p2(0) - p0(0), p2(1) - p0(1), p2(2) - p0(2) };
+    auto nx = e1(1) * e2(2) - e1(2) * e2(1);
+    auto ny = e1(2) * e2(0) - e1(0) * e2(2);
+    auto nz = e1(0) * e2(1) - e1(1) * e2(0);
+    if (nx == 0.0f && ny == 0.0f && nz == 0.0f) {
+        return false;
+    }
+    _indexes.insert(_indexes.end(), triangle, triangle + 3);
+    return true;
+}
+
+auto VertexWelder::CornerHash::operator()(Corner const& corner) const -> size_t {
+    auto hash = static_cast<uint64>(corner.coord) * 0x9e3779b97f4a7c15ull;
+    hash ^= (static_cast<uint64>(corner.normal) + 0x632be59bd9b4e019ull + (hash << 6) + (hash >> 2));
+    hash ^= (static_cast<uint64>(corner.texCoord) + 0x85ebca6b27d4eb4full + (hash << 6) + (hash >> 2));
+    return static_cast<size_t>(hash);
+}
+
+auto VertexWelder::GetVertex(Corner const& corner) -> unsigned int {
+    auto found = _cornerVertices.find(corner);
+    if (found != _cornerVertices.end()) {
+        return found->second;
+    }
+    auto vertex = Vertex{ _coords->at(corner.coord), _normals->at(corner.normal), _texCoords->at(corner.texCoord) };
+    auto index = _positionEpsilon > 0.0f ? FindNearbyVertex(vertex) : NotFound;
+    if (index == NotFound) {
+        index = static_cast<unsigned int>(_vertices.size());
+        _vertices.push_back(vertex);
+        if (_positionEpsilon > 0.0f) {
+            _cellVertices.emplace(HashCell(GetCell(vertex.coord(0)), GetCell(vertex.coord(1)), GetCell(vertex.coord(2))), index);
+        }
+    }
+    _cornerVertices.emplace(corner, index);
+    return index;
+}
+
+auto VertexWelder::FindNearbyVertex(Vertex const& vertex) const -> unsigned int {
+    // cells are epsilon wide, so vertices within epsilon are in the same or an adjacent cell
+    auto x = GetCell(vertex.coord(0));
+    auto y = GetCell(vertex.coord(1));
+    auto z = GetCell(vertex.coord(2));
+    for (auto i = x - 1; i <= x + 1; ++i) {
+        for (auto j = y - 1; j <= y + 1; ++j) {
+            for (auto k = z - 1; k <= z + 1; ++k) {
+                auto range = _cellVertices.equal_range(HashCell(i, j, k));
+                for (auto it = range.first; it != range.second; ++it) {
+                    auto const& other = _vertices[it->second];
+                    if (std::abs(other.coord(0) - vertex.coord(0)) <= _positionEpsilon
+                        && std::abs(other.coord(1) - vertex.coord(1)) <= _positionEpsilon
+                        && std::abs(other.coord(2) - vertex.coord(2)) <= _positionEpsilon
+                        && other.normal(0) == vertex.normal(0) && other.normal(1) == vertex.normal(1) && other.normal(2) == vertex.normal(2)
+                        && other.texCoord(0) == vertex.texCoord(0) && other.texCoord(1) == vertex.texCoord(1)) {
+                        return it->second;
+                    }
+                }
+            }
+        }
+    }
+    return NotFound;
+}
+
+// clamped before the cast, which is undefined for values out of range, as for large coordinates and a small epsilon.
+// coordinates in clamped cells are still compared, the cells only get crowded
+auto VertexWelder::GetCell(Float32 coord) const -> int32 {
+    auto cell = std::floor(coord / _positionEpsilon);
+    return static_cast<int32>(std::max(-MaxCell, std::min(cell, MaxCell)));
+}
+
+auto VertexWelder::HashCell(int32 x, int32 y, int32 z) -> uint64 {
+    // 21 bits per axis, distinct cells may collide, which only costs a comparison
+    auto const mask = (1ull << 21) - 1;
+    return (static_cast<uint64>(x) & mask) | ((static_cast<uint64>(y) & mask) << 21) | ((static_cast<uint64>(z) & mask) << 42);
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "Primitive.h"
+#include "Matrix.h"
+#include "Vertex.h"
+
+namespace core {
+
+// Builds unique vertices and an index buffer from triangle corners which index coordinates, normals and texture
+// coordinates separately, as X3D IndexedFaceSet does. Corners with the same indexes share a vertex; with a positive
+// epsilon, vertices whose coordinates are within epsilon of each other and whose normal and texture coordinate are
+// equal are merged too. Triangles which end up with a repeated vertex or zero area are dropped.
+class VertexWelder {
+public:
+    struct Corner {
+        unsigned int coord;
+        unsigned int normal;
+        unsigned int texCoord;
+    };
+public:
+    // the attribute arrays are referred to, not copied, and have to outlive the welder
+    VertexWelder(std::vector<Vector3f> const* coords, std::vector<Vector3f> const* normals, std::vector<Vector2f> const* texCoords, Float32 positionEpsilon = 0.0f);
+public:
+    // returns false if the triangle is degenerate and was dropped, throws std::out_of_range for invalid indexes
+    auto AddTriangle(Corner const& a, Corner const& b, Corner const& c) -> bool;
+    auto GetVertices() -> std::vector<Vertex> & {
+        return _vertices;
+    }
+    auto GetIndexes() -> std::vector<unsigned int> & {
+        return _indexes;
+    }
+private:
+    struct CornerHash {
+        auto operator()(Corner const& corner) const -> size_t;
+    };
+    struct CornerEqual {
+        auto operator()(Corner const& lhs, Corner const& rhs) const -> bool {
+            return lhs.coord == rhs.coord && lhs.normal == rhs.normal && lhs.texCoord == rhs.texCoord;
+        }
+    };
+    auto GetVertex(Corner const& corner) -> unsigned int;
+    auto FindNearbyVertex(Vertex const& vertex) const -> unsigned int;
+    auto GetCell(Float32 coord) const -> int32;
+    static auto HashCell(int32 x, int32 y, int32 z) -> uint64;
+private:
+    static constexpr const unsigned int NotFound = 0xffffffffu;
+    static constexpr const Float32 MaxCell = 1073741824.0f; // 2^30, neighbours of clamped cells are still in int32 range
+    std::vector<Vector3f> const* _coords;
+    std::vector<Vector3f> const* _normals;
+    std::vector<Vector2f> const* _texCoords;
+    Float32 _positionEpsilon;
+    std::vector<Vertex> _vertices;
+    std::vector<unsigned int> _indexes;
+    std::unordered_map<Corner, unsigned int, CornerHash, CornerEqual> _cornerVertices;
+    // vertices by grid cell of epsilon size, only used when welding by position
+    std::unordered_multimap<uint64, unsigned int> _cellVertices;
+};
+
+}
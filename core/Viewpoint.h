@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Movable.h"
+#include "Frustum.h"
 
 namespace core {
 
@@ -13,6 +14,13 @@ public:
 public:
     virtual auto GetProjectTransform() const -> Matrix4x4f const& = 0;
     virtual auto GetProjectTransformDx() const -> Matrix4x4f const& = 0;
+    auto GetViewProjectTransform() const -> Matrix4x4f {
+        return static_cast<Matrix4x4f>(GetProjectTransform() * GetRigidBodyMatrixInverse());
+    }
+    // world space frustum, used for visibility culling
+    auto GetViewFrustum() const -> Frustum {
+        return Frustum{ GetViewProjectTransform() };
+    }
     auto GetRenderDataId() const -> unsigned int {
         return _renderDataId;
     }
@@ -0,0 +1,201 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "core/BvhBuilder.h"
+
+using namespace core;
+
+class BvhBuilderTest : public ::testing::Test {
+public:
+	// boxes of random size up to maxSize with centers uniformly in [-range, range]
+	auto RandomPrimitives(unsigned int count, Float32 range, Float32 maxSize) -> std::vector<BvhBuilder::Primitive> {
+		auto center = std::uniform_real_distribution<Float32>{ -range, range };
+		auto size = std::uniform_real_distribution<Float32>{ 0.0f, maxSize };
+		auto ret = std::vector<BvhBuilder::Primitive>{};
+		for (auto i = 0u; i < count; ++i) {
+			ret.push_back(MakePrimitive(Point4f{ center(_random), center(_random), center(_random), 1.0f }, Vector4f{ size(_random), size(_random), size(_random), 0.0f }));
+		}
+		return ret;
+	}
+	// clusters of small boxes around a few random points, with a few large boxes in between
+	auto ClusteredPrimitives(unsigned int clusterCount, unsigned int clusterSize) -> std::vector<BvhBuilder::Primitive> {
+		auto ret = std::vector<BvhBuilder::Primitive>{};
+		auto center = std::uniform_real_distribution<Float32>{ -100.0f, 100.0f };
+		auto offset = std::normal_distribution<Float32>{ 0.0f, 2.0f };
+		auto size = std::uniform_real_distribution<Float32>{ 0.1f, 1.0f };
+		for (auto cluster = 0u; cluster < clusterCount; ++cluster) {
+			auto clusterCenter = Point4f{ center(_random), center(_random), center(_random) / 10, 1.0f };
+			for (auto i = 0u; i < clusterSize; ++i) {
+				auto primitiveCenter = Point4f{ clusterCenter(0) + offset(_random), clusterCenter(1) + offset(_random), clusterCenter(2) + offset(_random), 1.0f };
+				ret.push_back(MakePrimitive(primitiveCenter, Vector4f{ size(_random), size(_random), size(_random), 0.0f }));
+			}
+			ret.push_back(MakePrimitive(clusterCenter, Vector4f{ 20.0f * size(_random), 20.0f * size(_random), 2.0f, 0.0f }));
+		}
+		return ret;
+	}
+	static auto MakePrimitive(Point4f const& center, Vector4f const& halfSize) -> BvhBuilder::Primitive {
+		return BvhBuilder::Primitive{ static_cast<Point4f>(center - halfSize), static_cast<Point4f>(center + halfSize), center };
+	}
+	// checks that every primitive is referenced by exactly one leaf, that leaves hold 1 to maxLeafSize primitives,
+	// that children lie within their parent and leaves bound their primitives, and that every node is reachable.
+	// returns the depth of the tree, the root has depth 1.
+	static auto Validate(std::vector<BvhNode> const& nodes, std::vector<unsigned int> const& primitiveIndex,
+		std::vector<BvhBuilder::Primitive> const& primitives, unsigned int maxLeafSize) -> unsigned int {
+		EXPECT_FALSE(nodes.empty());
+		EXPECT_EQ(primitives.size(), primitiveIndex.size());
+		auto referenceCount = std::vector<unsigned int>(primitives.size(), 0u);
+		auto visitCount = std::vector<unsigned int>(nodes.size(), 0u);
+		auto depth = 0u;
+		// node index and its depth
+		auto nodeStack = std::vector<std::pair<unsigned int, unsigned int>>{ { 0u, 1u } };
+		while (!nodeStack.empty()) {
+			auto nodeIndex = nodeStack.back().first;
+			auto nodeDepth = nodeStack.back().second;
+			nodeStack.pop_back();
+			EXPECT_LT(nodeIndex, nodes.size());
+			if (nodeIndex >= nodes.size()) {
+				continue;
+			}
+			++visitCount[nodeIndex];
+			depth = std::max(depth, nodeDepth);
+			auto const& node = nodes[nodeIndex];
+			if (node.IsLeaf()) {
+				EXPECT_LE(node.primitiveCount, maxLeafSize);
+				EXPECT_LE(node.offset + node.primitiveCount, primitiveIndex.size());
+				for (auto i = node.offset; i < std::min<unsigned int>(node.offset + node.primitiveCount, static_cast<unsigned int>(primitiveIndex.size())); ++i) {
+					++referenceCount[primitiveIndex[i]];
+					auto const& primitive = primitives[primitiveIndex[i]];
+					for (auto axis = 0u; axis < 3; ++axis) {
+						EXPECT_LE(node.minVertex[axis], primitive.minVertex(axis));
+						EXPECT_GE(node.maxVertex[axis], primitive.maxVertex(axis));
+					}
+				}
+				continue;
+			}
+			EXPECT_GT(node.offset, nodeIndex + 1);
+			for (auto child : { nodeIndex + 1, node.offset }) {
+				if (child >= nodes.size()) {
+					continue;
+				}
+				for (auto axis = 0u; axis < 3; ++axis) {
+					EXPECT_LE(node.minVertex[axis], nodes[child].minVertex[axis]);
+					EXPECT_GE(node.maxVertex[axis], nodes[child].maxVertex[axis]);
+				}
+				nodeStack.push_back(std::make_pair(child, nodeDepth + 1));
+			}
+		}
+		EXPECT_TRUE(std::all_of(referenceCount.begin(), referenceCount.end(), [](unsigned int count) { return count == 1; }));
+		EXPECT_TRUE(std::all_of(visitCount.begin(), visitCount.end(), [](unsigned int count) { return count == 1; }));
+		return depth;
+	}
+	static auto Build(BvhBuilder::SplitMethod splitMethod, unsigned int maxLeafSize, std::vector<BvhBuilder::Primitive> const& primitives,
+		std::vector<BvhNode> & nodes, unsigned int threadCount = 1u) -> unsigned int {
+		auto primitiveIndex = std::vector<unsigned int>{};
+		return Build(splitMethod, maxLeafSize, primitives, nodes, primitiveIndex, threadCount);
+	}
+	static auto Build(BvhBuilder::SplitMethod splitMethod, unsigned int maxLeafSize, std::vector<BvhBuilder::Primitive> const& primitives,
+		std::vector<BvhNode> & nodes, std::vector<unsigned int> & primitiveIndex, unsigned int threadCount) -> unsigned int {
+		auto builder = BvhBuilder{ splitMethod, maxLeafSize, threadCount };
+		builder.Build(primitives);
+		nodes = builder.AcquireNodes();
+		primitiveIndex = builder.AcquirePrimitiveIndex();
+		return Validate(nodes, primitiveIndex, primitives, maxLeafSize);
+	}
+protected:
+	std::mt19937 _random;
+};
+
+TEST_F(BvhBuilderTest, Valid_tree) {
+	auto nodes = std::vector<BvhNode>{};
+	for (auto splitMethod : { BvhBuilder::SplitMethod::Sah, BvhBuilder::SplitMethod::Middle }) {
+		for (auto maxLeafSize : { 1u, 4u, 7u }) {
+			for (auto count : { 1u, 2u, 5u, 100u, 3000u }) {
+				Build(splitMethod, maxLeafSize, RandomPrimitives(count, 50.0f, 5.0f), nodes);
+			}
+			Build(splitMethod, maxLeafSize, ClusteredPrimitives(20, 50), nodes);
+		}
+	}
+}
+
+TEST_F(BvhBuilderTest, Close_primitives) {
+	// centers closer than the middle split gives up at, and all at the same point, still end up in small leaves
+	auto nodes = std::vector<BvhNode>{};
+	auto close = RandomPrimitives(200, 0.1f, 1.0f);
+	auto coincident = std::vector<BvhBuilder::Primitive>(50, MakePrimitive(Point4f{ 1.0f, 2.0f, 3.0f, 1.0f }, Vector4f{ 1.0f, 1.0f, 1.0f, 0.0f }));
+	for (auto splitMethod : { BvhBuilder::SplitMethod::Sah, BvhBuilder::SplitMethod::Middle }) {
+		Build(splitMethod, 4u, close, nodes);
+		Build(splitMethod, 4u, coincident, nodes);
+		EXPECT_EQ(nodes.front().minVertex[0], 0.0f);
+		EXPECT_EQ(nodes.front().maxVertex[2], 4.0f);
+	}
+}
+
+TEST_F(BvhBuilderTest, Median_split_below_depth_30) {
+	// centers at powers of 2: splitting in the middle of the centers' bounds, or at a bin boundary,
+	// separates only the farthest primitive, so the tree would get as deep as there are primitives
+	auto primitives = std::vector<BvhBuilder::Primitive>{};
+	for (auto i = 0u; i < 120; ++i) {
+		auto x = std::ldexp(1.0f, static_cast<int>(i));
+		primitives.push_back(MakePrimitive(Point4f{ x, 0.0f, 0.0f, 1.0f }, Vector4f{ 0.25f, 0.25f, 0.25f, 0.0f }));
+	}
+	auto nodes = std::vector<BvhNode>{};
+	for (auto splitMethod : { BvhBuilder::SplitMethod::Sah, BvhBuilder::SplitMethod::Middle }) {
+		auto depth = Build(splitMethod, 1u, primitives, nodes);
+		// 30 levels of the split method, then halving the remaining primitives down to single ones
+		EXPECT_GT(depth, 30u);
+		EXPECT_LE(depth, 30u + 8u);
+		EXPECT_LE(depth, BvhBuilder::MaxDepth);
+	}
+}
+
+TEST_F(BvhBuilderTest, Sah_cheaper_than_middle) {
+	auto primitives = ClusteredPrimitives(30, 100);
+	auto sahNodes = std::vector<BvhNode>{};
+	auto middleNodes = std::vector<BvhNode>{};
+	Build(BvhBuilder::SplitMethod::Sah, 4u, primitives, sahNodes);
+	Build(BvhBuilder::SplitMethod::Middle, 4u, primitives, middleNodes);
+	auto sahCost = BvhBuilder::ComputeSahCost(sahNodes);
+	auto middleCost = BvhBuilder::ComputeSahCost(middleNodes);
+	EXPECT_GT(sahCost, 0.0f);
+	EXPECT_LE(sahCost, middleCost);
+}
+
+TEST_F(BvhBuilderTest, Parallel_build_same_as_serial) {
+	// large enough for subtree tasks and chunked binning and partitioning near the root
+	auto primitives = RandomPrimitives(50000, 100.0f, 2.0f);
+	auto clustered = ClusteredPrimitives(40, 1000);
+	for (auto splitMethod : { BvhBuilder::SplitMethod::Sah, BvhBuilder::SplitMethod::Middle }) {
+		for (auto const* input : { &primitives, &clustered }) {
+			auto serialNodes = std::vector<BvhNode>{};
+			auto serialIndex = std::vector<unsigned int>{};
+			auto parallelNodes = std::vector<BvhNode>{};
+			auto parallelIndex = std::vector<unsigned int>{};
+			Build(splitMethod, 4u, *input, serialNodes, serialIndex, 1u);
+			Build(splitMethod, 4u, *input, parallelNodes, parallelIndex, 8u);
+			// the same split planes give the same nodes, only the order of primitives within a leaf may differ
+			ASSERT_EQ(serialNodes.size(), parallelNodes.size());
+			for (auto i = 0u; i < serialNodes.size(); ++i) {
+				auto const& serial = serialNodes[i];
+				auto const& parallel = parallelNodes[i];
+				ASSERT_EQ(serial.IsLeaf(), parallel.IsLeaf()) << "node " << i;
+				ASSERT_EQ(serial.offset, parallel.offset) << "node " << i;
+				ASSERT_EQ(serial.primitiveCount, parallel.primitiveCount) << "node " << i;
+				for (auto axis = 0u; axis < 3; ++axis) {
+					ASSERT_EQ(serial.minVertex[axis], parallel.minVertex[axis]) << "node " << i;
+					ASSERT_EQ(serial.maxVertex[axis], parallel.maxVertex[axis]) << "node " << i;
+				}
+				if (serial.IsLeaf()) {
+					auto serialLeaf = std::vector<unsigned int>(serialIndex.begin() + serial.offset, serialIndex.begin() + serial.offset + serial.primitiveCount);
+					auto parallelLeaf = std::vector<unsigned int>(parallelIndex.begin() + parallel.offset, parallelIndex.begin() + parallel.offset + parallel.primitiveCount);
+					std::sort(serialLeaf.begin(), serialLeaf.end());
+					std::sort(parallelLeaf.begin(), parallelLeaf.end());
+					ASSERT_EQ(serialLeaf, parallelLeaf) << "node " << i;
+				}
+			}
+		}
+	}
+}
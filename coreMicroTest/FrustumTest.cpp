@@ -0,0 +1,154 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "core/Frustum.h"
+#include "core/BvhBuilder.h"
+
+using namespace core;
+
+class FrustumTest : public ::testing::Test {
+public:
+	// camera at (10, 5, 20) looking at -x, 90 degrees field of view, near plane at 1, far plane at 100
+	FrustumTest() {
+		auto nearPlane = 1.0f;
+		auto farPlane = 100.0f;
+		auto project = Matrix4x4f{
+			nearPlane, 0, 0, 0,
+			0, nearPlane, 0, 0,
+			0, 0, -(farPlane + nearPlane) / (farPlane - nearPlane), -2 * farPlane * nearPlane / (farPlane - nearPlane),
+			0, 0, -1, 0,
+		};
+		// inverse of rotation by 90 degrees around y followed by translation
+		auto view = Matrix4x4f{
+			0, 0, -1, 20,
+			0, 1, 0, -5,
+			1, 0, 0, -10,
+			0, 0, 0, 1,
+		};
+		_viewProject = static_cast<Matrix4x4f>(project * view);
+		_frustum = Frustum{ _viewProject };
+	}
+public:
+	// clip space test of the 8 corners: returns -1 if all of them are outside of one clip plane,
+	// 1 if for every clip plane one of them is clearly inside, 0 if too close to call.
+	auto ClassifyCorners(Aabb const& aabb) const -> int {
+		auto vertex = aabb.GetVertex();
+		auto ret = 1;
+		for (auto plane = 0u; plane < Frustum::PlaneCount; ++plane) {
+			auto maxDistance = std::numeric_limits<Float32>::lowest();
+			for (auto const& v : vertex) {
+				auto clip = static_cast<Point4f>(_viewProject * v);
+				auto sign = plane % 2 == 0 ? 1.0f : -1.0f;
+				maxDistance = std::max(maxDistance, clip(3) + sign * clip(plane / 2));
+			}
+			if (maxDistance < -1e-3f) {
+				return -1;
+			}
+			if (maxDistance < 1e-3f) {
+				ret = 0;
+			}
+		}
+		return ret;
+	}
+	auto RandomAabbs(unsigned int count) -> std::vector<Aabb> {
+		auto position = std::uniform_real_distribution<Float32>{ -150.0f, 150.0f };
+		auto size = std::uniform_real_distribution<Float32>{ 0.1f, 10.0f };
+		auto ret = std::vector<Aabb>{};
+		for (auto i = 0u; i < count; ++i) {
+			auto x = position(_random);
+			auto y = position(_random) * 0.5f;
+			auto z = position(_random);
+			ret.push_back(Aabb{ Point4f{ x, y, z, 1 }, Point4f{ x + size(_random), y + size(_random), z + size(_random), 1 } });
+		}
+		return ret;
+	}
+protected:
+	Matrix4x4f _viewProject;
+	Frustum _frustum;
+	std::mt19937 _random;
+};
+
+TEST_F(FrustumTest, Aabb_against_corners) {
+	auto visibleCount = 0u;
+	for (auto const& aabb : RandomAabbs(10000)) {
+		auto expected = ClassifyCorners(aabb);
+		auto visible = _frustum.IntersectAabb(aabb);
+		if (expected != 0) {
+			ASSERT_EQ(expected > 0, visible);
+		}
+		visibleCount += visible ? 1 : 0;
+	}
+	ASSERT_GT(visibleCount, 0u);
+	ASSERT_LT(visibleCount, 10000u);
+}
+
+TEST_F(FrustumTest, Plane_mask) {
+	// a box in front of the camera is inside all planes, one crossing the near plane has to be tested against it only
+	auto aabb = Aabb{ Point4f{ 5, 4, 19, 1 }, Point4f{ 6, 6, 21, 1 } };
+	auto planeMask = Frustum::AllPlanes;
+	auto minVertex = aabb.GetMinVertex();
+	auto maxVertex = aabb.GetMaxVertex();
+	ASSERT_TRUE(_frustum.IntersectAabb(minVertex.data(), maxVertex.data(), planeMask));
+	ASSERT_EQ(0u, planeMask);
+
+	auto straddling = Aabb{ Point4f{ 8.5f, 4.9f, 19.9f, 1 }, Point4f{ 9.5f, 5.1f, 20.1f, 1 } };
+	planeMask = Frustum::AllPlanes;
+	minVertex = straddling.GetMinVertex();
+	maxVertex = straddling.GetMaxVertex();
+	ASSERT_TRUE(_frustum.IntersectAabb(minVertex.data(), maxVertex.data(), planeMask));
+	ASSERT_EQ(1u << 4, planeMask);
+}
+
+TEST_F(FrustumTest, Sphere) {
+	auto position = std::uniform_real_distribution<Float32>{ -150.0f, 150.0f };
+	auto radius = std::uniform_real_distribution<Float32>{ 0.1f, 10.0f };
+	for (auto i = 0u; i < 10000; ++i) {
+		auto center = Point4f{ position(_random), position(_random), position(_random), 1 };
+		auto r = radius(_random);
+		auto outside = false;
+		for (auto plane = 0u; plane < Frustum::PlaneCount; ++plane) {
+			auto p = _frustum.GetPlane(plane);
+			outside = outside || p(0) * center(0) + p(1) * center(1) + p(2) * center(2) + p(3) < -r;
+		}
+		ASSERT_EQ(!outside, _frustum.IntersectSphere(center, r));
+	}
+	ASSERT_TRUE(_frustum.IntersectSphere(Point4f{ -40, 5, 20, 1 }, 0.0f));
+	ASSERT_FALSE(_frustum.IntersectSphere(Point4f{ 20, 5, 20, 1 }, 1.0f));
+}
+
+TEST_F(FrustumTest, Bvh_cull_against_brute_force) {
+	auto aabbs = RandomAabbs(5000);
+	auto primitives = std::vector<BvhBuilder::Primitive>{};
+	for (auto const& aabb : aabbs) {
+		primitives.push_back(BvhBuilder::Primitive{ aabb.GetMinVertex(), aabb.GetMaxVertex(), aabb.GetCenter() });
+	}
+	auto builder = BvhBuilder{ BvhBuilder::SplitMethod::Sah, 4u };
+	builder.Build(primitives);
+	auto nodes = builder.AcquireNodes();
+	auto primitiveIndex = builder.AcquirePrimitiveIndex();
+
+	auto visible = std::vector<unsigned int>{};
+	_frustum.CullBvh(nodes, [&](unsigned int begin, unsigned int end, unsigned int planeMask) {
+		for (auto i = begin; i < end; ++i) {
+			auto mask = planeMask;
+			auto minVertex = aabbs[primitiveIndex[i]].GetMinVertex();
+			auto maxVertex = aabbs[primitiveIndex[i]].GetMaxVertex();
+			if (mask == 0 || _frustum.IntersectAabb(minVertex.data(), maxVertex.data(), mask)) {
+				visible.push_back(primitiveIndex[i]);
+			}
+		}
+	});
+	std::sort(visible.begin(), visible.end());
+
+	auto expected = std::vector<unsigned int>{};
+	for (auto i = 0u; i < aabbs.size(); ++i) {
+		if (_frustum.IntersectAabb(aabbs[i])) {
+			expected.push_back(i);
+		}
+	}
+	ASSERT_FALSE(expected.empty());
+	ASSERT_EQ(expected, visible);
+}
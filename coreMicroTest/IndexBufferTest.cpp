@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "core/IndexBuffer.h"
+
+using namespace core;
+
+class IndexBufferTest : public ::testing::Test {
+public:
+	static auto MakeMesh(unsigned int vertexCount, std::vector<unsigned int> index) -> std::unique_ptr<Mesh<Vertex>> {
+		return std::make_unique<Mesh<Vertex>>(std::vector<Vertex>(vertexCount), std::move(index));
+	}
+};
+
+TEST_F(IndexBufferTest, Index_format_follows_largest_index) {
+	EXPECT_EQ(IndexFormat::Uint16, MakeMesh(3, { 0, 1, 2 })->GetIndexFormat());
+	EXPECT_EQ(IndexFormat::Uint16, MakeMesh(65536, { 0, 65535, 2 })->GetIndexFormat());
+	auto mesh = MakeMesh(65537, { 0, 65536, 2 });
+	EXPECT_EQ(IndexFormat::Uint32, mesh->GetIndexFormat());
+	EXPECT_EQ(4u, mesh->GetIndexSize());
+	mesh->SetData(std::vector<Vertex>(3), { 2, 1, 0 });
+	EXPECT_EQ(IndexFormat::Uint16, mesh->GetIndexFormat());
+	EXPECT_EQ(2u, mesh->GetIndexSize());
+
+	// moves keep the indexes
+	auto moved = Mesh<Vertex>{ std::move(*mesh) };
+	EXPECT_EQ((std::vector<unsigned int>{ 2, 1, 0 }), moved.GetIndex());
+}
+
+TEST_F(IndexBufferTest, Mixed_width_layout) {
+	auto meshes = std::vector<std::unique_ptr<Mesh<Vertex>>>{};
+	meshes.push_back(MakeMesh(4, { 0, 1, 2, 0, 2, 3 }));
+	meshes.push_back(MakeMesh(70000, { 0, 69999, 1 }));
+	meshes.push_back(MakeMesh(3, { 2, 1, 0 }));
+	meshes.push_back(MakeMesh(70000, { 65536, 1, 2 }));
+
+	auto layout = LayoutIndexBuffer(meshes.cbegin(), meshes.cend());
+	// 9 16 bit indexes padded to 4 bytes, then 6 32 bit ones
+	EXPECT_EQ(20u, layout.uint16Size);
+	EXPECT_EQ(24u, layout.uint32Size);
+	ASSERT_EQ(4u, layout.entries.size());
+	EXPECT_EQ(IndexFormat::Uint16, layout.entries[0].format);
+	EXPECT_EQ(IndexFormat::Uint32, layout.entries[1].format);
+	EXPECT_EQ(6u, layout.entries[2].offset);
+	EXPECT_EQ(3u, layout.entries[3].offset);
+	EXPECT_EQ(12u, layout.GetByteOffset(2));
+	EXPECT_EQ(32u, layout.GetByteOffset(3));
+
+	auto data = std::vector<uint8>(layout.GetSize(), 0xff);
+	WriteIndexBuffer(meshes.cbegin(), meshes.cend(), layout, data.data());
+	uint16 narrow[10];
+	std::memcpy(narrow, data.data(), sizeof(narrow));
+	EXPECT_EQ((std::vector<uint16>{ 0, 1, 2, 0, 2, 3, 2, 1, 0, 0 }), std::vector<uint16>(narrow, narrow + 10));
+	uint32 wide[6];
+	std::memcpy(wide, data.data() + layout.uint16Size, sizeof(wide));
+	EXPECT_EQ((std::vector<uint32>{ 0, 69999, 1, 65536, 1, 2 }), std::vector<uint32>(wide, wide + 6));
+}
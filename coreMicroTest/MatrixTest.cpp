@@ -1,5 +1,10 @@
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <type_traits>
+
 #include "core/Matrix.h"
 
 using namespace core;
@@ -77,4 +82,270 @@ TEST_F(MatrixTest, Vector_subtract) {
 TEST_F(MatrixTest, Vector_cross_product) {
 	auto result = static_cast<Vector3f>(CrossProduct(Vector3f{ 0, 1, 0 }, Vector3f{ 0, 0, 1 }));
 	ASSERT_TRUE(equal(Vector3f{ 1.0f, 0.0f, 0.0f }, result));
-}
\ No newline at end of file
+}
+
+// SSE products sum in the same order as MatrixProduct and agree bit for bit. With fused multiply-add a sum of 4 terms
+// is rounded 4 times instead of 7, every rounding off by at most half an ULP of the sum of the absolute values of the
+// terms, so the two differ by at most 11 halves of that ULP
+static auto ExpectSameProduct(Float32 expected, Float32 actual, Float32 magnitude) -> void {
+#if defined(__FMA__) || defined(__AVX2__)
+	auto ulp = std::nextafter(magnitude, std::numeric_limits<Float32>::infinity()) - magnitude;
+	EXPECT_LE(std::abs(expected - actual), 5.5f * ulp) << expected << " " << actual;
+#else
+	EXPECT_EQ(expected, actual);
+#endif
+}
+
+// element (i, j) is the sum of |lhs(i, k) * rhs(k, j)|
+template<size_type COL>
+static auto AbsoluteProduct(Matrix4x4f const& lhs, Matrix<Float32, 4, COL> const& rhs) -> Matrix<Float32, 4, COL> {
+	auto ret = Matrix<Float32, 4, COL>{};
+	for (auto i = 0u; i < 4; ++i) {
+		for (auto j = 0u; j < COL; ++j) {
+			ret(i, j) = 0.0f;
+			for (auto k = 0u; k < 4; ++k) {
+				ret(i, j) += std::abs(lhs(i, k) * rhs(k, j));
+			}
+		}
+	}
+	return ret;
+}
+
+TEST_F(MatrixTest, Simd_product_matches_lazy_product) {
+	auto random = std::mt19937{};
+	auto value = std::uniform_real_distribution<Float32>{ -10.0f, 10.0f };
+	for (auto n = 0; n < 1000; ++n) {
+		auto a = Matrix4x4f{};
+		auto b = Matrix4x4f{};
+		auto c = Matrix4x4f{};
+		auto v = Vector4f{};
+		for (auto i = 0u; i < 16; ++i) {
+			a(i) = value(random);
+			b(i) = value(random);
+			c(i) = value(random);
+		}
+		for (auto i = 0u; i < 4; ++i) {
+			v(i) = value(random);
+		}
+
+		auto product = a * b;
+		auto lazyProduct = static_cast<Matrix4x4f>(MatrixProduct<Matrix4x4f, Matrix4x4f>(a, b));
+		auto productMagnitude = AbsoluteProduct(a, b);
+		// the product of the SIMD product, so that differences of the inner one are not compared twice
+		auto chain = a * b * c;
+		auto lazyChain = static_cast<Matrix4x4f>(MatrixProduct<Matrix4x4f, Matrix4x4f>(product, c));
+		auto chainMagnitude = AbsoluteProduct(product, c);
+		for (auto i = 0u; i < 16; ++i) {
+			ExpectSameProduct(lazyProduct(i), product(i), productMagnitude(i));
+			ExpectSameProduct(lazyChain(i), chain(i), chainMagnitude(i));
+		}
+
+		auto transformed = a * v;
+		auto lazyTransformed = static_cast<Vector4f>(MatrixProduct<Matrix4x4f, Vector4f>(a, v));
+		auto transformedMagnitude = AbsoluteProduct(a, v);
+		for (auto i = 0u; i < 4; ++i) {
+			ExpectSameProduct(lazyTransformed(i), transformed(i), transformedMagnitude(i));
+		}
+	}
+}
+
+// an expression may refer to evaluated matrices owned by its caller, never to another expression which would be a
+// temporary destroyed at the end of the statement that built it
+template<typename T>
+struct IsEvaluated : std::false_type {
+};
+
+template<typename T, size_type ROW, size_type COL>
+struct IsEvaluated<Matrix<T, ROW, COL>> : std::true_type {
+};
+
+template<typename Operand>
+constexpr auto HoldsOnlyMatrixByReference() -> bool {
+	return !std::is_reference<Operand>::value || IsEvaluated<std::decay_t<Operand>>::value;
+}
+
+using Matrix3x3f = Matrix<Float32, 3, 3>;
+using Product3x3 = MatrixProduct<Matrix3x3f, Matrix3x3f>;
+static_assert(HoldsOnlyMatrixByReference<Product3x3::lhs_type>(), "");
+static_assert(std::is_reference<Product3x3::lhs_type>::value, "matrix operands are not copied");
+static_assert(std::is_same<MatrixProduct<Product3x3, Matrix3x3f>::lhs_type, Matrix3x3f const>::value, "nested product is evaluated");
+static_assert(std::is_same<MatrixProduct<Matrix3x3f, Product3x3>::rhs_type, Matrix3x3f const>::value, "nested product is evaluated");
+static_assert(std::is_same<MatrixTranspose<Product3x3>::operand_type, Product3x3 const>::value, "");
+static_assert(std::is_same<MatrixAdd<MatrixTranspose<Matrix3x3f>, Matrix3x3f>::lhs_type, MatrixTranspose<Matrix3x3f> const>::value, "element-wise operands stay lazy");
+static_assert(std::is_same<MatrixProduct<MatrixNegate<Matrix3x3f>, Matrix3x3f>::lhs_type, MatrixNegate<Matrix3x3f> const>::value, "element-wise operands stay lazy");
+static_assert(HoldsOnlyMatrixByReference<MatrixNegate<Product3x3>::operand_type>(), "");
+static_assert(HoldsOnlyMatrixByReference<MatrixScalarMultiply<Product3x3>::operand_type>(), "");
+static_assert(HoldsOnlyMatrixByReference<MatrixSubtract<Product3x3, Product3x3>::rhs_type>(), "");
+static_assert(HoldsOnlyMatrixByReference<VectorCrossProduct<MatrixNegate<Vector3f>>::operand_type>(), "");
+// temporary matrices are moved into the expressions built from them
+static_assert(std::is_same<decltype(Transpose(std::declval<Matrix3x3f>()))::operand_type, MatrixTemporary<Matrix3x3f> const>::value, "");
+static_assert(std::is_same<decltype(-std::declval<Matrix3x3f>())::operand_type, MatrixTemporary<Matrix3x3f> const>::value, "");
+static_assert(std::is_same<decltype(std::declval<Matrix3x3f>() * 2.0f)::operand_type, MatrixTemporary<Matrix3x3f> const>::value, "");
+static_assert(std::is_same<decltype(std::declval<Matrix3x3f>() + std::declval<Matrix3x3f const&>())::lhs_type, MatrixTemporary<Matrix3x3f> const>::value, "");
+static_assert(std::is_same<decltype(std::declval<Matrix3x3f const&>() - std::declval<Matrix3x3f>())::rhs_type, MatrixTemporary<Matrix3x3f> const>::value, "");
+static_assert(std::is_same<decltype(std::declval<Matrix3x3f>() * std::declval<Matrix3x3f>())::rhs_type, MatrixTemporary<Matrix3x3f> const>::value, "");
+static_assert(std::is_same<decltype(CrossProduct(std::declval<Vector3f>(), std::declval<Vector3f const&>()))::operand_type, MatrixTemporary<Vector3f> const>::value, "");
+// products of evaluated 4x4 matrices stay SSE whether the operands are temporaries or not
+static_assert(std::is_same<decltype(std::declval<Matrix4x4f>() * std::declval<Matrix4x4f>()), Matrix4x4f>::value, "");
+static_assert(std::is_same<decltype(std::declval<Matrix4x4f>() * std::declval<Vector4f const&>()), Vector4f>::value, "");
+static_assert(Matrix_traits<MatrixTranspose<MatrixProduct<Matrix3x4f, Matrix4x4f>>>::rows == 4, "");
+static_assert(Matrix_traits<MatrixTranspose<MatrixProduct<Matrix3x4f, Matrix4x4f>>>::columns == 3, "");
+
+TEST_F(MatrixTest, Stored_expression_outlives_temporaries) {
+	auto a = Matrix3x3f{ 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	auto b = Matrix3x3f{ 0, 1, 0, 1, 0, 0, 0, 0, 2 };
+	auto c = Matrix3x3f{ 2, 0, 0, 0, 2, 0, 1, 0, 1 };
+	auto ab = static_cast<Matrix3x3f>(MatrixProduct<Matrix3x3f, Matrix3x3f>(a, b));
+	auto abc = static_cast<Matrix3x3f>(MatrixProduct<Matrix3x3f, Matrix3x3f>(ab, c));
+
+	// the temporary product of a and b is gone by the time these are evaluated
+	auto chain = a * b * c;
+	auto transposed = Transpose(a * b) - -c;
+	for (auto i = 0u; i < 3; ++i) {
+		for (auto j = 0u; j < 3; ++j) {
+			ASSERT_EQ(abc(i, j), chain(i, j));
+			ASSERT_EQ(ab(j, i) + c(i, j), transposed(i, j));
+		}
+	}
+}
+
+// reference inverse by Gauss-Jordan elimination with partial pivoting in double precision
+static auto ReferenceInverse(Matrix4x4f const& matrix, double (&inverse)[4][4]) -> void {
+	double m[4][8];
+	for (auto i = 0u; i < 4; ++i) {
+		for (auto j = 0u; j < 4; ++j) {
+			m[i][j] = matrix(i, j);
+			m[i][j + 4] = i == j ? 1.0 : 0.0;
+		}
+	}
+	for (auto column = 0u; column < 4; ++column) {
+		auto pivot = column;
+		for (auto i = column + 1; i < 4; ++i) {
+			pivot = std::abs(m[i][column]) > std::abs(m[pivot][column]) ? i : pivot;
+		}
+		std::swap(m[column], m[pivot]);
+		for (auto i = 0u; i < 4; ++i) {
+			if (i != column) {
+				auto factor = m[i][column] / m[column][column];
+				for (auto j = 0u; j < 8; ++j) {
+					m[i][j] -= factor * m[column][j];
+				}
+			}
+		}
+	}
+	for (auto i = 0u; i < 4; ++i) {
+		for (auto j = 0u; j < 4; ++j) {
+			inverse[i][j] = m[i][j + 4] / m[i][i];
+		}
+	}
+}
+
+static auto MaxNorm(double const (&m)[4][4]) -> double {
+	auto ret = 0.0;
+	for (auto i = 0u; i < 4; ++i) {
+		auto sum = 0.0;
+		for (auto j = 0u; j < 4; ++j) {
+			sum += std::abs(m[i][j]);
+		}
+		ret = std::max(ret, sum);
+	}
+	return ret;
+}
+
+TEST_F(MatrixTest, Inverse_accuracy_against_condition_number) {
+	auto random = std::mt19937{};
+	auto value = std::uniform_real_distribution<Float32>{ -1.0f, 1.0f };
+	auto randomMatrix = [&]() {
+		auto ret = Matrix4x4f{};
+		for (auto i = 0u; i < 16; ++i) {
+			ret(i) = value(random);
+		}
+		return ret;
+	};
+	// singular values spread further apart for higher condition numbers
+	for (auto spread : { 1.0f, 10.0f, 100.0f, 1000.0f }) {
+		for (auto n = 0; n < 200; ++n) {
+			auto scale = Matrix4x4f{
+				1, 0, 0, 0,
+				0, 1 / std::sqrt(spread), 0, 0,
+				0, 0, std::sqrt(spread), 0,
+				0, 0, 0, 1 / spread,
+			};
+			auto matrix = randomMatrix() * scale * randomMatrix();
+			double expected[4][4];
+			ReferenceInverse(matrix, expected);
+			double m[4][4];
+			for (auto i = 0u; i < 4; ++i) {
+				for (auto j = 0u; j < 4; ++j) {
+					m[i][j] = matrix(i, j);
+				}
+			}
+			auto condition = MaxNorm(m) * MaxNorm(expected);
+			auto inverse = Inverse(matrix);
+			double error[4][4];
+			for (auto i = 0u; i < 4; ++i) {
+				for (auto j = 0u; j < 4; ++j) {
+					error[i][j] = inverse(i, j) - expected[i][j];
+				}
+			}
+			ASSERT_LE(MaxNorm(error) / MaxNorm(expected), 2 * condition * std::numeric_limits<Float32>::epsilon()) << "condition number " << condition;
+		}
+	}
+}
+
+TEST_F(MatrixTest, Rigid_body_inverse_and_normal_matrix) {
+	// rotation by 0.5 around (1, 2, 2) / 3 followed by translation
+	auto c = std::cos(0.5f);
+	auto s = std::sin(0.5f);
+	auto t = 1 - c;
+	auto x = 1.0f / 3;
+	auto y = 2.0f / 3;
+	auto z = 2.0f / 3;
+	auto rigid = Matrix4x4f{
+		c + t*x*x,		t*x*y - s*z,	t*x*z + s*y,	4,
+		t*x*y + s*z,	c + t*y*y,		t*y*z - s*x,	-5,
+		t*x*z - s*y,	t*y*z + s*x,	c + t*z*z,		6,
+		0,				0,				0,				1,
+	};
+	auto identity = Matrix4x4f{};
+	auto product = RigidBodyInverse(rigid) * rigid;
+	for (auto i = 0u; i < 16; ++i) {
+		ASSERT_NEAR(identity(i), product(i), 1e-5f);
+	}
+
+	// for a rotation the normal matrix is the rotation itself, scale is inverted
+	auto normal = InverseTranspose3x3(rigid);
+	for (auto i = 0u; i < 3; ++i) {
+		for (auto j = 0u; j < 3; ++j) {
+			ASSERT_NEAR(rigid(i, j), normal(i, j), 1e-5f);
+		}
+		ASSERT_EQ(0.0f, normal(i, 3));
+		ASSERT_EQ(0.0f, normal(3, i));
+	}
+	ASSERT_EQ(1.0f, normal(3, 3));
+	auto scaled = rigid * Matrix4x4f{
+		2, 0, 0, 0,
+		0, 0.5f, 0, 0,
+		0, 0, 8, 0,
+		0, 0, 0, 1,
+	};
+	normal = InverseTranspose3x3(scaled);
+	auto general = Inverse(scaled);
+	for (auto i = 0u; i < 3; ++i) {
+		for (auto j = 0u; j < 3; ++j) {
+			ASSERT_NEAR(general(j, i), normal(i, j), 1e-5f);
+		}
+	}
+}
+
+TEST_F(MatrixTest, Stored_expressions_of_temporary_matrices) {
+	auto transposed = Transpose(Matrix<Float32, 2, 3>{ 1, 2, 3, 4, 5, 6 });
+	auto cross = CrossProduct(Vector3f{ 0, 1, 0 }, Vector3f{ 0, 0, 1 });
+	auto sum = Vector3f{ 1, 2, 3 } + Vector3f{ 1, 1, 1 } * 2.0f;
+	// overwrite the stack the temporaries lived on
+	auto other = Matrix4x4f{ 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9 };
+	ASSERT_EQ(9.0f, other(0));
+	ASSERT_TRUE(equal(Matrix<Float32, 3, 2>{ 1, 4, 2, 5, 3, 6 }, static_cast<Matrix<Float32, 3, 2>>(transposed)));
+	ASSERT_TRUE(equal(Vector3f{ 1, 0, 0 }, static_cast<Vector3f>(cross)));
+	ASSERT_TRUE(equal(Vector3f{ 3, 4, 5 }, static_cast<Vector3f>(sum)));
+}
@@ -0,0 +1,315 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "core/MeshBvh.h"
+
+using namespace core;
+
+class MeshBvhTest : public ::testing::Test {
+public:
+	struct Hit {
+	public:
+		Float32 distance;
+		unsigned int triangleIndex;
+		Float32 u;
+		Float32 v;
+	};
+public:
+	// count triangles of random size up to maxSize in the cube [-range, range]
+	auto RandomMesh(unsigned int count, Float32 range, Float32 maxSize) -> Mesh<Vertex> {
+		auto center = std::uniform_real_distribution<Float32>{ -range, range };
+		auto offset = std::uniform_real_distribution<Float32>{ -maxSize, maxSize };
+		auto vertexes = std::vector<Vertex>{};
+		for (auto i = 0u; i < count; ++i) {
+			auto triangleCenter = Vector3f{ center(_random), center(_random), center(_random) };
+			for (auto j = 0u; j < 3; ++j) {
+				vertexes.push_back(MakeVertex(triangleCenter(0) + offset(_random), triangleCenter(1) + offset(_random), triangleCenter(2) + offset(_random)));
+			}
+		}
+		return Mesh<Vertex>{ std::move(vertexes) };
+	}
+	// size x size quads of 2 triangles on the plane z = 0, from (0, 0) to (size, size)
+	static auto FlatMesh(unsigned int size) -> Mesh<Vertex> {
+		auto vertexes = std::vector<Vertex>{};
+		auto index = std::vector<unsigned int>{};
+		for (auto y = 0u; y <= size; ++y) {
+			for (auto x = 0u; x <= size; ++x) {
+				vertexes.push_back(MakeVertex(static_cast<Float32>(x), static_cast<Float32>(y), 0.0f));
+			}
+		}
+		for (auto y = 0u; y < size; ++y) {
+			for (auto x = 0u; x < size; ++x) {
+				auto first = y * (size + 1) + x;
+				index.insert(index.end(), { first, first + 1, first + size + 2, first, first + size + 2, first + size + 1 });
+			}
+		}
+		return Mesh<Vertex>{ std::move(vertexes), std::move(index) };
+	}
+	static auto MakeVertex(Float32 x, Float32 y, Float32 z) -> Vertex {
+		return Vertex{ Vector3f{ x, y, z }, Vector3f{ 0.0f, 0.0f, 1.0f }, Vector2f{ 0.0f, 0.0f } };
+	}
+	static auto GetTriangle(Mesh<Vertex> const& mesh, unsigned int triangleIndex) -> std::array<Point4f, 3> {
+		auto ret = std::array<Point4f, 3>{};
+		for (auto i = 0u; i < 3; ++i) {
+			auto const& coord = mesh.GetVertex()[mesh.GetIndex()[triangleIndex * 3 + i]].coord;
+			ret[i] = Point4f{ coord(0), coord(1), coord(2), 1.0f };
+		}
+		return ret;
+	}
+	// closest hit within ray length among all triangles of mesh, distance -1 if missed
+	static auto IntersectBruteForce(Mesh<Vertex> const& mesh, Ray const& ray) -> Hit {
+		auto ret = Hit{ -1.0f, 0u, 0.0f, 0.0f };
+		for (auto i = 0u; i < mesh.GetIndex().size() / 3; ++i) {
+			auto u = 0.0f;
+			auto v = 0.0f;
+			auto distance = Triangle::IntersectRay(ray, GetTriangle(mesh, i), u, v);
+			if (distance > 0 && distance <= ray.length && (ret.distance < 0 || distance < ret.distance)) {
+				ret = Hit{ distance, i, u, v };
+			}
+		}
+		return ret;
+	}
+	// compares IntersectRay with brute force, returns hit count
+	static auto CheckRays(Mesh<Vertex> const& mesh, MeshBvh const& bvh, std::vector<Ray> const& rays) -> unsigned int {
+		auto ret = 0u;
+		for (auto i = 0u; i < rays.size(); ++i) {
+			auto expected = IntersectBruteForce(mesh, rays[i]);
+			auto actual = Hit{ -1.0f, 0u, 0.0f, 0.0f };
+			actual.distance = bvh.IntersectRay(rays[i], actual.triangleIndex, actual.u, actual.v);
+			EXPECT_EQ(expected.distance > 0, actual.distance > 0) << "ray " << i;
+			if (expected.distance > 0 && actual.distance > 0) {
+				EXPECT_EQ(expected.triangleIndex, actual.triangleIndex) << "ray " << i;
+				EXPECT_NEAR(expected.distance, actual.distance, 1e-4f * std::max(1.0f, expected.distance)) << "ray " << i;
+				EXPECT_NEAR(expected.u, actual.u, 1e-4f) << "ray " << i;
+				EXPECT_NEAR(expected.v, actual.v, 1e-4f) << "ray " << i;
+				++ret;
+			}
+		}
+		return ret;
+	}
+	// rays from random points in [-range, range] towards random points in [-targetRange, targetRange]
+	auto RandomRays(unsigned int count, Float32 range, Float32 targetRange, Float32 length) -> std::vector<Ray> {
+		auto origin = std::uniform_real_distribution<Float32>{ -range, range };
+		auto target = std::uniform_real_distribution<Float32>{ -targetRange, targetRange };
+		auto ret = std::vector<Ray>{};
+		for (auto i = 0u; i < count; ++i) {
+			auto from = Point4f{ origin(_random), origin(_random), origin(_random), 1.0f };
+			auto to = Point4f{ target(_random), target(_random), target(_random), 1.0f };
+			ret.push_back(Ray{ from, Normalize(static_cast<Vector4f>(to - from)), length });
+		}
+		return ret;
+	}
+	// traversal without front to back ordering and without clipping the ray at hits, as a baseline for IntersectRay
+	static auto IntersectUnordered(MeshBvh const& bvh, Ray const& ray) -> Hit {
+		auto ret = Hit{ -1.0f, 0u, 0.0f, 0.0f };
+		auto const& nodes = bvh.GetNodes();
+		auto const slabRay = SlabRay{ ray };
+		auto const rayLanes = RayLanes{ ray };
+		auto nodeStack = std::array<unsigned int, MeshBvh::MaxDepth>{};
+		auto stackSize = 0u;
+		nodeStack[stackSize++] = 0u;
+		while (stackSize > 0) {
+			auto nodeIndex = nodeStack[--stackSize];
+			auto const& node = nodes[nodeIndex];
+			if (node.IntersectRay(slabRay) < 0) {
+				continue;
+			}
+			if (!node.IsLeaf()) {
+				nodeStack[stackSize++] = node.offset;
+				nodeStack[stackSize++] = nodeIndex + 1;
+				continue;
+			}
+			auto const leafEnd = node.offset + node.primitiveCount;
+			for (auto first = node.offset; first < leafEnd; first += TriangleBlock::Size) {
+				auto lane = 0u;
+				auto u = 0.0f;
+				auto v = 0.0f;
+				auto count = std::min(TriangleBlock::Size, leafEnd - first);
+				auto distance = Triangle::IntersectRay4(rayLanes, ray.length, bvh.GetTriangleBlocks()[first / TriangleBlock::Size], count, lane, u, v);
+				if (distance > 0 && (ret.distance < 0 || distance < ret.distance)) {
+					ret = Hit{ distance, bvh.GetTriangleIndex()[first + lane], u, v };
+				}
+			}
+		}
+		return ret;
+	}
+	// leaves start at multiples of TriangleBlock::Size and are padded up to the next one, without gaps between them
+	static auto CheckLeafPadding(MeshBvh const& bvh) -> void {
+		auto leaves = std::vector<BvhNode>{};
+		for (auto const& node : bvh.GetNodes()) {
+			if (node.IsLeaf()) {
+				leaves.push_back(node);
+			}
+		}
+		std::sort(leaves.begin(), leaves.end(), [](BvhNode const& lhs, BvhNode const& rhs) { return lhs.offset < rhs.offset; });
+		auto offset = 0u;
+		auto triangleCount = 0u;
+		for (auto const& leaf : leaves) {
+			EXPECT_EQ(offset, leaf.offset);
+			EXPECT_EQ(0u, leaf.offset % TriangleBlock::Size);
+			EXPECT_LE(leaf.primitiveCount, TriangleBlock::Size);
+			offset = leaf.offset + (leaf.primitiveCount + TriangleBlock::Size - 1) / TriangleBlock::Size * TriangleBlock::Size;
+			triangleCount += leaf.primitiveCount;
+		}
+		EXPECT_EQ(bvh.GetTriangleCount(), triangleCount);
+	}
+	// every triangle whose bounds overlap aabb is reported once with its vertexes, padding is not reported
+	static auto CheckForEachTriangle(Mesh<Vertex> const& mesh, MeshBvh const& bvh, Aabb const& aabb) -> void {
+		auto reportCount = std::vector<unsigned int>(mesh.GetIndex().size() / 3, 0u);
+		auto stopped = bvh.ForEachTriangle(aabb, [&mesh, &reportCount](std::array<Point4f, 3> const& triangle, unsigned int triangleIndex) {
+			EXPECT_LT(triangleIndex, reportCount.size());
+			if (triangleIndex < reportCount.size()) {
+				++reportCount[triangleIndex];
+				auto expected = GetTriangle(mesh, triangleIndex);
+				for (auto i = 0u; i < 3; ++i) {
+					for (auto axis = 0u; axis < 4; ++axis) {
+						EXPECT_EQ(expected[i](axis), triangle[i](axis));
+					}
+				}
+			}
+			return false;
+		});
+		EXPECT_FALSE(stopped);
+		for (auto i = 0u; i < reportCount.size(); ++i) {
+			EXPECT_LE(reportCount[i], 1u) << "triangle " << i;
+			auto bounds = Aabb{};
+			for (auto const& vertex : GetTriangle(mesh, i)) {
+				bounds.Expand(vertex);
+			}
+			if (bounds.IntersectAabb(aabb)) {
+				EXPECT_EQ(1u, reportCount[i]) << "triangle " << i;
+			}
+		}
+	}
+protected:
+	std::mt19937 _random;
+};
+
+TEST_F(MeshBvhTest, Random_mesh) {
+	auto mesh = RandomMesh(3000, 10.0f, 1.0f);
+	auto bvh = MeshBvh{ mesh };
+	CheckLeafPadding(bvh);
+	EXPECT_GT(CheckRays(mesh, bvh, RandomRays(500, 20.0f, 10.0f, 100.0f)), 300u);
+	// short rays, most of them stop before the first triangle
+	CheckRays(mesh, bvh, RandomRays(200, 20.0f, 10.0f, 0.5f));
+	CheckRays(mesh, bvh, RandomRays(200, 5.0f, 10.0f, 3.0f));
+	// everything, nothing, and parts of the mesh
+	CheckForEachTriangle(mesh, bvh, Aabb{ Point4f{ -20.0f, -20.0f, -20.0f, 1.0f }, Point4f{ 20.0f, 20.0f, 20.0f, 1.0f } });
+	CheckForEachTriangle(mesh, bvh, Aabb{ Point4f{ 30.0f, 30.0f, 30.0f, 1.0f }, Point4f{ 40.0f, 40.0f, 40.0f, 1.0f } });
+	auto corner = std::uniform_real_distribution<Float32>{ -10.0f, 8.0f };
+	for (auto i = 0u; i < 20; ++i) {
+		auto minVertex = Point4f{ corner(_random), corner(_random), corner(_random), 1.0f };
+		CheckForEachTriangle(mesh, bvh, Aabb{ minVertex, static_cast<Point4f>(minVertex + Vector4f{ 2.0f, 2.0f, 2.0f, 0.0f }) });
+	}
+	// stops at the first triangle f returns true for
+	auto calls = 0u;
+	EXPECT_TRUE(bvh.ForEachTriangle(bvh.GetAabb(), [&calls](std::array<Point4f, 3> const&, unsigned int) { return ++calls == 3; }));
+	EXPECT_EQ(3u, calls);
+}
+
+TEST_F(MeshBvhTest, Flat_mesh) {
+	// every node is flat on z, rays cross it from both sides and run within its plane
+	auto mesh = FlatMesh(24u);
+	auto bvh = MeshBvh{ mesh };
+	CheckLeafPadding(bvh);
+	EXPECT_EQ(0.0f, bvh.GetAabb().GetMinVertex()(2));
+	EXPECT_EQ(0.0f, bvh.GetAabb().GetMaxVertex()(2));
+	auto rays = RandomRays(300, 30.0f, 24.0f, 100.0f);
+	for (auto & ray : rays) {
+		ray.origin = Point4f{ ray.origin(0), ray.origin(1), ray.origin(2) < 0 ? -5.0f : 5.0f, 1.0f };
+		ray.direction = Normalize(Vector4f{ ray.direction(0), ray.direction(1), ray.origin(2) < 0 ? 1.0f : -1.0f, 0.0f });
+	}
+	EXPECT_GT(CheckRays(mesh, bvh, rays), 30u);
+	auto inPlane = Ray{ Point4f{ -1.0f, 3.3f, 0.0f, 1.0f }, Vector4f{ 1.0f, 0.0f, 0.0f, 0.0f }, 100.0f };
+	EXPECT_EQ(0u, CheckRays(mesh, bvh, { inPlane }));
+	CheckForEachTriangle(mesh, bvh, Aabb{ Point4f{ 3.5f, 4.5f, -1.0f, 1.0f }, Point4f{ 7.5f, 5.5f, 1.0f, 1.0f } });
+	CheckForEachTriangle(mesh, bvh, Aabb{ Point4f{ 3.5f, 4.5f, 0.0f, 1.0f }, Point4f{ 7.5f, 5.5f, 0.0f, 1.0f } });
+	CheckForEachTriangle(mesh, bvh, Aabb{ Point4f{ 3.5f, 4.5f, 0.5f, 1.0f }, Point4f{ 7.5f, 5.5f, 1.0f, 1.0f } });
+}
+
+TEST_F(MeshBvhTest, Single_triangle) {
+	auto vertexes = std::vector<Vertex>{ MakeVertex(0.0f, 0.0f, 1.0f), MakeVertex(1.0f, 0.0f, 1.0f), MakeVertex(0.0f, 1.0f, 1.0f) };
+	auto mesh = Mesh<Vertex>{ std::move(vertexes) };
+	auto bvh = MeshBvh{ mesh };
+	ASSERT_EQ(1u, bvh.GetNodes().size());
+	EXPECT_EQ(1u, bvh.GetNodes().front().primitiveCount);
+	EXPECT_EQ(1u, bvh.GetTriangleCount());
+	CheckLeafPadding(bvh);
+	auto triangleIndex = 1u;
+	auto u = 0.0f;
+	auto v = 0.0f;
+	auto ray = Ray{ Point4f{ 0.25f, 0.5f, 0.0f, 1.0f }, Vector4f{ 0.0f, 0.0f, 1.0f, 0.0f }, 2.0f };
+	EXPECT_EQ(1.0f, bvh.IntersectRay(ray, triangleIndex, u, v));
+	EXPECT_EQ(0u, triangleIndex);
+	EXPECT_EQ(0.25f, u);
+	EXPECT_EQ(0.5f, v);
+	ray.origin = Point4f{ 0.75f, 0.5f, 0.0f, 1.0f };
+	EXPECT_EQ(-1.0f, bvh.IntersectRay(ray, triangleIndex, u, v));
+	// the 3 padding copies of the triangle are not reported
+	CheckForEachTriangle(mesh, bvh, bvh.GetAabb());
+	// an empty mesh has no nodes
+	auto empty = Mesh<Vertex>{ std::vector<Vertex>{} };
+	auto emptyBvh = MeshBvh{ empty };
+	EXPECT_TRUE(emptyBvh.GetNodes().empty());
+	EXPECT_EQ(-1.0f, emptyBvh.IntersectRay(ray, triangleIndex, u, v));
+	EXPECT_FALSE(emptyBvh.ForEachTriangle(bvh.GetAabb(), [](std::array<Point4f, 3> const&, unsigned int) { return true; }));
+}
+
+TEST_F(MeshBvhTest, Multiple_threads) {
+	// large enough for the builder to spawn subtree tasks
+	auto mesh = RandomMesh(20000, 30.0f, 1.0f);
+	auto serial = MeshBvh{ mesh };
+	auto parallel = MeshBvh{ mesh, 4u };
+	CheckLeafPadding(parallel);
+	EXPECT_EQ(serial.GetNodes().size(), parallel.GetNodes().size());
+	auto rays = RandomRays(200, 50.0f, 30.0f, 200.0f);
+	EXPECT_GT(CheckRays(mesh, parallel, rays), 100u);
+	for (auto const& ray : rays) {
+		auto serialIndex = 0u;
+		auto parallelIndex = 0u;
+		auto u = 0.0f;
+		auto v = 0.0f;
+		EXPECT_EQ(serial.IntersectRay(ray, serialIndex, u, v), parallel.IntersectRay(ray, parallelIndex, u, v));
+		EXPECT_EQ(serialIndex, parallelIndex);
+	}
+	CheckForEachTriangle(mesh, parallel, Aabb{ Point4f{ -5.0f, -5.0f, -5.0f, 1.0f }, Point4f{ 5.0f, 5.0f, 5.0f, 1.0f } });
+}
+
+// timing only, run with --gtest_also_run_disabled_tests
+TEST_F(MeshBvhTest, DISABLED_Benchmark_front_to_back) {
+	using Clock = std::chrono::high_resolution_clock;
+	auto mesh = RandomMesh(200000, 50.0f, 1.0f);
+	auto bvh = MeshBvh{ mesh };
+	auto rays = RandomRays(20000, 100.0f, 50.0f, 1000.0f);
+
+	auto unorderedHits = std::vector<Hit>{};
+	auto start = Clock::now();
+	for (auto const& ray : rays) {
+		unorderedHits.push_back(IntersectUnordered(bvh, ray));
+	}
+	auto unorderedTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	auto hits = std::vector<Hit>(rays.size(), Hit{ -1.0f, 0u, 0.0f, 0.0f });
+	start = Clock::now();
+	for (auto i = 0u; i < rays.size(); ++i) {
+		hits[i].distance = bvh.IntersectRay(rays[i], hits[i].triangleIndex, hits[i].u, hits[i].v);
+	}
+	auto frontToBackTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	auto hitCount = 0u;
+	for (auto i = 0u; i < rays.size(); ++i) {
+		ASSERT_EQ(unorderedHits[i].distance, hits[i].distance) << "ray " << i;
+		if (hits[i].distance > 0) {
+			ASSERT_EQ(unorderedHits[i].triangleIndex, hits[i].triangleIndex) << "ray " << i;
+			++hitCount;
+		}
+	}
+	std::cout << mesh.GetIndex().size() / 3 << " triangles, " << rays.size() << " rays, " << hitCount << " hits: unordered "
+		<< unorderedTime << " ms, front to back " << frontToBackTime << " ms" << std::endl;
+}
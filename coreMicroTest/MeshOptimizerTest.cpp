@@ -0,0 +1,98 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include "core/MeshOptimizer.h"
+
+using namespace core;
+
+class MeshOptimizerTest : public ::testing::Test {
+public:
+	// size * size quads in the xy plane, triangles in random order
+	auto MakeGrid(unsigned int size) -> Mesh<Vertex> {
+		auto vertexes = std::vector<Vertex>{};
+		for (auto y = 0u; y <= size; ++y) {
+			for (auto x = 0u; x <= size; ++x) {
+				vertexes.push_back(Vertex{ Vector3f{ Float32(x), Float32(y), 0.0f }, Vector3f{ 0.0f, 0.0f, 1.0f }, Vector2f{ 0.0f, 0.0f } });
+			}
+		}
+		auto triangles = std::vector<std::array<unsigned int, 3>>{};
+		for (auto y = 0u; y < size; ++y) {
+			for (auto x = 0u; x < size; ++x) {
+				auto v = y * (size + 1) + x;
+				triangles.push_back({ v, v + 1, v + size + 2 });
+				triangles.push_back({ v, v + size + 2, v + size + 1 });
+			}
+		}
+		std::shuffle(triangles.begin(), triangles.end(), _random);
+		auto index = std::vector<unsigned int>{};
+		for (auto const& triangle : triangles) {
+			index.insert(index.end(), triangle.begin(), triangle.end());
+		}
+		return Mesh<Vertex>{ std::move(vertexes), std::move(index) };
+	}
+	// triangles by vertex positions, rotated so that the smallest position comes first
+	static auto Triangles(Mesh<Vertex> const& mesh) -> std::vector<std::array<Float32, 9>> {
+		auto ret = std::vector<std::array<Float32, 9>>{};
+		auto const& index = mesh.GetIndex();
+		for (auto t = 0u; t < index.size() / 3; ++t) {
+			auto best = std::array<Float32, 9>{};
+			for (auto r = 0u; r < 3; ++r) {
+				auto triangle = std::array<Float32, 9>{};
+				for (auto i = 0u; i < 3; ++i) {
+					auto const& coord = mesh.GetVertex()[index[t * 3 + (i + r) % 3]].coord;
+					for (auto j = 0u; j < 3; ++j) {
+						triangle[i * 3 + j] = coord(j);
+					}
+				}
+				if (r == 0 || triangle < best) {
+					best = triangle;
+				}
+			}
+			ret.push_back(best);
+		}
+		std::sort(ret.begin(), ret.end());
+		return ret;
+	}
+protected:
+	std::mt19937 _random;
+};
+
+TEST_F(MeshOptimizerTest, Improves_vertex_cache_and_keeps_triangles) {
+	auto mesh = MakeGrid(40);
+	auto triangles = Triangles(mesh);
+	auto statistics = OptimizeMesh(mesh);
+	EXPECT_GT(statistics.before.acmr, 2.0f);
+	EXPECT_LT(statistics.after.acmr, 0.8f);
+	EXPECT_LT(statistics.after.atvr, 1.4f);
+	EXPECT_EQ(triangles, Triangles(mesh));
+
+	// vertexes in order of first use
+	auto next = 0u;
+	for (auto v : mesh.GetIndex()) {
+		ASSERT_LE(v, next);
+		next = std::max(next, v + 1);
+	}
+	EXPECT_EQ(mesh.GetVertex().size(), next);
+}
+
+TEST_F(MeshOptimizerTest, Outer_clusters_first) {
+	// a triangle facing away from the center and one facing towards it, on opposite sides
+	auto vertexes = std::vector<Vertex>{
+		Vertex{ Vector3f{ 0, 0, -1 }, Vector3f{ 0, 0, 1 }, Vector2f{ 0, 0 } },
+		Vertex{ Vector3f{ 1, 0, -1 }, Vector3f{ 0, 0, 1 }, Vector2f{ 0, 0 } },
+		Vertex{ Vector3f{ 0, 1, -1 }, Vector3f{ 0, 0, 1 }, Vector2f{ 0, 0 } },
+		Vertex{ Vector3f{ 0, 0, 1 }, Vector3f{ 0, 0, 1 }, Vector2f{ 0, 0 } },
+		Vertex{ Vector3f{ 1, 0, 1 }, Vector3f{ 0, 0, 1 }, Vector2f{ 0, 0 } },
+		Vertex{ Vector3f{ 0, 1, 1 }, Vector3f{ 0, 0, 1 }, Vector2f{ 0, 0 } },
+	};
+	auto index = std::vector<unsigned int>{ 0, 1, 2, 3, 4, 5 };
+	// the first one faces +z towards the center at z = 0, the second one faces +z away from it
+	EXPECT_EQ((std::vector<unsigned int>{ 3, 4, 5, 0, 1, 2 }), OptimizeOverdraw(vertexes, index, { 0, 1 }));
+	auto clusterBegins = std::vector<unsigned int>{};
+	OptimizeVertexCache(index, 6, VertexCacheSize, &clusterBegins);
+	EXPECT_EQ((std::vector<unsigned int>{ 0, 1 }), clusterBegins);
+}
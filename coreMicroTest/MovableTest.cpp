@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+
+#include "core/Movable.h"
+
+using namespace core;
+
+static auto ExpectNear(Matrix4x4f const& expected, Matrix4x4f const& actual) -> void {
+	for (auto i = 0u; i < 16; ++i) {
+		EXPECT_NEAR(expected(i), actual(i), 1e-5f) << "element " << i;
+	}
+}
+
+TEST(MovableTest, World_transform_follows_parent) {
+	auto parent = Movable{};
+	auto child = Movable{};
+	auto grandchild = Movable{};
+	child.Translate(1, 0, 0);
+	grandchild.Scale(2, 2, 2);
+	child.AttachTo(parent);
+	grandchild.AttachTo(child);
+
+	auto version = grandchild.GetTransformVersion();
+	ASSERT_EQ(version, grandchild.GetTransformVersion());
+	parent.Rotate(0, 0, 1, pi / 2);
+	parent.Translate(0, 0, 5);
+	ASSERT_NE(version, grandchild.GetTransformVersion());
+	ExpectNear(static_cast<Matrix4x4f>(parent.GetTransform() * child.GetLocalTransform().ToMatrix()), child.GetTransform());
+	ExpectNear(static_cast<Matrix4x4f>(child.GetTransform() * grandchild.GetLocalTransform().ToMatrix()), grandchild.GetTransform());
+	auto position = grandchild.GetPosition();
+	EXPECT_NEAR(0.0f, position(0), 1e-5f);
+	EXPECT_NEAR(1.0f, position(1), 1e-5f);
+	EXPECT_NEAR(5.0f, position(2), 1e-5f);
+
+	// moving a child leaves its parent alone
+	version = parent.GetTransformVersion();
+	child.Translate(0, 1, 0);
+	ASSERT_EQ(version, parent.GetTransformVersion());
+
+	// a detached node keeps its world transform
+	auto world = grandchild.GetTransform();
+	grandchild.DetachFrom();
+	ExpectNear(world, grandchild.GetTransform());
+	version = grandchild.GetTransformVersion();
+	parent.Translate(1, 1, 1);
+	ASSERT_EQ(version, grandchild.GetTransformVersion());
+}
+
+TEST(MovableTest, Rigid_body_inverse_of_attached_camera) {
+	auto parent = Movable{};
+	auto camera = Movable{};
+	parent.Rotate(0, 0, 1, 0.3f);
+	parent.Translate(4, -2, 1);
+	camera.Rotate(1, 1, 0, 1.1f);
+	camera.Translate(0, 3, 0);
+	camera.AttachTo(parent);
+	ExpectNear(Matrix4x4f{}, camera.GetRigidBodyMatrixInverse() * camera.GetTransform());
+	parent.Translate(1, 0, 0);
+	ExpectNear(Inverse(camera.GetTransform()), camera.GetRigidBodyMatrixInverse());
+
+	// directions follow the world rotation, the parent's included
+	auto forward = camera.GetForwardDirection();
+	auto expected = camera.GetTransform() * Vector4f{ 0, 1, 0, 0 };
+	for (auto i = 0u; i < 3; ++i) {
+		EXPECT_NEAR(expected(i), forward(i), 1e-5f);
+	}
+	auto rotation = static_cast<Matrix4x4f>(camera.GetRotationInverse() * camera.GetTransform());
+	for (auto i = 0u; i < 3; ++i) {
+		for (auto j = 0u; j < 3; ++j) {
+			EXPECT_NEAR(i == j ? 1.0f : 0.0f, rotation(i, j), 1e-5f);
+		}
+	}
+}
@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "core/OcclusionBuffer.h"
+
+using namespace core;
+
+class OcclusionBufferTest : public ::testing::Test {
+public:
+	// camera at origin looking at -z, 90 degrees field of view, near plane at 1, far plane at 100
+	OcclusionBufferTest() {
+		auto nearPlane = 1.0f;
+		auto farPlane = 100.0f;
+		_viewProject = Matrix4x4f{
+			nearPlane, 0, 0, 0,
+			0, nearPlane, 0, 0,
+			0, 0, -(farPlane + nearPlane) / (farPlane - nearPlane), -2 * farPlane * nearPlane / (farPlane - nearPlane),
+			0, 0, -1, 0,
+		};
+	}
+public:
+	static auto MakeVertex(Float32 x, Float32 y, Float32 z) -> Vertex {
+		return Vertex{ Vector3f{ x, y, z }, Vector3f{ 0, 0, 1 }, Vector2f{ 0, 0 } };
+	}
+	// square facing the camera at distance
+	static auto MakeWall(Float32 minX, Float32 minY, Float32 maxX, Float32 maxY, Float32 distance) -> Mesh<Vertex> {
+		auto vertexes = std::vector<Vertex>{
+			MakeVertex(minX, minY, -distance),
+			MakeVertex(maxX, minY, -distance),
+			MakeVertex(maxX, maxY, -distance),
+			MakeVertex(minX, maxY, -distance),
+		};
+		return Mesh<Vertex>{ std::move(vertexes), std::vector<unsigned int>{ 0, 1, 2, 0, 2, 3 } };
+	}
+	static auto MakeAabb(Float32 minX, Float32 minY, Float32 minZ, Float32 maxX, Float32 maxY, Float32 maxZ) -> Aabb {
+		return Aabb{ Point4f{ minX, minY, minZ, 1 }, Point4f{ maxX, maxY, maxZ, 1 } };
+	}
+	// window space depth of a point on the view axis
+	auto GetWindowDepth(Float32 distance) const -> Float32 {
+		auto clip = static_cast<Point4f>(_viewProject * Point4f{ 0, 0, -distance, 1 });
+		return clip(2) / clip(3) * 0.5f + 0.5f;
+	}
+protected:
+	Matrix4x4f _viewProject;
+	Matrix4x4f _identity;
+};
+
+TEST_F(OcclusionBufferTest, Wall_hides_boxes_behind_it) {
+	auto wall = MakeWall(-4, -4, 4, 4, 5);
+	auto buffer = OcclusionBuffer{};
+	buffer.Begin(_viewProject);
+	buffer.AddOccluder(wall, _identity);
+	buffer.Rasterize();
+
+	ASSERT_NEAR(GetWindowDepth(5), buffer.GetDepth(OcclusionBuffer::Width / 2, OcclusionBuffer::Height / 2), 1e-5f);
+	ASSERT_EQ(1.0f, buffer.GetDepth(0, 0));
+
+	ASSERT_FALSE(buffer.IsVisible(MakeAabb(-1, -1, -20, 1, 1, -10)));
+	ASSERT_TRUE(buffer.IsVisible(MakeAabb(-1, -1, -4, 1, 1, -3))); // in front of the wall
+	ASSERT_TRUE(buffer.IsVisible(MakeAabb(10, -1, -20, 12, 1, -15))); // beside it
+	ASSERT_TRUE(buffer.IsVisible(MakeAabb(-1, -1, -20, 1, 1, 0))); // crossing the near plane
+	ASSERT_TRUE(buffer.IsVisible(MakeAabb(-4, -4, -5, 4, 4, -5))); // the wall itself
+}
+
+TEST_F(OcclusionBufferTest, Near_plane_clipping) {
+	// floor from behind the camera to far away, it hides what is below it
+	auto vertexes = std::vector<Vertex>{
+		MakeVertex(-50, -1, 10),
+		MakeVertex(50, -1, 10),
+		MakeVertex(50, -1, -90),
+		MakeVertex(-50, -1, -90),
+	};
+	auto floor = Mesh<Vertex>{ std::move(vertexes), std::vector<unsigned int>{ 0, 1, 2, 0, 2, 3 } };
+	auto buffer = OcclusionBuffer{};
+	buffer.Begin(_viewProject);
+	buffer.AddOccluder(floor, _identity);
+	buffer.Rasterize();
+
+	ASSERT_FALSE(buffer.IsVisible(MakeAabb(-1, -3, -20, 1, -2, -10)));
+	ASSERT_TRUE(buffer.IsVisible(MakeAabb(-1, 0, -20, 1, 1, -10)));
+	ASSERT_EQ(1.0f, buffer.GetDepth(OcclusionBuffer::Width / 2, OcclusionBuffer::Height - 1));
+}
+
+TEST_F(OcclusionBufferTest, Threads_produce_same_buffer) {
+	auto random = std::mt19937{};
+	auto position = std::uniform_real_distribution<Float32>{ -20.0f, 20.0f };
+	auto distance = std::uniform_real_distribution<Float32>{ 2.0f, 60.0f };
+	auto meshes = std::vector<Mesh<Vertex>>{};
+	meshes.reserve(20);
+	for (auto i = 0u; i < 20; ++i) {
+		auto vertexes = std::vector<Vertex>{};
+		for (auto j = 0u; j < 30; ++j) {
+			vertexes.push_back(MakeVertex(position(random), position(random), -distance(random)));
+		}
+		meshes.emplace_back(std::move(vertexes));
+	}
+	auto single = OcclusionBuffer{ 1u };
+	auto multiple = OcclusionBuffer{ 4u };
+	for (auto * buffer : { &single, &multiple }) {
+		buffer->Begin(_viewProject);
+		for (auto const& mesh : meshes) {
+			buffer->AddOccluder(mesh, _identity);
+		}
+		buffer->Rasterize();
+	}
+	auto covered = 0u;
+	for (auto y = 0u; y < OcclusionBuffer::Height; ++y) {
+		for (auto x = 0u; x < OcclusionBuffer::Width; ++x) {
+			ASSERT_EQ(single.GetDepth(x, y), multiple.GetDepth(x, y));
+			covered += single.GetDepth(x, y) < 1.0f ? 1 : 0;
+		}
+	}
+	ASSERT_GT(covered, 0u);
+
+	// hierarchical test against a plain loop over the pixels each box covers
+	auto size = std::uniform_real_distribution<Float32>{ 0.1f, 5.0f };
+	auto hiddenCount = 0u;
+	for (auto i = 0u; i < 2000; ++i) {
+		auto x = position(random);
+		auto y = position(random);
+		auto z = -distance(random);
+		auto aabb = MakeAabb(x, y, z, x + size(random), y + size(random), z + size(random));
+		auto minX = std::numeric_limits<Float32>::max();
+		auto minY = std::numeric_limits<Float32>::max();
+		auto maxX = std::numeric_limits<Float32>::lowest();
+		auto maxY = std::numeric_limits<Float32>::lowest();
+		auto minZ = std::numeric_limits<Float32>::max();
+		auto crossesNearPlane = false;
+		for (auto const& vertex : aabb.GetVertex()) {
+			auto clip = static_cast<Point4f>(_viewProject * vertex);
+			crossesNearPlane = crossesNearPlane || clip(2) < -clip(3);
+			minX = std::min(minX, (clip(0) / clip(3) * 0.5f + 0.5f) * OcclusionBuffer::Width);
+			maxX = std::max(maxX, (clip(0) / clip(3) * 0.5f + 0.5f) * OcclusionBuffer::Width);
+			minY = std::min(minY, (clip(1) / clip(3) * 0.5f + 0.5f) * OcclusionBuffer::Height);
+			maxY = std::max(maxY, (clip(1) / clip(3) * 0.5f + 0.5f) * OcclusionBuffer::Height);
+			minZ = std::min(minZ, clip(2) / clip(3) * 0.5f + 0.5f);
+		}
+		auto expected = crossesNearPlane;
+		for (auto row = std::max(0, static_cast<int>(minY)); !expected && row <= std::min(static_cast<int>(OcclusionBuffer::Height) - 1, static_cast<int>(maxY)); ++row) {
+			for (auto column = std::max(0, static_cast<int>(minX)); !expected && column <= std::min(static_cast<int>(OcclusionBuffer::Width) - 1, static_cast<int>(maxX)); ++column) {
+				expected = minZ - OcclusionBuffer::DepthBias <= multiple.GetDepth(column, row);
+			}
+		}
+		ASSERT_EQ(expected, multiple.IsVisible(aabb));
+		hiddenCount += expected ? 0 : 1;
+	}
+	ASSERT_GT(hiddenCount, 0u);
+}
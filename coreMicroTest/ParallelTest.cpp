@@ -0,0 +1,44 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "core/Parallel.h"
+
+using namespace core;
+
+TEST(ParallelTest, Every_index_in_one_chunk) {
+	for (auto chunkCount : { 0u, 1u, 3u, 64u }) {
+		auto visits = std::vector<std::atomic<unsigned int>>(1000);
+		auto chunks = std::vector<std::atomic<unsigned int>>(64);
+		ForEachChunk(0u, 1000u, chunkCount, [&visits, &chunks](unsigned int chunk, unsigned int first, unsigned int last) {
+			++chunks[chunk];
+			for (auto i = first; i < last; ++i) {
+				++visits[i];
+			}
+		});
+		for (auto const& visit : visits) {
+			ASSERT_EQ(1u, visit);
+		}
+		for (auto chunk = 0u; chunk < std::max(chunkCount, 1u); ++chunk) {
+			ASSERT_EQ(1u, chunks[chunk]);
+		}
+	}
+}
+
+TEST(ParallelTest, Nested_jobs_and_exceptions) {
+	auto sum = std::atomic<unsigned int>{ 0u };
+	ForEachChunk(0u, 16u, 16u, [&sum](unsigned int, unsigned int first, unsigned int) {
+		ForEachChunk(0u, 100u, 4u, [&sum, first](unsigned int, unsigned int begin, unsigned int end) {
+			sum += (end - begin) * first;
+		});
+	});
+	EXPECT_EQ(100u * 120u, sum);
+
+	EXPECT_THROW(ForEachChunk(0u, 8u, 8u, [](unsigned int chunk, unsigned int, unsigned int) {
+		if (chunk == 5) {
+			throw std::runtime_error{ "chunk 5" };
+		}
+	}), std::runtime_error);
+}
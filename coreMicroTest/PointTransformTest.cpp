@@ -0,0 +1,81 @@
+#include "gtest/gtest.h"
+
+#include <random>
+#include <vector>
+
+#include "core/PointTransform.h"
+#include "core/Vertex.h"
+
+using namespace core;
+
+class PointTransformTest : public ::testing::Test {
+public:
+	PointTransformTest() {
+		auto value = std::uniform_real_distribution<Float32>{ -10.0f, 10.0f };
+		for (auto i = 0u; i < 12; ++i) {
+			_matrix(i) = value(_random);
+		}
+	}
+public:
+	auto RandomVertexes(unsigned int count) -> std::vector<Vertex> {
+		auto value = std::uniform_real_distribution<Float32>{ -100.0f, 100.0f };
+		auto ret = std::vector<Vertex>(count);
+		for (auto & vertex : ret) {
+			vertex.coord = Vector3f{ value(_random), value(_random), value(_random) };
+			vertex.normal = Vector3f{ 0, 0, 1 };
+		}
+		return ret;
+	}
+	auto Transform(Vector3f const& point) const -> Point4f {
+		return _matrix * Point4f{ point(0), point(1), point(2), 1.0f };
+	}
+protected:
+	std::mt19937 _random;
+	Matrix4x4f _matrix;
+};
+
+TEST_F(PointTransformTest, Points_match_matrix_product) {
+	// every count up to a few groups of 4 to cover the scalar tail
+	for (auto count = 0u; count < 14; ++count) {
+		auto vertexes = RandomVertexes(count);
+		auto points = std::vector<Vector3f>{};
+		for (auto const& vertex : vertexes) {
+			points.push_back(vertex.coord);
+		}
+		auto transformed = std::vector<Vector3f>(count);
+		TransformPoints(_matrix, points.data(), transformed.data(), count);
+		auto strided = std::vector<Vector3f>(count);
+		TransformPoints(_matrix, count == 0 ? nullptr : &vertexes[0].coord, strided.data(), count, sizeof(Vertex));
+		for (auto i = 0u; i < count; ++i) {
+			auto expected = Transform(points[i]);
+			for (auto axis = 0u; axis < 3; ++axis) {
+				ASSERT_EQ(expected(axis), transformed[i](axis));
+				ASSERT_EQ(expected(axis), strided[i](axis));
+			}
+		}
+		// in place
+		TransformPoints(_matrix, points.data(), points.data(), count);
+		for (auto i = 0u; i < count; ++i) {
+			for (auto axis = 0u; axis < 3; ++axis) {
+				ASSERT_EQ(transformed[i](axis), points[i](axis));
+			}
+		}
+	}
+}
+
+TEST_F(PointTransformTest, Bounds_match_expanded_aabb) {
+	for (auto count : { 1u, 3u, 4u, 5u, 8u, 1001u }) {
+		auto vertexes = RandomVertexes(count);
+		auto expected = Aabb{};
+		for (auto const& vertex : vertexes) {
+			expected.Expand(Transform(vertex.coord));
+		}
+		auto bounds = TransformBounds(_matrix, &vertexes[0].coord, count, sizeof(Vertex));
+		for (auto axis = 0u; axis < 3; ++axis) {
+			ASSERT_EQ(expected.GetMinVertex()(axis), bounds.GetMinVertex()(axis));
+			ASSERT_EQ(expected.GetMaxVertex()(axis), bounds.GetMaxVertex()(axis));
+		}
+	}
+	auto empty = TransformBounds(_matrix, nullptr, 0);
+	ASSERT_GT(empty.GetMinVertex()(0), empty.GetMaxVertex()(0));
+}
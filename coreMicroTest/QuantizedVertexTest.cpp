@@ -0,0 +1,135 @@
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "core/QuantizedVertex.h"
+
+using namespace core;
+
+class QuantizedVertexTest : public ::testing::Test {
+public:
+	auto RandomNormal() -> Vector3f {
+		auto value = std::normal_distribution<Float32>{};
+		auto x = value(_random);
+		auto y = value(_random);
+		auto z = value(_random);
+		auto length = std::sqrt(x * x + y * y + z * z);
+		return Vector3f{ x / length, y / length, z / length };
+	}
+	auto RandomVertexes(unsigned int count) -> std::vector<Vertex> {
+		auto coord = std::uniform_real_distribution<Float32>{ -50.0f, 200.0f };
+		auto texCoord = std::uniform_real_distribution<Float32>{ -4.0f, 4.0f };
+		auto ret = std::vector<Vertex>{};
+		for (auto i = 0u; i < count; ++i) {
+			ret.push_back(Vertex{ Vector3f{ coord(_random), coord(_random) * 0.1f, coord(_random) }, RandomNormal(), Vector2f{ texCoord(_random), texCoord(_random) } });
+		}
+		return ret;
+	}
+	// from the cross product, acos of a float dot product is too coarse for small angles
+	static auto Angle(Vector3f const& lhs, Vector3f const& rhs) -> Float32 {
+		auto x = double{ lhs(1) } * rhs(2) - double{ lhs(2) } * rhs(1);
+		auto y = double{ lhs(2) } * rhs(0) - double{ lhs(0) } * rhs(2);
+		auto z = double{ lhs(0) } * rhs(1) - double{ lhs(1) } * rhs(0);
+		auto dot = double{ lhs(0) } * rhs(0) + double{ lhs(1) } * rhs(1) + double{ lhs(2) } * rhs(2);
+		return static_cast<Float32>(std::atan2(std::sqrt(x * x + y * y + z * z), dot));
+	}
+	// quantization step of snorm16 coordinates, plus float rounding of decoding
+	static auto CoordTolerance(QuantizationBounds const& bounds, unsigned int i) -> Float32 {
+		return bounds.halfExtent(i) * (0.5f / 32767 + 1e-6f) + std::abs(bounds.center(i)) * 1e-6f;
+	}
+protected:
+	std::mt19937 _random;
+};
+
+TEST_F(QuantizedVertexTest, Snorm) {
+	auto value = std::uniform_real_distribution<Float32>{ -1.0f, 1.0f };
+	for (auto i = 0; i < 10000; ++i) {
+		auto v = value(_random);
+		EXPECT_NEAR(v, DecodeSnorm(EncodeSnorm<int16>(v)), 0.5f / 32767 + 1e-7f);
+		EXPECT_NEAR(v, DecodeSnorm(EncodeSnorm<int8>(v)), 0.5f / 127 + 1e-7f);
+	}
+	EXPECT_EQ(32767, EncodeSnorm<int16>(2.0f));
+	EXPECT_EQ(-32767, EncodeSnorm<int16>(-2.0f));
+	EXPECT_EQ(-1.0f, DecodeSnorm(int16{ -32768 }));
+	EXPECT_EQ(0, EncodeSnorm<int8>(0.0f));
+}
+
+TEST_F(QuantizedVertexTest, Half) {
+	// every half except NaNs survives a round trip
+	for (auto h = 0u; h < 0x10000u; ++h) {
+		if ((h & 0x7c00u) == 0x7c00u && (h & 0x3ffu) != 0) {
+			EXPECT_TRUE(std::isnan(DecodeHalf(static_cast<uint16>(h))));
+			continue;
+		}
+		ASSERT_EQ(h, EncodeHalf(DecodeHalf(static_cast<uint16>(h)))) << "half " << h;
+	}
+	// normal range, relative error of half a unit in the last place
+	auto exponent = std::uniform_int_distribution<int>{ -14, 15 };
+	auto mantissa = std::uniform_real_distribution<Float32>{ 1.0f, 2.0f };
+	for (auto i = 0; i < 10000; ++i) {
+		auto v = std::ldexp(mantissa(_random), exponent(_random)) * (i % 2 == 0 ? 1.0f : -1.0f);
+		EXPECT_LE(std::abs(DecodeHalf(EncodeHalf(v)) - v), std::abs(v) * std::ldexp(1.0f, -11));
+	}
+	EXPECT_EQ(65504.0f, DecodeHalf(EncodeHalf(65504.0f)));
+	EXPECT_TRUE(std::isinf(DecodeHalf(EncodeHalf(65520.0f))));
+	EXPECT_EQ(std::ldexp(1.0f, -24), DecodeHalf(EncodeHalf(std::ldexp(1.0f, -24))));
+	EXPECT_EQ(0.0f, DecodeHalf(EncodeHalf(std::ldexp(1.0f, -26))));
+	// ties go to even
+	EXPECT_EQ(0x3c00u, EncodeHalf(1.0f + std::ldexp(1.0f, -11)));
+	EXPECT_EQ(0x3c02u, EncodeHalf(1.0f + 3 * std::ldexp(1.0f, -11)));
+}
+
+TEST_F(QuantizedVertexTest, Octahedral_normals) {
+	auto maxError = 0.0f;
+	for (auto i = 0; i < 100000; ++i) {
+		auto normal = RandomNormal();
+		int16 encoded[2];
+		EncodeOctahedralSnorm(normal, encoded);
+		maxError = std::max(maxError, Angle(normal, DecodeOctahedralSnorm(encoded)));
+		// unquantized map is exact up to float rounding
+		ASSERT_LT(Angle(normal, DecodeOctahedral(EncodeOctahedral(normal))), 1e-3f);
+	}
+	// about 0.003 degrees
+	EXPECT_LT(maxError, 6e-5f);
+	// poles and the folded edges
+	Vector3f axes[] = { Vector3f{ 0, 0, 1 }, Vector3f{ 0, 0, -1 }, Vector3f{ 1, 0, 0 }, Vector3f{ 0, -1, 0 } };
+	for (auto const& axis : axes) {
+		int16 encoded[2];
+		EncodeOctahedralSnorm(axis, encoded);
+		EXPECT_LT(Angle(axis, DecodeOctahedralSnorm(encoded)), 1e-3f);
+	}
+}
+
+TEST_F(QuantizedVertexTest, VertexQ16) {
+	auto vertexes = RandomVertexes(10000);
+	auto bounds = QuantizationBounds::FromVertexes(vertexes);
+	auto decoded = DecodeVertexes(EncodeVertexes<VertexQ16>(vertexes, bounds), bounds);
+	ASSERT_EQ(vertexes.size(), decoded.size());
+	for (auto i = 0u; i < vertexes.size(); ++i) {
+		for (auto j = 0u; j < 3; ++j) {
+			ASSERT_NEAR(vertexes[i].coord(j), decoded[i].coord(j), CoordTolerance(bounds, j));
+		}
+		ASSERT_LT(Angle(vertexes[i].normal, decoded[i].normal), 6e-5f);
+		for (auto j = 0u; j < 2; ++j) {
+			ASSERT_NEAR(vertexes[i].texCoord(j), decoded[i].texCoord(j), std::max(std::abs(vertexes[i].texCoord(j)) * std::ldexp(1.0f, -11), std::ldexp(1.0f, -25)));
+		}
+	}
+}
+
+TEST_F(QuantizedVertexTest, VertexCoordQ8) {
+	auto vertexes = RandomVertexes(10000);
+	// flat along y
+	for (auto & vertex : vertexes) {
+		vertex.coord(1) = 3.0f;
+	}
+	auto bounds = QuantizationBounds::FromVertexes(vertexes);
+	auto decoded = DecodeVertexes(EncodeVertexes<VertexCoordQ8>(vertexes, bounds), bounds);
+	for (auto i = 0u; i < vertexes.size(); ++i) {
+		for (auto j = 0u; j < 3; ++j) {
+			ASSERT_NEAR(vertexes[i].coord(j), decoded[i].coord(j), CoordTolerance(bounds, j));
+		}
+	}
+	EXPECT_EQ(3.0f, decoded.front().coord(1));
+}
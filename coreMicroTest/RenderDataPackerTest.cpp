@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "core/RenderDataPacker.h"
+
+using namespace core;
+
+TEST(RenderDataPackerTest, Transforms_are_leading_rows_of_world_transform) {
+	auto movables = std::vector<Movable>(5);
+	auto pointers = std::vector<Movable *>{};
+	for (auto i = 0u; i < movables.size(); ++i) {
+		movables[i].Scale(1.0f + i, 2.0f, 0.5f);
+		movables[i].Rotate(1, 2, 3, 0.3f * i);
+		movables[i].Translate(1.0f * i, -2.0f, 3.0f);
+		pointers.push_back(&movables[i]);
+	}
+	movables[4].AttachTo(movables[1]);
+
+	auto packed = std::vector<PackedTransform>(movables.size());
+	PackTransforms(pointers.data(), pointers.size(), packed.data());
+	for (auto i = 0u; i < movables.size(); ++i) {
+		auto const& world = movables[i].GetTransform();
+		for (auto r = 0u; r < 3; ++r) {
+			for (auto c = 0u; c < 4; ++c) {
+				EXPECT_EQ(world(r, c), packed[i].worldTransform(r, c));
+			}
+		}
+	}
+
+	// ranges leave other entries untouched
+	auto marker = PackedTransform{};
+	marker.worldTransform(0, 0) = -1.0f;
+	auto partial = std::vector<PackedTransform>(movables.size(), marker);
+	TransformChangeTracker::Range ranges[] = { { 1, 2 }, { 4, 1 } };
+	PackTransforms(pointers.data(), ranges, 2, partial.data());
+	for (auto i = 0u; i < movables.size(); ++i) {
+		auto expected = i == 0 || i == 3 ? -1.0f : packed[i].worldTransform(0, 0);
+		EXPECT_EQ(expected, partial[i].worldTransform(0, 0)) << "entry " << i;
+	}
+}
+
+TEST(RenderDataPackerTest, Materials) {
+	auto materials = std::vector<Material>(2);
+	materials[0].SetDiffuse(Vector3f{ 0.1f, 0.2f, 0.3f });
+	materials[0].SetEmissive(Vector3f{ 0.4f, 0.5f, 0.6f });
+	materials[0].SetSpecular(Vector3f{ 0.7f, 0.8f, 0.9f });
+	materials[0].SetShininess(16.0f);
+	materials[0].SetTransparency(0.25f);
+	materials[0]._hasDiffuseMap = true;
+	materials[0]._hasNormalMap = true;
+	materials[1].SetDiffuse(Vector3f{ 1, 1, 1 });
+	materials[1].SetEmissive(Vector3f{ 0, 0, 0 });
+	materials[1].SetSpecular(Vector3f{ 0, 0, 0 });
+	materials[1].SetShininess(1.0f);
+	materials[1].SetTransparency(0.0f);
+	materials[1]._hasSpecularMap = true;
+	materials[1]._hasEmissiveMap = true;
+	Material * pointers[] = { &materials[0], &materials[1] };
+
+	PackedMaterial packed[2];
+	PackMaterials(pointers, 2, packed);
+	EXPECT_EQ(PackedMaterial::HasDiffuseMap | PackedMaterial::HasNormalMap, packed[0].flags);
+	EXPECT_EQ(PackedMaterial::HasSpecularMap | PackedMaterial::HasEmissiveMap, packed[1].flags);
+	for (auto i = 0u; i < 3; ++i) {
+		EXPECT_EQ(materials[0].GetDiffuse()(i), packed[0].diffuse(i));
+		EXPECT_EQ(materials[0].GetEmissive()(i), packed[0].emissive(i));
+		EXPECT_EQ(materials[0].GetSpecular()(i), packed[0].specular(i));
+	}
+	EXPECT_EQ(16.0f, packed[0].shininess);
+	EXPECT_EQ(0.25f, packed[0].transparency);
+}
@@ -0,0 +1,335 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include "core/Bvh.h"
+#include "core/Scene.h"
+#include "core/Triangle.h"
+
+using namespace core;
+
+class SceneTest : public ::testing::Test {
+public:
+	// 8 x 8 models on the xy plane, each with one of 3 meshes of random triangles around its origin,
+	// rotated, scaled and lifted by random amounts. the meshes are shared by several shapes.
+	SceneTest() {
+		auto & group = _scene.GetStaticModelGroup();
+		auto coord = std::uniform_real_distribution<Float32>{ -1.0f, 1.0f };
+		auto meshes = std::vector<Mesh<Vertex> *>{};
+		for (auto i = 0u; i < 3; ++i) {
+			auto vertexes = std::vector<Vertex>{};
+			for (auto j = 0u; j < 20 + 30 * i; ++j) {
+				auto center = Vector3f{ coord(_random), coord(_random), coord(_random) };
+				for (auto k = 0u; k < 3; ++k) {
+					auto offset = Vector3f{ coord(_random), coord(_random), coord(_random) };
+					vertexes.push_back(Vertex{ static_cast<Vector3f>(center + offset * 0.4f), Vector3f{ 0.0f, 0.0f, 1.0f }, Vector2f{ 0.0f, 0.0f } });
+				}
+			}
+			meshes.push_back(group.CreateMesh(std::move(vertexes)));
+		}
+		for (auto x = 0u; x < 8; ++x) {
+			for (auto y = 0u; y < 8; ++y) {
+				auto * model = group.CreateModel();
+				model->Scale(1.0f, 1.0f + (x + y) % 2, 1.0f);
+				model->Rotate(coord(_random), coord(_random), coord(_random) + 2.0f, coord(_random) * 3.0f);
+				model->Translate(3.0f * x, 3.0f * y, coord(_random));
+				auto * shape = group.CreateShape(model);
+				shape->SetMesh(meshes[(x * 8 + y) % meshes.size()]);
+			}
+		}
+		group.BuildBvh();
+	}
+public:
+	// closest hit among all triangles of all shapes, tested one by one in world space
+	static auto PickBruteForce(Scene & scene, Ray const& ray) -> Scene::Hit {
+		auto ret = Scene::Hit{ nullptr, 0u, ray.length, 0.0f, 0.0f };
+		for (auto const& shape : scene.GetStaticModelGroup().GetShapes()) {
+			auto const& vertex = shape->GetMesh()->GetVertex();
+			auto const& index = shape->GetMesh()->GetIndex();
+			auto const& transform = shape->GetModel()->GetTransform();
+			for (auto i = 0u; i < index.size() / 3; ++i) {
+				auto triangle = std::array<Point4f, 3>{};
+				for (auto j = 0u; j < 3; ++j) {
+					auto const& coord = vertex[index[i * 3 + j]].coord;
+					triangle[j] = static_cast<Point4f>(transform * Point4f{ coord(0), coord(1), coord(2), 1.0f });
+				}
+				auto u = 0.0f;
+				auto v = 0.0f;
+				auto distance = Triangle::IntersectRay(ray, triangle, u, v);
+				if (distance > 0 && distance <= ray.length && (ret.shape == nullptr || distance < ret.distance)) {
+					ret = Scene::Hit{ shape.get(), i, distance, u, v };
+				}
+			}
+		}
+		return ret;
+	}
+	// picks rays with PickBatch and compares every hit with Picking and with brute force, returns hit count
+	auto CheckPickBatch(std::vector<Ray> const& rays) -> unsigned int {
+		return CheckPickBatch(_scene, rays);
+	}
+	static auto CheckPickBatch(Scene & scene, std::vector<Ray> const& rays) -> unsigned int {
+		auto ret = 0u;
+		auto hits = std::vector<Scene::Hit>(rays.size());
+		scene.PickBatch(rays.data(), hits.data(), static_cast<unsigned int>(rays.size()));
+		for (auto i = 0u; i < rays.size(); ++i) {
+			auto const& hit = hits[i];
+			auto ray = rays[i];
+			auto picked = scene.Picking(ray);
+			EXPECT_EQ(picked, hit.shape != nullptr) << "ray " << i;
+			if (picked && hit.shape != nullptr) {
+				EXPECT_EQ(ray.length, hit.distance) << "ray " << i;
+			}
+			auto expected = PickBruteForce(scene, rays[i]);
+			EXPECT_EQ(expected.shape, hit.shape) << "ray " << i;
+			if (expected.shape != nullptr && expected.shape == hit.shape) {
+				EXPECT_EQ(expected.triangleIndex, hit.triangleIndex) << "ray " << i;
+				EXPECT_NEAR(expected.distance, hit.distance, 1e-3f * std::max(1.0f, expected.distance)) << "ray " << i;
+				EXPECT_NEAR(expected.u, hit.u, 1e-3f) << "ray " << i;
+				EXPECT_NEAR(expected.v, hit.v, 1e-3f) << "ray " << i;
+				++ret;
+			}
+			if (hit.shape == nullptr) {
+				EXPECT_EQ(rays[i].length, hit.distance) << "ray " << i;
+			}
+		}
+		return ret;
+	}
+	// instances are up to date with their models, leaves contain their instances and nodes their children
+	auto CheckBvhBounds() -> void {
+		auto const* bvh = _scene.GetStaticModelGroup().GetBvh();
+		auto const& nodes = bvh->GetNodes();
+		auto const& instances = bvh->GetInstances();
+		for (auto const& instance : instances) {
+			auto const& transform = instance.shape->GetModel()->GetTransform();
+			for (auto i = 0u; i < 16; ++i) {
+				ASSERT_EQ(transform(i), instance.transform(i));
+			}
+			auto const& shapeAabb = instance.shape->GetAabb();
+			for (auto axis = 0u; axis < 3; ++axis) {
+				EXPECT_LE(instance.aabb.GetMinVertex()(axis), shapeAabb.GetMinVertex()(axis) + 1e-4f);
+				EXPECT_GE(instance.aabb.GetMaxVertex()(axis), shapeAabb.GetMaxVertex()(axis) - 1e-4f);
+			}
+		}
+		for (auto nodeIndex = 0u; nodeIndex < nodes.size(); ++nodeIndex) {
+			auto const& node = nodes[nodeIndex];
+			auto contain = [&node, nodeIndex](Float32 const* minVertex, Float32 const* maxVertex) {
+				for (auto axis = 0u; axis < 3; ++axis) {
+					EXPECT_LE(node.minVertex[axis], minVertex[axis]) << "node " << nodeIndex;
+					EXPECT_GE(node.maxVertex[axis], maxVertex[axis]) << "node " << nodeIndex;
+				}
+			};
+			if (node.IsLeaf()) {
+				for (auto i = node.offset; i < node.offset + node.primitiveCount; ++i) {
+					contain(instances[i].aabb.GetMinVertex().data(), instances[i].aabb.GetMaxVertex().data());
+				}
+			} else {
+				contain(nodes[nodeIndex + 1].minVertex, nodes[nodeIndex + 1].maxVertex);
+				contain(nodes[node.offset].minVertex, nodes[node.offset].maxVertex);
+			}
+		}
+	}
+	// rays from eye through a size x size grid on the plane z = 0 over the models, in 4 x 4 tiles
+	static auto MakeGridRays(Point4f const& eye, unsigned int size, Float32 length) -> std::vector<Ray> {
+		auto ret = std::vector<Ray>{};
+		for (auto tileY = 0u; tileY < size; tileY += 4) {
+			for (auto tileX = 0u; tileX < size; tileX += 4) {
+				for (auto y = tileY; y < std::min(tileY + 4, size); ++y) {
+					for (auto x = tileX; x < std::min(tileX + 4, size); ++x) {
+						auto target = Point4f{ -2.0f + 26.0f * x / size, -2.0f + 26.0f * y / size, 0.0f, 1.0f };
+						ret.push_back(Ray{ eye, Normalize(static_cast<Vector4f>(target - eye)), length });
+					}
+				}
+			}
+		}
+		return ret;
+	}
+protected:
+	std::mt19937 _random;
+	Scene _scene;
+};
+
+TEST_F(SceneTest, PickBatch_grid) {
+	// from above, every packet shares direction signs but those at the middle of the grid
+	auto hitCount = CheckPickBatch(MakeGridRays(Point4f{ 11.0f, 10.5f, 30.0f, 1.0f }, 36u, 100.0f));
+	EXPECT_GT(hitCount, 200u);
+	// looking from a corner across the models, rays shortened so that some stop in front of them
+	auto rays = MakeGridRays(Point4f{ -10.0f, -8.0f, 6.0f, 1.0f }, 32u, 100.0f);
+	for (auto i = 0u; i < rays.size(); ++i) {
+		rays[i].length = i % 3 == 0 ? 15.0f + i % 7 : 100.0f;
+	}
+	hitCount = CheckPickBatch(rays);
+	EXPECT_GT(hitCount, 100u);
+}
+
+TEST_F(SceneTest, PickBatch_random) {
+	// incoherent directions, almost every packet falls back to single rays
+	auto coord = std::uniform_real_distribution<Float32>{ -1.0f, 25.0f };
+	auto direction = std::uniform_real_distribution<Float32>{ -1.0f, 1.0f };
+	auto rays = std::vector<Ray>{};
+	for (auto i = 0u; i < 1000; ++i) {
+		auto origin = Point4f{ coord(_random), coord(_random), 3.0f * direction(_random), 1.0f };
+		rays.push_back(Ray{ origin, Normalize(Vector4f{ direction(_random), direction(_random), direction(_random), 0.0f }), 20.0f });
+	}
+	EXPECT_GT(CheckPickBatch(rays), 100u);
+}
+
+TEST_F(SceneTest, PickBatch_partial_packet) {
+	auto rays = MakeGridRays(Point4f{ 11.0f, 10.5f, 30.0f, 1.0f }, 24u, 100.0f);
+	// counts that are not multiples of the packet size leave the last packet partial, down to a single ray
+	for (auto count : { 1u, 5u, 15u, 17u, 31u, 300u }) {
+		CheckPickBatch(std::vector<Ray>(rays.begin() + 100, rays.begin() + 100 + count));
+	}
+	// PickBatch leaves hits past count alone
+	auto hits = std::vector<Scene::Hit>(3, Scene::Hit{ nullptr, 7u, -2.0f, 0.0f, 0.0f });
+	_scene.PickBatch(rays.data(), hits.data(), 2u);
+	EXPECT_EQ(7u, hits[2].triangleIndex);
+	EXPECT_EQ(-2.0f, hits[2].distance);
+}
+
+TEST_F(SceneTest, PickBatch_culled_packet) {
+	// parallel rays straight down, with zero x and y components: one packet beside the models,
+	// one far above them and too short to reach them
+	auto rays = std::vector<Ray>{};
+	for (auto i = 0u; i < 16; ++i) {
+		rays.push_back(Ray{ Point4f{ -20.0f - i % 4, 5.0f + i / 4, 10.0f, 1.0f }, Vector4f{ 0.0f, 0.0f, -1.0f, 0.0f }, 100.0f });
+	}
+	for (auto i = 0u; i < 16; ++i) {
+		rays.push_back(Ray{ Point4f{ 5.0f + i % 4, 5.0f + i / 4, 50.0f, 1.0f }, Vector4f{ 0.0f, 0.0f, -1.0f, 0.0f }, 40.0f });
+	}
+	EXPECT_EQ(0u, CheckPickBatch(rays));
+	// the same rays long enough to reach the models
+	for (auto i = 16u; i < 32; ++i) {
+		rays[i].length = 100.0f;
+	}
+	EXPECT_GT(CheckPickBatch(rays), 0u);
+}
+
+TEST_F(SceneTest, PickBatch_single_ray_continuation) {
+	// packets sharing direction signs where only one ray reaches the models, the others pass far beside them.
+	// the packet bounds overlap the models, the single hitting ray continues the traversal alone.
+	auto rays = std::vector<Ray>{};
+	for (auto packet = 0u; packet < 20; ++packet) {
+		for (auto i = 0u; i < 16; ++i) {
+			// the hitting ray aims at the origin of a model
+			auto x = i == packet % 16 ? 3.0f * (packet % 8) - 0.1f * i : -100.0f - i;
+			auto y = i == packet % 16 ? 3.0f * (packet / 2 % 8) - 0.2f : 50.0f + i;
+			rays.push_back(Ray{ Point4f{ x, y, 10.0f, 1.0f }, Normalize(Vector4f{ 0.01f * i, 0.02f, -1.0f, 0.0f }), 100.0f });
+		}
+	}
+	EXPECT_GT(CheckPickBatch(rays), 10u);
+}
+
+TEST_F(SceneTest, Closest_of_overlapping_instances) {
+	// quads stacked along z, each tilted and scaled at random, so their AABBs overlap over several layers and
+	// the order a vertical ray enters them differs from the order it hits them. the closest hit is often found
+	// after farther ones, in the same leaf or in a later one.
+	auto scene = Scene{};
+	auto & group = scene.GetStaticModelGroup();
+	auto vertexes = std::vector<Vertex>{};
+	for (auto const& corner : { Vector3f{ -1.0f, -1.0f, 0.0f }, Vector3f{ 1.0f, -1.0f, 0.0f }, Vector3f{ 1.0f, 1.0f, 0.0f },
+		Vector3f{ -1.0f, -1.0f, 0.0f }, Vector3f{ 1.0f, 1.0f, 0.0f }, Vector3f{ -1.0f, 1.0f, 0.0f } }) {
+		vertexes.push_back(Vertex{ corner, Vector3f{ 0.0f, 0.0f, 1.0f }, Vector2f{ 0.0f, 0.0f } });
+	}
+	auto * mesh = group.CreateMesh(std::move(vertexes));
+	auto const layerCount = 16u;
+	auto coord = std::uniform_real_distribution<Float32>{ -1.0f, 1.0f };
+	for (auto layer = 0u; layer < layerCount; ++layer) {
+		auto * model = group.CreateModel();
+		auto scale = 1.5f + coord(_random);
+		model->Scale(scale, scale, 1.0f);
+		model->Rotate(1.0f, coord(_random), 0.0f, 1.2f * coord(_random));
+		model->Translate(0.3f * coord(_random), 0.3f * coord(_random), 0.5f * layer);
+		group.CreateShape(model)->SetMesh(mesh);
+	}
+	group.BuildBvh();
+
+	// 8 x 8 rays through the stack, slanted a little, starting at z and heading up or down
+	auto makeRays = [](Float32 z, Float32 dz, Float32 length) {
+		auto ret = std::vector<Ray>{};
+		for (auto y = 0u; y < 8; ++y) {
+			for (auto x = 0u; x < 8; ++x) {
+				auto direction = Normalize(Vector4f{ 0.01f * x, -0.01f * y, dz, 0.0f });
+				ret.push_back(Ray{ Point4f{ -0.4f + 0.1f * x, -0.35f + 0.1f * y, z, 1.0f }, direction, length });
+			}
+		}
+		return ret;
+	};
+	auto const top = 0.5f * layerCount;
+	EXPECT_GT(CheckPickBatch(scene, makeRays(top + 10.0f, -1.0f, 100.0f)), 60u);
+	EXPECT_GT(CheckPickBatch(scene, makeRays(-10.0f, 1.0f, 100.0f)), 60u);
+	// starting within the stack, the layers behind the origin do not count
+	EXPECT_GT(CheckPickBatch(scene, makeRays(0.5f * top, -1.0f, 100.0f)), 60u);
+	EXPECT_GT(CheckPickBatch(scene, makeRays(0.5f * top, 1.0f, 100.0f)), 60u);
+	// too short to reach the stack, or ending within it
+	EXPECT_EQ(0u, CheckPickBatch(scene, makeRays(top + 10.0f, -1.0f, 5.0f)));
+	CheckPickBatch(scene, makeRays(top + 10.0f, -1.0f, 12.0f));
+}
+
+TEST_F(SceneTest, Refit) {
+	auto & group = _scene.GetStaticModelGroup();
+	auto * bvh = group.GetBvh();
+	auto const built = bvh->GetNodes();
+	auto offset = std::uniform_real_distribution<Float32>{ -0.5f, 0.5f };
+	// a few rounds of small moves of every third model keep the tree, only its bounds change
+	for (auto round = 0u; round < 3; ++round) {
+		for (auto i = round; i < group.GetModels().size(); i += 3) {
+			auto & model = group.GetModels()[i];
+			model->Translate(offset(_random), offset(_random), offset(_random));
+			model->Rotate(model->GetPosition(), Vector4f{ 0.0f, 0.0f, 1.0f, 0.0f }, offset(_random));
+		}
+		bvh->Refit();
+		auto const& nodes = bvh->GetNodes();
+		ASSERT_EQ(built.size(), nodes.size());
+		for (auto i = 0u; i < nodes.size(); ++i) {
+			EXPECT_EQ(built[i].offset, nodes[i].offset);
+			EXPECT_EQ(built[i].primitiveCount, nodes[i].primitiveCount);
+		}
+		EXPECT_NEAR(BvhBuilder::ComputeSahCost(nodes), bvh->GetSahCost(), 1e-3f * bvh->GetSahCost());
+		CheckBvhBounds();
+		EXPECT_GT(CheckPickBatch(MakeGridRays(Point4f{ 11.0f, 10.5f, 30.0f, 1.0f }, 24u, 100.0f)), 100u);
+	}
+}
+
+TEST_F(SceneTest, Refit_rebuild) {
+	// swapping every other model with its opposite across the grid keeps the scene bounds but makes refitted
+	// nodes span most of it, the SAH cost grows past RebuildSahCostRatio and Refit builds a new tree
+	auto & group = _scene.GetStaticModelGroup();
+	auto * bvh = group.GetBvh();
+	auto built = std::vector<Shape const*>{};
+	for (auto const& instance : bvh->GetInstances()) {
+		built.push_back(instance.shape);
+	}
+	for (auto i = 0u; i < group.GetModels().size(); i += 2) {
+		auto x = static_cast<Float32>(i / 8);
+		auto y = static_cast<Float32>(i % 8);
+		group.GetModels()[i]->Translate(3.0f * (7.0f - 2.0f * x), 3.0f * (7.0f - 2.0f * y), 0.0f);
+	}
+	bvh->Refit();
+	// a refit keeps the instances in leaf order, a rebuild sorts them into the new leaves
+	auto const& nodes = bvh->GetNodes();
+	auto rebuiltOrder = std::vector<Shape const*>{};
+	for (auto const& instance : bvh->GetInstances()) {
+		rebuiltOrder.push_back(instance.shape);
+	}
+	EXPECT_NE(built, rebuiltOrder);
+	// as cheap as a tree built from scratch over the moved instances, which a refitted one is not
+	auto shapes = std::vector<Shape *>{};
+	for (auto const& shape : group.GetShapes()) {
+		shapes.push_back(shape.get());
+	}
+	auto rebuilt = Bvh{ std::move(shapes) };
+	EXPECT_NEAR(rebuilt.GetSahCost(), bvh->GetSahCost(), 1e-3f * rebuilt.GetSahCost());
+	EXPECT_NEAR(BvhBuilder::ComputeSahCost(nodes), bvh->GetSahCost(), 1e-3f * bvh->GetSahCost());
+	CheckBvhBounds();
+	EXPECT_GT(CheckPickBatch(MakeGridRays(Point4f{ 11.0f, 10.5f, 30.0f, 1.0f }, 32u, 100.0f)), 100u);
+	// refits after the rebuild work on the new tree
+	for (auto i = 1u; i < group.GetModels().size(); i += 4) {
+		group.GetModels()[i]->Translate(0.0f, 0.0f, 0.5f);
+	}
+	bvh->Refit();
+	CheckBvhBounds();
+	EXPECT_GT(CheckPickBatch(MakeGridRays(Point4f{ 11.0f, 10.5f, 30.0f, 1.0f }, 24u, 100.0f)), 100u);
+}
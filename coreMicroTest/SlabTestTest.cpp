@@ -0,0 +1,233 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "core/SlabTest.h"
+
+using namespace core;
+
+class SlabTestTest : public ::testing::Test {
+public:
+	struct Box {
+	public:
+		std::array<Float32, 4> minVertex;
+		std::array<Float32, 4> maxVertex;
+	};
+public:
+	// textbook slab test in double precision, axes with zero direction are a containment test
+	static auto IntersectReference(Ray const& ray, Box const& box) -> Float32 {
+		auto tMin = std::numeric_limits<double>::lowest();
+		auto tMax = std::numeric_limits<double>::max();
+		for (auto axis = 0u; axis < 3; ++axis) {
+			auto origin = static_cast<double>(ray.origin(axis));
+			auto direction = static_cast<double>(ray.direction(axis));
+			if (direction == 0) {
+				if (origin < box.minVertex[axis] || origin > box.maxVertex[axis]) {
+					return -1;
+				}
+				continue;
+			}
+			auto t1 = (box.minVertex[axis] - origin) / direction;
+			auto t2 = (box.maxVertex[axis] - origin) / direction;
+			tMin = std::max(tMin, std::min(t1, t2));
+			tMax = std::min(tMax, std::max(t1, t2));
+		}
+		if (tMax < 0 || tMin > tMax || tMin >= ray.length) {
+			return -1;
+		}
+		return static_cast<Float32>(tMin > 0 ? tMin : tMax);
+	}
+	// slab test of up to 4 boxes, the rest of the lanes padded with zero like the instances of Bvh
+	static auto IntersectBoxes(SlabRay const& ray, std::vector<Box> const& boxes, Float32 t[4]) -> int {
+		Float32 minVertex[3][4] = {};
+		Float32 maxVertex[3][4] = {};
+		for (auto i = 0u; i < boxes.size(); ++i) {
+			for (auto axis = 0u; axis < 3; ++axis) {
+				minVertex[axis][i] = boxes[i].minVertex[axis];
+				maxVertex[axis][i] = boxes[i].maxVertex[axis];
+			}
+		}
+		Float32 const* minPointer[3] = { minVertex[0], minVertex[1], minVertex[2] };
+		Float32 const* maxPointer[3] = { maxVertex[0], maxVertex[1], maxVertex[2] };
+		return IntersectSlab4(ray, minPointer, maxPointer, t);
+	}
+	// compares IntersectSlab with the reference and IntersectSlab4 with IntersectSlab, returns hit count
+	static auto CheckRay(Ray const& ray, std::vector<Box> const& boxes) -> unsigned int {
+		auto ret = 0u;
+		auto slabRay = SlabRay{ ray };
+		for (auto first = 0u; first < boxes.size(); first += 4) {
+			auto count = std::min(4u, static_cast<unsigned int>(boxes.size()) - first);
+			auto lanes = std::vector<Box>(boxes.begin() + first, boxes.begin() + first + count);
+			Float32 t[4];
+			auto mask = IntersectBoxes(slabRay, lanes, t);
+			for (auto i = 0u; i < count; ++i) {
+				auto const& box = lanes[i];
+				auto expected = IntersectReference(ray, box);
+				auto actual = IntersectSlab(slabRay, box.minVertex.data(), box.maxVertex.data());
+				EXPECT_EQ(expected >= 0, actual >= 0) << "box " << first + i;
+				if (expected >= 0 && actual >= 0) {
+					EXPECT_NEAR(expected, actual, 1e-4f * std::max(1.0f, expected)) << "box " << first + i;
+					++ret;
+				}
+				EXPECT_EQ(actual >= 0, (mask & (1 << i)) != 0) << "box " << first + i;
+				if (actual >= 0) {
+					EXPECT_EQ(actual, t[i]) << "box " << first + i;
+				}
+			}
+		}
+		return ret;
+	}
+};
+
+TEST_F(SlabTestTest, PrepareRay) {
+	auto const huge = std::numeric_limits<Float32>::max();
+	auto ray = SlabRay{ Ray{ Point4f{ 1.0f, 2.0f, 3.0f, 1.0f }, Vector4f{ 0.0f, -0.0f, 0.5f, 0.0f }, 10.0f } };
+	Float32 origin[4];
+	Float32 inverseDirection[4];
+	_mm_storeu_ps(origin, ray.origin);
+	_mm_storeu_ps(inverseDirection, ray.inverseDirection);
+	EXPECT_EQ(1.0f, origin[0]);
+	EXPECT_EQ(2.0f, origin[1]);
+	EXPECT_EQ(3.0f, origin[2]);
+	EXPECT_EQ(0.0f, origin[3]);
+	// zero components get a huge reciprocal, a negative zero is no different from a positive one
+	EXPECT_EQ(huge, inverseDirection[0]);
+	EXPECT_EQ(huge, inverseDirection[1]);
+	EXPECT_EQ(2.0f, inverseDirection[2]);
+	EXPECT_EQ(0.0f, inverseDirection[3]);
+	EXPECT_EQ(0u, ray.negativeAxes);
+	EXPECT_EQ(10.0f, ray.length);
+
+	// so do components too small to invert, with their sign
+	ray = SlabRay{ Ray{ Point4f{ 0.0f, 0.0f, 0.0f, 1.0f }, Vector4f{ -1.0f, 1e-9f, -1e-9f, 0.0f }, 1.0f } };
+	_mm_storeu_ps(inverseDirection, ray.inverseDirection);
+	EXPECT_EQ(-1.0f, inverseDirection[0]);
+	EXPECT_EQ(huge, inverseDirection[1]);
+	EXPECT_EQ(-huge, inverseDirection[2]);
+	EXPECT_EQ(0b101u, ray.negativeAxes);
+}
+
+TEST_F(SlabTestTest, RandomRay) {
+	auto random = std::mt19937{ 11 };
+	auto coord = std::uniform_real_distribution<Float32>{ -5.0f, 5.0f };
+	auto extent = std::uniform_real_distribution<Float32>{ 0.0f, 3.0f };
+	auto boxes = std::vector<Box>(103);
+	for (auto i = 0u; i < boxes.size(); ++i) {
+		auto & box = boxes[i];
+		for (auto axis = 0u; axis < 3; ++axis) {
+			box.minVertex[axis] = coord(random);
+			// every 8th box is flat on one axis
+			box.maxVertex[axis] = box.minVertex[axis] + (i % 8 == 0 && i / 8 % 3 == axis ? 0.0f : extent(random));
+		}
+		box.minVertex[3] = 0.0f;
+		box.maxVertex[3] = 0.0f;
+	}
+	auto hitCount = 0u;
+	auto flatHitCount = 0u;
+	for (auto i = 0u; i < 500; ++i) {
+		auto origin = Point4f{ 2 * coord(random), 2 * coord(random), 2 * coord(random), 1.0f };
+		auto target = Point4f{ coord(random), coord(random), coord(random), 1.0f };
+		auto direction = Normalize(static_cast<Vector4f>(target - origin));
+		auto ray = Ray{ origin, direction, 2 * extent(random) + 5.0f };
+		hitCount += CheckRay(ray, boxes);
+		for (auto j = 0u; j < boxes.size(); j += 8) {
+			flatHitCount += IntersectReference(ray, boxes[j]) >= 0 ? 1 : 0;
+		}
+	}
+	EXPECT_GT(hitCount, 300u);
+	EXPECT_GT(flatHitCount, 10u);
+}
+
+TEST_F(SlabTestTest, AxisParallelRay) {
+	// unit boxes on a grid, rays start half way between faces so that none of them grazes a face
+	auto boxes = std::vector<Box>{};
+	for (auto x = -2; x <= 2; x += 2) {
+		for (auto y = -2; y <= 2; y += 2) {
+			for (auto z = -2; z <= 2; z += 2) {
+				auto minX = static_cast<Float32>(x);
+				auto minY = static_cast<Float32>(y);
+				auto minZ = static_cast<Float32>(z);
+				boxes.push_back(Box{ { minX, minY, minZ, 0.0f }, { minX + 1, minY + 1, minZ + 1, 0.0f } });
+			}
+		}
+	}
+	auto const zeros = std::array<Float32, 2>{ 0.0f, -0.0f };
+	auto hitCount = 0u;
+	for (auto axis = 0u; axis < 3; ++axis) {
+		for (auto sign : { 1.0f, -1.0f }) {
+			for (auto zero : zeros) {
+				auto direction = Vector4f{ zero, zero, zero, 0.0f };
+				direction(axis) = sign;
+				for (auto a = -3.75f; a <= 3.75f; a += 0.5f) {
+					for (auto b = -3.25f; b <= 3.75f; b += 1.0f) {
+						for (auto c = -3.75f; c <= 3.75f; c += 1.0f) {
+							auto origin = Point4f{ a, b, c, 1.0f };
+							// 5 units is too short to cross the whole grid from some of the origins
+							hitCount += CheckRay(Ray{ origin, direction, 5.0f }, boxes);
+						}
+					}
+				}
+			}
+		}
+	}
+	EXPECT_GT(hitCount, 1000u);
+}
+
+TEST_F(SlabTestTest, ZeroExtentBox) {
+	auto flat = Box{ { -1.0f, -1.0f, 2.0f, 0.0f }, { 1.0f, 1.0f, 2.0f, 0.0f } };
+	auto point = Box{ { 0.5f, 0.5f, 0.5f, 0.0f }, { 0.5f, 0.5f, 0.5f, 0.0f } };
+	// crossing the flat box along and against its axis, with either zero sign on the others
+	for (auto zero : { 0.0f, -0.0f }) {
+		auto ray = Ray{ Point4f{ 0.5f, -0.5f, 0.0f, 1.0f }, Vector4f{ zero, zero, 1.0f, 0.0f }, 10.0f };
+		EXPECT_EQ(2.0f, IntersectSlab(SlabRay{ ray }, flat.minVertex.data(), flat.maxVertex.data()));
+		ray.origin = Point4f{ 0.5f, -0.5f, 5.0f, 1.0f };
+		ray.direction = Vector4f{ zero, zero, -1.0f, 0.0f };
+		EXPECT_EQ(3.0f, IntersectSlab(SlabRay{ ray }, flat.minVertex.data(), flat.maxVertex.data()));
+		// beside it
+		ray.origin = Point4f{ 1.5f, -0.5f, 5.0f, 1.0f };
+		EXPECT_EQ(-1.0f, IntersectSlab(SlabRay{ ray }, flat.minVertex.data(), flat.maxVertex.data()));
+		// too short
+		ray.origin = Point4f{ 0.5f, -0.5f, 5.0f, 1.0f };
+		ray.length = 3.0f;
+		EXPECT_EQ(-1.0f, IntersectSlab(SlabRay{ ray }, flat.minVertex.data(), flat.maxVertex.data()));
+	}
+	// diagonal rays, the first one through the point, the second one through the flat box
+	auto hitCount = 0u;
+	hitCount += CheckRay(Ray{ Point4f{ -1.5f, -1.5f, -1.5f, 1.0f }, Normalize(Vector4f{ 1.0f, 1.0f, 1.0f, 0.0f }), 10.0f }, { flat, point });
+	hitCount += CheckRay(Ray{ Point4f{ -1.0f, -1.0f, 0.0f, 1.0f }, Normalize(Vector4f{ 1.0f, 1.0f, 2.0f, 0.0f }), 10.0f }, { flat, point });
+	EXPECT_EQ(2u, hitCount);
+}
+
+TEST_F(SlabTestTest, PaddedLane) {
+	auto boxes = std::vector<Box>{
+		Box{ { 1.0f, -1.0f, -1.0f, 0.0f }, { 2.0f, 1.0f, 1.0f, 0.0f } },
+		Box{ { 3.0f, -1.0f, -1.0f, 0.0f }, { 4.0f, 1.0f, 1.0f, 0.0f } },
+		Box{ { 5.0f, 2.0f, -1.0f, 0.0f }, { 6.0f, 3.0f, 1.0f, 0.0f } },
+	};
+	// the padding boxes are points at the origin, lanes past count are ignored
+	auto ray = SlabRay{ Ray{ Point4f{ -1.0f, 0.0f, 0.0f, 1.0f }, Vector4f{ 1.0f, 0.0f, 0.0f, 0.0f }, 10.0f } };
+	for (auto count = 1u; count <= boxes.size(); ++count) {
+		Float32 t[4];
+		auto mask = IntersectBoxes(ray, std::vector<Box>(boxes.begin(), boxes.begin() + count), t);
+		auto validMask = (1 << count) - 1;
+		EXPECT_EQ(0b011 & validMask, mask & validMask);
+		EXPECT_EQ(2.0f, t[0]);
+		if (count > 1) {
+			EXPECT_EQ(4.0f, t[1]);
+		}
+	}
+	// but a ray through the origin does hit the padding, so callers have to mask it out
+	auto diagonal = SlabRay{ Ray{ Point4f{ -1.0f, -1.0f, -1.0f, 1.0f }, Normalize(Vector4f{ 1.0f, 1.0f, 1.0f, 0.0f }), 10.0f } };
+	auto center = Box{ { -0.5f, -0.5f, -0.5f, 0.0f }, { 0.5f, 0.5f, 0.5f, 0.0f } };
+	Float32 t[4];
+	EXPECT_EQ(0b1111, IntersectBoxes(diagonal, { center }, t));
+	// shrinking the ray to the closest hit prunes farther boxes
+	ray.length = 3.0f;
+	EXPECT_EQ(0b0001, IntersectBoxes(ray, boxes, t) & 0b0111);
+	auto offAxis = SlabRay{ Ray{ Point4f{ -1.0f, 0.5f, 0.5f, 1.0f }, Vector4f{ 1.0f, 0.0f, 0.0f, 0.0f }, 10.0f } };
+	EXPECT_EQ(0b0011, IntersectBoxes(offAxis, boxes, t));
+}
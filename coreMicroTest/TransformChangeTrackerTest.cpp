@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "core/TransformChangeTracker.h"
+
+using namespace core;
+
+class TransformChangeTrackerTest : public ::testing::Test {
+public:
+	TransformChangeTrackerTest()
+		: _movables(8) {
+		for (auto & movable : _movables) {
+			_pointers.push_back(&movable);
+		}
+	}
+	auto Collect() -> std::vector<TransformChangeTracker::Range> const& {
+		return _tracker.CollectChanges(_pointers.data(), _pointers.size());
+	}
+	static auto ExpectRanges(std::vector<TransformChangeTracker::Range> const& expected, std::vector<TransformChangeTracker::Range> const& actual) -> void {
+		ASSERT_EQ(expected.size(), actual.size());
+		for (auto i = 0u; i < expected.size(); ++i) {
+			EXPECT_EQ(expected[i].first, actual[i].first) << "range " << i;
+			EXPECT_EQ(expected[i].count, actual[i].count) << "range " << i;
+		}
+	}
+protected:
+	std::vector<Movable> _movables;
+	std::vector<Movable *> _pointers;
+	TransformChangeTracker _tracker;
+};
+
+TEST_F(TransformChangeTrackerTest, Emits_only_changed_movables) {
+	ExpectRanges({ { 0, 8 } }, Collect());
+	ExpectRanges({}, Collect());
+
+	_movables[3].Translate(1, 0, 0);
+	_movables[4].Rotate(0, 0, 1, 0.5f);
+	_movables[7].Scale(2, 2, 2);
+	ExpectRanges({ { 3, 2 }, { 7, 1 } }, Collect());
+	ExpectRanges({}, Collect());
+
+	// children move with their parent
+	_movables[1].AttachTo(_movables[5]);
+	_movables[6].AttachTo(_movables[1]);
+	ExpectRanges({ { 1, 1 }, { 6, 1 } }, Collect());
+	_movables[5].Translate(0, 1, 0);
+	ExpectRanges({ { 1, 1 }, { 5, 2 } }, Collect());
+
+	// everything is emitted again when the movables change
+	_pointers.pop_back();
+	ExpectRanges({ { 0, 7 } }, Collect());
+}
@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "core/TransformSystem.h"
+#include "core/Movable.h"
+
+using namespace core;
+
+class TransformSystemTest : public ::testing::Test {
+public:
+	// node i is attached to a random node among the previous ones, so depths are mixed in creation order
+	auto BuildHierarchy(unsigned int count, std::vector<Movable> & movables, std::vector<unsigned int> & parents) -> void {
+		auto angle = std::uniform_real_distribution<Float32>{ -3.0f, 3.0f };
+		auto position = std::uniform_real_distribution<Float32>{ -10.0f, 10.0f };
+		movables.resize(count);
+		parents.resize(count);
+		for (auto i = 0u; i < count; ++i) {
+			parents[i] = i < 16 ? TransformSystem::NoParent : std::uniform_int_distribution<unsigned int>{ i / 8, i - 1 }(_random);
+			movables[i].Scale(1.0f, 1.0f + i % 3, 1.0f);
+			movables[i].Rotate(position(_random), position(_random), position(_random), angle(_random));
+			movables[i].Translate(position(_random), position(_random), position(_random));
+			if (parents[i] != TransformSystem::NoParent) {
+				movables[i].AttachTo(movables[parents[i]]);
+			}
+		}
+	}
+	static auto ExpectSame(Matrix4x4f const& expected, Matrix4x4f const& actual) -> void {
+		for (auto i = 0u; i < 16; ++i) {
+			ASSERT_EQ(expected(i), actual(i));
+		}
+	}
+protected:
+	std::mt19937 _random;
+};
+
+TEST_F(TransformSystemTest, Same_world_transforms_as_scene_nodes) {
+	auto movables = std::vector<Movable>{};
+	auto parents = std::vector<unsigned int>{};
+	BuildHierarchy(10000, movables, parents);
+	// the system has to sort the nodes by depth
+	auto system = TransformSystem{ 4u };
+	auto handles = std::vector<TransformSystem::Handle>(movables.size());
+	for (auto i = 0u; i < movables.size(); ++i) {
+		auto parent = parents[i] == TransformSystem::NoParent ? TransformSystem::NoParent : handles[parents[i]];
+		handles[i] = system.Create(movables[i].GetLocalTransform(), parent);
+	}
+	system.Update();
+	for (auto i = 0u; i < movables.size(); ++i) {
+		ExpectSame(movables[i].GetTransform(), system.GetWorld(handles[i]));
+	}
+
+	for (auto i = 0u; i < movables.size(); i += 97) {
+		movables[i].Translate(1, 2, 3);
+		system.SetLocal(handles[i], movables[i].GetLocalTransform());
+	}
+	system.Update();
+	for (auto i = 0u; i < movables.size(); ++i) {
+		ExpectSame(movables[i].GetTransform(), system.GetWorld(handles[i]));
+	}
+}
+
+// timing only, run with --gtest_also_run_disabled_tests
+TEST_F(TransformSystemTest, DISABLED_Benchmark_against_scene_nodes) {
+	using Clock = std::chrono::high_resolution_clock;
+	auto const nodeCount = 100000u;
+	auto const frameCount = 10u;
+	auto movables = std::vector<Movable>{};
+	auto parents = std::vector<unsigned int>{};
+	BuildHierarchy(nodeCount, movables, parents);
+	auto single = TransformSystem{ 1u };
+	auto multiple = TransformSystem{ std::max(std::thread::hardware_concurrency(), 1u) };
+	for (auto * system : { &single, &multiple }) {
+		for (auto i = 0u; i < nodeCount; ++i) {
+			system->Create(movables[i].GetLocalTransform(), parents[i]);
+		}
+		system->Update();
+	}
+
+	// every frame a few nodes move and the world transforms of all are read
+	auto checksum = 0.0f;
+	auto start = Clock::now();
+	for (auto frame = 0u; frame < frameCount; ++frame) {
+		for (auto i = frame; i < nodeCount; i += 101) {
+			movables[i].Translate(0, 0, 1);
+		}
+		for (auto const& movable : movables) {
+			checksum += movable.GetTransform()(0, 3);
+		}
+	}
+	auto sceneNodeTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	double systemTimes[2];
+	for (auto s = 0u; s < 2; ++s) {
+		auto & system = s == 0 ? single : multiple;
+		auto systemChecksum = 0.0f;
+		start = Clock::now();
+		for (auto frame = 0u; frame < frameCount; ++frame) {
+			for (auto i = frame; i < nodeCount; i += 101) {
+				system.SetLocal(i, movables[i].GetLocalTransform());
+			}
+			system.Update();
+			for (auto i = 0u; i < nodeCount; ++i) {
+				systemChecksum += system.GetWorld(i)(0, 3);
+			}
+		}
+		systemTimes[s] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		ASSERT_EQ(checksum, systemChecksum);
+	}
+	std::cout << nodeCount << " nodes, " << frameCount << " frames: scene nodes " << sceneNodeTime << " ms, transform system "
+		<< systemTimes[0] << " ms with 1 thread, " << systemTimes[1] << " ms with " << std::thread::hardware_concurrency() << " threads" << std::endl;
+}
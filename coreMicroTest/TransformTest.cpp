@@ -0,0 +1,135 @@
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <random>
+
+#include "core/Transform.h"
+
+using namespace core;
+
+class TransformTest : public ::testing::Test {
+public:
+	// the matrix SceneNode composed rotations with before they were quaternions
+	static auto RotationMatrix(Float32 x, Float32 y, Float32 z, Float32 r) -> Matrix4x4f {
+		auto a = std::cos(r);
+		auto b = std::sin(r);
+		auto c = 1 - a;
+		return Matrix4x4f{
+			a + c*x*x,		c*x*y - b*z,	c*x*z + b*y,	0,
+			c*x*y + b*z,	a + c*y*y,		c*y*z - b*x,	0,
+			c*x*z - b*y,	c*y*z + b*x,	a + c*z*z,		0,
+			0,				0,				0,				1
+		};
+	}
+	static auto TranslationMatrix(Float32 x, Float32 y, Float32 z) -> Matrix4x4f {
+		return Matrix4x4f{
+			1, 0, 0, x,
+			0, 1, 0, y,
+			0, 0, 1, z,
+			0, 0, 0, 1,
+		};
+	}
+	static auto ScaleMatrix(Float32 x, Float32 y, Float32 z) -> Matrix4x4f {
+		return Matrix4x4f{
+			x, 0, 0, 0,
+			0, y, 0, 0,
+			0, 0, z, 0,
+			0, 0, 0, 1,
+		};
+	}
+	static auto ExpectNear(Matrix4x4f const& expected, Matrix4x4f const& actual) -> void {
+		for (auto i = 0u; i < 16; ++i) {
+			EXPECT_NEAR(expected(i), actual(i), 1e-4f) << "element " << i;
+		}
+	}
+	auto RandomAxis() -> Vector3f {
+		auto value = std::uniform_real_distribution<Float32>{ -1.0f, 1.0f };
+		auto axis = Normalize(Vector3f{ value(_random), value(_random), value(_random) });
+		return axis;
+	}
+protected:
+	std::mt19937 _random;
+};
+
+TEST_F(TransformTest, Operations_match_matrix_products) {
+	auto angle = std::uniform_real_distribution<Float32>{ -3.0f, 3.0f };
+	auto value = std::uniform_real_distribution<Float32>{ -10.0f, 10.0f };
+	auto transform = Transform{};
+	auto matrix = Matrix4x4f{};
+	transform.Scale(2.0f, 0.5f, 3.0f);
+	matrix = ScaleMatrix(2.0f, 0.5f, 3.0f) * matrix;
+	for (auto i = 0; i < 50; ++i) {
+		auto axis = RandomAxis();
+		auto r = angle(_random);
+		auto rotation = Quaternion::FromAxisAngle(axis(0), axis(1), axis(2), r);
+		auto x = value(_random);
+		auto y = value(_random);
+		auto z = value(_random);
+		switch (i % 4) {
+		case 0:
+			transform.Rotate(rotation);
+			matrix = RotationMatrix(axis(0), axis(1), axis(2), r) * matrix;
+			break;
+		case 1:
+			transform.RotateSelf(rotation);
+			// exact only if the scale is uniform, rotate before scaling
+			matrix = matrix * ScaleMatrix(0.5f, 2.0f, 1.0f / 3) * RotationMatrix(axis(0), axis(1), axis(2), r) * ScaleMatrix(2.0f, 0.5f, 3.0f);
+			break;
+		case 2:
+			transform.Translate(x, y, z);
+			matrix = TranslationMatrix(x, y, z) * matrix;
+			break;
+		case 3:
+			transform.MoveAlong(Vector3f{ x, y, z });
+			matrix = matrix * TranslationMatrix(x, y, z);
+			break;
+		}
+		ExpectNear(matrix, transform.ToMatrix());
+	}
+}
+
+TEST_F(TransformTest, Inverse_and_normal_matrix) {
+	auto axis = RandomAxis();
+	auto transform = Transform{ Vector3f{ 3, -4, 5 }, Quaternion::FromAxisAngle(axis(0), axis(1), axis(2), 1.2f), Vector3f{ 2.0f, 0.25f, 4.0f } };
+	auto matrix = transform.ToMatrix();
+	ExpectNear(Matrix4x4f{}, transform.ToInverseMatrix() * matrix);
+
+	// normals stay perpendicular to transformed tangents
+	auto normal = transform.ToNormalMatrix();
+	for (auto i = 0u; i < 3; ++i) {
+		for (auto j = 0u; j < 3; ++j) {
+			auto dot = 0.0f;
+			for (auto k = 0u; k < 3; ++k) {
+				dot += normal(k, i) * matrix(k, j);
+			}
+			EXPECT_NEAR(i == j ? 1.0f : 0.0f, dot, 1e-4f);
+		}
+	}
+
+	// uniform scale composes and inverts exactly
+	auto uniform = Transform{ Vector3f{ 1, 2, 3 }, Quaternion::FromAxisAngle(1, 1, 0, 0.7f), Vector3f{ 1.5f, 1.5f, 1.5f } };
+	ExpectNear(Matrix4x4f{}, (uniform * uniform.Inverse()).ToMatrix());
+	ExpectNear(uniform.ToMatrix() * transform.ToMatrix(), (uniform * transform).ToMatrix());
+	auto point = uniform.TransformPoint(Vector3f{ 1, -1, 2 });
+	auto expected = uniform.ToMatrix() * Point4f{ 1, -1, 2, 1 };
+	for (auto i = 0u; i < 3; ++i) {
+		EXPECT_NEAR(expected(i), point(i), 1e-4f);
+	}
+}
+
+TEST_F(TransformTest, From_matrix) {
+	auto axis = RandomAxis();
+	auto transform = Transform{ Vector3f{ 3, -4, 5 }, Quaternion::FromAxisAngle(axis(0), axis(1), axis(2), 2.5f), Vector3f{ 2.0f, 0.25f, -4.0f } };
+	ExpectNear(transform.ToMatrix(), Transform::FromMatrix(transform.ToMatrix()).ToMatrix());
+	EXPECT_TRUE(Transform::IsDecomposable(transform.ToMatrix()));
+	for (auto angle : { 0.0f, 1.0f, 3.1f, -3.1f }) {
+		for (auto i = 0u; i < 3; ++i) {
+			auto rotation = Transform{ Vector3f{ 0, 0, 0 }, Quaternion::FromAxisAngle(i == 0, i == 1, i == 2, angle), Vector3f{ 1, 1, 1 } };
+			ExpectNear(rotation.ToMatrix(), Transform::FromMatrix(rotation.ToMatrix()).ToMatrix());
+		}
+	}
+
+	// a non-uniform scale after a rotation shears
+	auto sheared = ScaleMatrix(1.0f, 3.0f, 1.0f) * RotationMatrix(0, 0, 1, 0.5f);
+	EXPECT_FALSE(Transform::IsDecomposable(sheared));
+}
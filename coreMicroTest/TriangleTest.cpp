@@ -0,0 +1,200 @@
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "core/Triangle.h"
+
+using namespace core;
+
+class TriangleTest : public ::testing::Test {
+public:
+	using Triangles = std::array<std::array<Point4f, 3>, TriangleBlock::Size>;
+public:
+	static auto MakeBlock(Triangles const& triangles) -> TriangleBlock {
+		auto ret = TriangleBlock{};
+		for (auto lane = 0u; lane < TriangleBlock::Size; ++lane) {
+			auto const& triangle = triangles[lane];
+			for (auto axis = 0u; axis < 3; ++axis) {
+				ret.p0[axis][lane] = triangle[0](axis);
+				ret.e1[axis][lane] = triangle[1](axis) - triangle[0](axis);
+				ret.e2[axis][lane] = triangle[2](axis) - triangle[0](axis);
+			}
+		}
+		return ret;
+	}
+	// nearest scalar hit within (0, length] among the first count triangles, -1 if missed
+	static auto IntersectScalar(Ray const& ray, Triangles const& triangles, unsigned int count, unsigned int & lane, Float32 & u, Float32 & v) -> Float32 {
+		auto ret = -1.0f;
+		for (auto i = 0u; i < count; ++i) {
+			auto triangleU = 0.0f;
+			auto triangleV = 0.0f;
+			auto distance = Triangle::IntersectRay(ray, triangles[i], triangleU, triangleV);
+			if (distance > 0 && distance <= ray.length && (ret < 0 || distance < ret)) {
+				ret = distance;
+				lane = i;
+				u = triangleU;
+				v = triangleV;
+			}
+		}
+		return ret;
+	}
+	// triangle (0, 0, z) (1, 0, z) (0, 1, z), any ray along z hits it at u = x and v = y
+	static auto MakeUnitTriangle(Float32 z) -> std::array<Point4f, 3> {
+		return std::array<Point4f, 3>{
+			Point4f{ 0.0f, 0.0f, z, 1.0f },
+			Point4f{ 1.0f, 0.0f, z, 1.0f },
+			Point4f{ 0.0f, 1.0f, z, 1.0f },
+		};
+	}
+};
+
+TEST_F(TriangleTest, RandomBlock) {
+	auto random = std::mt19937{ 7 };
+	auto coord = std::uniform_real_distribution<Float32>{ -1.0f, 1.0f };
+	auto hitCount = 0u;
+	for (auto i = 0u; i < 2000; ++i) {
+		auto triangles = Triangles{};
+		for (auto & triangle : triangles) {
+			for (auto & vertex : triangle) {
+				vertex = Point4f{ coord(random), coord(random), coord(random), 1.0f };
+			}
+		}
+		auto block = MakeBlock(triangles);
+		auto origin = Point4f{ 3 * coord(random), 3 * coord(random), 3 * coord(random), 1.0f };
+		auto target = Point4f{ coord(random), coord(random), coord(random), 1.0f };
+		auto direction = Normalize(static_cast<Vector4f>(target - origin));
+		// every other ray is too short to reach some of the triangles
+		auto length = i % 2 == 0 ? 10.0f : 3.0f;
+		auto ray = Ray{ origin, direction, length };
+		auto rayLanes = RayLanes{ ray };
+		for (auto count = 1u; count <= TriangleBlock::Size; ++count) {
+			auto expectedLane = 0u;
+			auto expectedU = 0.0f;
+			auto expectedV = 0.0f;
+			auto expected = IntersectScalar(ray, triangles, count, expectedLane, expectedU, expectedV);
+			auto lane = 0u;
+			auto u = 0.0f;
+			auto v = 0.0f;
+			auto actual = Triangle::IntersectRay4(rayLanes, length, block, count, lane, u, v);
+			ASSERT_EQ(expected > 0, actual > 0) << "ray " << i << " count " << count;
+			if (expected > 0) {
+				++hitCount;
+				EXPECT_EQ(expectedLane, lane);
+				EXPECT_NEAR(expected, actual, 1e-4f);
+				EXPECT_NEAR(expectedU, u, 1e-4f);
+				EXPECT_NEAR(expectedV, v, 1e-4f);
+			} else {
+				EXPECT_EQ(-1.0f, actual);
+			}
+		}
+	}
+	// make sure both hits and misses were tested
+	EXPECT_GT(hitCount, 1000u);
+	EXPECT_LT(hitCount, 7000u);
+}
+
+TEST_F(TriangleTest, CountMasksLanes) {
+	// lane 3 is the nearest, lane 0 the farthest: every count hits its last lane
+	auto triangles = Triangles{ MakeUnitTriangle(4.0f), MakeUnitTriangle(3.0f), MakeUnitTriangle(2.0f), MakeUnitTriangle(1.0f) };
+	auto block = MakeBlock(triangles);
+	auto ray = Ray{ Point4f{ 0.25f, 0.5f, 0.0f, 1.0f }, Vector4f{ 0.0f, 0.0f, 1.0f, 0.0f }, 10.0f };
+	auto rayLanes = RayLanes{ ray };
+	for (auto count = 1u; count <= TriangleBlock::Size; ++count) {
+		auto lane = TriangleBlock::Size;
+		auto u = 0.0f;
+		auto v = 0.0f;
+		auto distance = Triangle::IntersectRay4(rayLanes, ray.length, block, count, lane, u, v);
+		EXPECT_EQ(count - 1, lane);
+		EXPECT_FLOAT_EQ(5.0f - count, distance);
+		EXPECT_FLOAT_EQ(0.25f, u);
+		EXPECT_FLOAT_EQ(0.5f, v);
+	}
+	// a masked lane is never hit, even if it would be nearer
+	auto lane = TriangleBlock::Size;
+	auto u = 0.0f;
+	auto v = 0.0f;
+	EXPECT_EQ(-1.0f, Triangle::IntersectRay4(rayLanes, 3.5f, block, 1u, lane, u, v));
+	EXPECT_EQ(TriangleBlock::Size, lane);
+	// padding duplicates the last triangle, as MeshBvh does
+	triangles = Triangles{ MakeUnitTriangle(2.0f), MakeUnitTriangle(1.0f), MakeUnitTriangle(1.0f), MakeUnitTriangle(1.0f) };
+	block = MakeBlock(triangles);
+	EXPECT_FLOAT_EQ(1.0f, Triangle::IntersectRay4(rayLanes, ray.length, block, 2u, lane, u, v));
+	EXPECT_EQ(1u, lane);
+}
+
+TEST_F(TriangleTest, ParallelRay) {
+	auto triangles = Triangles{ MakeUnitTriangle(0.0f), MakeUnitTriangle(0.0f), MakeUnitTriangle(0.0f), MakeUnitTriangle(0.0f) };
+	auto block = MakeBlock(triangles);
+	auto lane = 0u;
+	auto u = 0.0f;
+	auto v = 0.0f;
+	// in the plane of the triangle, crossing it
+	auto ray = Ray{ Point4f{ -1.0f, 0.25f, 0.0f, 1.0f }, Vector4f{ 1.0f, 0.0f, 0.0f, 0.0f }, 10.0f };
+	EXPECT_EQ(-1.0f, Triangle::IntersectRay(ray, triangles[0], u, v));
+	EXPECT_EQ(-1.0f, Triangle::IntersectRay4(RayLanes{ ray }, ray.length, block, TriangleBlock::Size, lane, u, v));
+	// determinant below the smallest normalized float, cut off by both kernels
+	auto tiny = std::numeric_limits<Float32>::min() / 4;
+	ray = Ray{ Point4f{ 0.25f, 0.25f, -tiny, 1.0f }, Vector4f{ 0.0f, 1.0f, tiny, 0.0f }, std::numeric_limits<Float32>::max() };
+	EXPECT_EQ(-1.0f, Triangle::IntersectRay(ray, triangles[0], u, v));
+	EXPECT_EQ(-1.0f, Triangle::IntersectRay4(RayLanes{ ray }, ray.length, block, TriangleBlock::Size, lane, u, v));
+	// determinant at the smallest normalized float is still a hit
+	ray.origin = Point4f{ 0.25f, 0.25f, -std::numeric_limits<Float32>::min(), 1.0f };
+	ray.direction = Vector4f{ 0.0f, 0.0f, std::numeric_limits<Float32>::min(), 0.0f };
+	EXPECT_FLOAT_EQ(1.0f, Triangle::IntersectRay(ray, triangles[0], u, v));
+	EXPECT_FLOAT_EQ(1.0f, Triangle::IntersectRay4(RayLanes{ ray }, ray.length, block, TriangleBlock::Size, lane, u, v));
+}
+
+TEST_F(TriangleTest, EdgeAndLength) {
+	auto triangles = Triangles{ MakeUnitTriangle(1.0f), MakeUnitTriangle(1.0f), MakeUnitTriangle(1.0f), MakeUnitTriangle(1.0f) };
+	auto block = MakeBlock(triangles);
+	auto direction = Vector4f{ 0.0f, 0.0f, 1.0f, 0.0f };
+	// vertexes and edges are inclusive
+	auto const onBoundary = std::array<std::array<Float32, 2>, 6>{ {
+		{ 0.0f, 0.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f },
+		{ 0.5f, 0.0f }, { 0.0f, 0.5f }, { 0.5f, 0.5f },
+	} };
+	for (auto const& point : onBoundary) {
+		auto ray = Ray{ Point4f{ point[0], point[1], 0.0f, 1.0f }, direction, 1.0f };
+		auto lane = TriangleBlock::Size;
+		auto u = -1.0f;
+		auto v = -1.0f;
+		auto scalarU = -1.0f;
+		auto scalarV = -1.0f;
+		EXPECT_EQ(1.0f, Triangle::IntersectRay(ray, triangles[0], scalarU, scalarV));
+		EXPECT_EQ(1.0f, Triangle::IntersectRay4(RayLanes{ ray }, ray.length, block, 1u, lane, u, v));
+		EXPECT_EQ(0u, lane);
+		EXPECT_EQ(point[0], u);
+		EXPECT_EQ(point[1], v);
+		EXPECT_EQ(scalarU, u);
+		EXPECT_EQ(scalarV, v);
+	}
+	// just outside of every edge
+	auto const offset = 1e-3f;
+	auto const outside = std::array<std::array<Float32, 2>, 3>{ {
+		{ 0.5f, -offset }, { -offset, 0.5f }, { 0.5f + offset, 0.5f + offset },
+	} };
+	for (auto const& point : outside) {
+		auto ray = Ray{ Point4f{ point[0], point[1], 0.0f, 1.0f }, direction, 1.0f };
+		auto lane = 0u;
+		auto u = 0.0f;
+		auto v = 0.0f;
+		EXPECT_EQ(-1.0f, Triangle::IntersectRay(ray, triangles[0], u, v));
+		EXPECT_EQ(-1.0f, Triangle::IntersectRay4(RayLanes{ ray }, ray.length, block, 1u, lane, u, v));
+	}
+	// hit exactly at length counts, just beyond it or behind the origin does not
+	auto ray = Ray{ Point4f{ 0.25f, 0.25f, 0.0f, 1.0f }, direction, 1.0f };
+	auto lane = 0u;
+	auto u = 0.0f;
+	auto v = 0.0f;
+	auto rayLanes = RayLanes{ ray };
+	EXPECT_EQ(1.0f, Triangle::IntersectRay4(rayLanes, 1.0f, block, 1u, lane, u, v));
+	EXPECT_EQ(-1.0f, Triangle::IntersectRay4(rayLanes, std::nextafter(1.0f, 0.0f), block, 1u, lane, u, v));
+	ray.origin = Point4f{ 0.25f, 0.25f, 2.0f, 1.0f };
+	EXPECT_EQ(-1.0f, Triangle::IntersectRay4(RayLanes{ ray }, 10.0f, block, 1u, lane, u, v));
+	// origin on the triangle, distance 0 is not a hit
+	ray.origin = Point4f{ 0.25f, 0.25f, 1.0f, 1.0f };
+	EXPECT_EQ(-1.0f, Triangle::IntersectRay4(RayLanes{ ray }, 10.0f, block, 1u, lane, u, v));
+}
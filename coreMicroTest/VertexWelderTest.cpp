@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "core/VertexWelder.h"
+
+using namespace core;
+
+class VertexWelderTest : public ::testing::Test {
+public:
+	VertexWelderTest() {
+		// a unit quad, coordinate 4 duplicates 2 up to a small error, coordinate 5 is on the line from 0 to 1
+		_coords = {
+			Vector3f{ 0, 0, 0 }, Vector3f{ 1, 0, 0 }, Vector3f{ 1, 1, 0 }, Vector3f{ 0, 1, 0 },
+			Vector3f{ 1.0f + 1e-5f, 1, 0 }, Vector3f{ 0.5f, 0, 0 },
+		};
+		_normals = std::vector<Vector3f>(_coords.size(), Vector3f{ 0, 0, 1 });
+		_texCoords = { Vector2f{ 0, 0 }, Vector2f{ 1, 0 }, Vector2f{ 1, 1 }, Vector2f{ 0, 1 } };
+	}
+	static auto C(unsigned int coord, unsigned int texCoord) -> VertexWelder::Corner {
+		return VertexWelder::Corner{ coord, coord, texCoord };
+	}
+protected:
+	std::vector<Vector3f> _coords;
+	std::vector<Vector3f> _normals;
+	std::vector<Vector2f> _texCoords;
+};
+
+TEST_F(VertexWelderTest, Shares_vertices_of_equal_corners) {
+	auto welder = VertexWelder{ &_coords, &_normals, &_texCoords };
+	EXPECT_TRUE(welder.AddTriangle(C(0, 0), C(1, 1), C(2, 2)));
+	EXPECT_TRUE(welder.AddTriangle(C(0, 0), C(2, 2), C(3, 3)));
+	// same position, different texture coordinate
+	EXPECT_TRUE(welder.AddTriangle(C(0, 1), C(1, 1), C(3, 3)));
+	EXPECT_EQ(5u, welder.GetVertices().size());
+	EXPECT_EQ((std::vector<unsigned int>{ 0, 1, 2, 0, 2, 3, 4, 1, 3 }), welder.GetIndexes());
+	for (auto i = 0u; i < 3; ++i) {
+		EXPECT_EQ(_coords[2](i), welder.GetVertices()[2].coord(i));
+	}
+	EXPECT_EQ(1.0f, welder.GetVertices()[4].texCoord(0));
+}
+
+TEST_F(VertexWelderTest, Drops_degenerate_triangles) {
+	auto welder = VertexWelder{ &_coords, &_normals, &_texCoords };
+	EXPECT_FALSE(welder.AddTriangle(C(0, 0), C(1, 1), C(0, 0)));
+	EXPECT_FALSE(welder.AddTriangle(C(0, 0), C(5, 0), C(1, 1)));
+	EXPECT_TRUE(welder.AddTriangle(C(0, 0), C(1, 1), C(2, 2)));
+	EXPECT_EQ(3u, welder.GetIndexes().size());
+
+	// without welding coordinates 2 and 4 are distinct vertices
+	EXPECT_TRUE(welder.AddTriangle(C(2, 2), C(4, 2), C(0, 0)));
+	auto epsilonWelder = VertexWelder{ &_coords, &_normals, &_texCoords, 1e-4f };
+	EXPECT_TRUE(epsilonWelder.AddTriangle(C(0, 0), C(1, 1), C(2, 2)));
+	EXPECT_FALSE(epsilonWelder.AddTriangle(C(2, 2), C(4, 2), C(0, 0)));
+	EXPECT_TRUE(epsilonWelder.AddTriangle(C(0, 0), C(4, 2), C(3, 3)));
+	EXPECT_EQ(4u, epsilonWelder.GetVertices().size());
+	EXPECT_EQ((std::vector<unsigned int>{ 0, 1, 2, 0, 2, 3 }), epsilonWelder.GetIndexes());
+
+	EXPECT_THROW(welder.AddTriangle(C(0, 0), C(1, 1), C(6, 2)), std::out_of_range);
+}
+
+TEST_F(VertexWelderTest, Welds_far_from_the_origin) {
+	// cells of these coordinates are far out of int32 range
+	_coords = { Vector3f{ 1e30f, 0, 0 }, Vector3f{ 1e30f, 1e25f, 0 }, Vector3f{ 1e30f, 0, 1e25f }, Vector3f{ 1e30f, 1e25f, 0 } };
+	_normals.resize(_coords.size());
+	auto welder = VertexWelder{ &_coords, &_normals, &_texCoords, 1e-6f };
+	EXPECT_TRUE(welder.AddTriangle(C(0, 0), C(1, 1), C(2, 2)));
+	EXPECT_TRUE(welder.AddTriangle(C(0, 0), C(3, 1), C(2, 2)));
+	EXPECT_EQ(3u, welder.GetVertices().size());
+}
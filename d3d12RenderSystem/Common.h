@@ -11,6 +11,7 @@
 namespace d3d12RenderSystem {
 
 using core::uint8;
+using core::uint16;
 using core::uint32;
 using core::uint64;
 using core::int8;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <thread>
 
 #include <d3d12.h>
 #include <dxgi1_4.h>
@@ -15,6 +16,7 @@
 #include "SwapChainRenderTargets.h"
 
 #include "core/Shape.h"
+#include "core/OcclusionBuffer.h"
 
 namespace d3d12RenderSystem {
 
@@ -59,7 +61,8 @@ public:
         for (auto & texture : staticModelGroup._textures) {
             _textures.push_back(texture.get());
         }
-        _shadowCasterAabb = staticModelGroup.GetBvh()->GetRoot()->GetAabb();
+        _staticModelBvhs.push_back(staticModelGroup.GetBvh());
+        _shadowCasterAabb = GetStaticModelAabb();
     }
     auto RegisterSkyBox(core::SkyBox * skyBox) -> void {
         _skyBox = skyBox;
@@ -129,10 +132,21 @@ public:
             _renderer->CreateShadowMapBundle(_directionalLights.front(), _shapes.data(), _shapes.size());
         }
         _renderer->CreateTranslucentBundle(_translucentShapes.data(), _translucentShapes.size());
-        _renderer->CreateShapeBundle(_shapes.data(), _shapes.size());
         _resourceManager->LoadEnd();
     }
     auto Draw() -> void {
+        // opaque shapes intersecting the view frustum and not hidden by the largest of them, the list is rebuilt every frame
+        auto frustum = _camera->GetViewFrustum();
+        _visibleShapes.clear();
+        for (auto const* bvh : _staticModelBvhs) {
+            bvh->CullFrustum(frustum, _visibleShapes, nullptr, core::Bvh::ShapeFilter::Opaque);
+        }
+        _occlusionBuffer.Render(_camera->GetViewProjectTransform(), _camera->GetPosition(), _visibleShapes.data(), _visibleShapes.size());
+        _visibleShapes.clear();
+        for (auto const* bvh : _staticModelBvhs) {
+            bvh->CullFrustum(frustum, _visibleShapes, &_occlusionBuffer, core::Bvh::ShapeFilter::Opaque);
+        }
+
         _renderer->DrawBegin();
         if (!_directionalLights.empty()) {
             _renderer->DrawShadowMap();
@@ -141,8 +155,8 @@ public:
             _camera,
             _skyBox,
             _terrain,
-            _shapes.data(),
-            _shapes.size(),
+            _visibleShapes.data(),
+            _visibleShapes.size(),
             _directionalLights.front(),
             _ambientLights.front(),
             _directionalLights.data(), _directionalLights.size(),
@@ -155,8 +169,7 @@ public:
         _resourceManager->PrepareResource();
         _resourceManager->UpdateViewpoint(_camera);
 
-        // update movables
-        // todo: only update dynamic movables
+        // update movables, only the ones which moved are uploaded
         auto resource = _resourceManager->GetTransformDescriptorInfo(_movables.front()->GetRenderDataId())._resource;
         _resourceManager->LoadMovables(_movables.data(), _movables.size(), resource);
 
@@ -164,6 +177,8 @@ public:
             auto resource = _resourceManager->GetDirectionalLightDescriptorInfo(_directionalLights.front()->GetRenderDataId())._resource;
             _resourceManager->LoadDirectionalLight(_directionalLights.data(), _directionalLights.size(), resource);
 
+            // static models may have been moved and refitted since last frame
+            _shadowCasterAabb = GetStaticModelAabb();
             auto shadowCastingLight = _directionalLights.front();
             shadowCastingLight->ComputeShadowMappingVolume(_camera, _shadowCasterAabb);
             _resourceManager->UpdateViewpoint(shadowCastingLight);
@@ -173,6 +188,23 @@ public:
         }
     }
 private:
+    // union of the bounds of all static model groups
+    auto GetStaticModelAabb() const -> core::Aabb {
+        auto aabb = core::Aabb{};
+        auto empty = true;
+        for (auto const* bvh : _staticModelBvhs) {
+            if (bvh->GetNodes().empty()) {
+                continue; // expanding by an empty AABB would blow it up to infinity
+            }
+            if (empty) {
+                aabb = bvh->GetAabb();
+            } else {
+                aabb.Expand(bvh->GetAabb());
+            }
+            empty = false;
+        }
+        return aabb;
+    }
     auto EnableDebugLayer() -> void;
     auto static CreateFactory() -> ComPtr<IDXGIFactory1>;
     auto static CreateDevice(IDXGIFactory1 * factory) -> ComPtr<ID3D12Device>;
@@ -187,6 +219,8 @@ private:
 
     std::vector<core::Shape *> _shapes;
     std::vector<core::Shape *> _translucentShapes;
+    std::vector<core::Shape *> _visibleShapes;
+    core::OcclusionBuffer _occlusionBuffer{ std::thread::hardware_concurrency() };
     core::SkyBox * _skyBox;
     core::Terrain * _terrain;
     core::Camera * _camera;
@@ -201,6 +235,7 @@ private:
     std::vector<core::PointLight *> _pointLights;
     std::vector<core::SpotLight *> _spotLights;
     core::Aabb _shadowCasterAabb;
+    std::vector<core::Bvh const*> _staticModelBvhs; // one per registered static model group
 };
 
 }
\ No newline at end of file
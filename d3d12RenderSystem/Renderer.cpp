@@ -108,7 +108,7 @@ auto Renderer::Draw(
     if (terrain != nullptr) {
         DrawTerrain(commandList, terrain);
     }
-    DrawShapes(commandList);
+    DrawShapes(commandList, shapes, shapeCount);
 }
 
 auto Renderer::AllocateDescriptorHeap(
@@ -178,8 +178,11 @@ auto Renderer::UseLight(ID3D12GraphicsCommandList * commandList) -> void {
     commandList->SetGraphicsRootDescriptorTable(RootSignatureParameterIndex::Light, lightDescriptorInfo._gpuHandle);
 }
 
-auto Renderer::DrawShapes(ID3D12GraphicsCommandList * commandList) -> void {
-    commandList->ExecuteBundle(_shapeBundle.Get());
+// shapes are culled every frame, so they are recorded directly instead of into a bundle
+auto Renderer::DrawShapes(ID3D12GraphicsCommandList * commandList, core::Shape const*const* shapes, unsigned int shapeCount) -> void {
+    for (auto i = 0u; i < shapeCount; ++i) {
+        DrawShapeWithPso(commandList, shapes[i], _defaultPso.Get());
+    }
 }
 
 auto Renderer::DrawShapeWithPso(ID3D12GraphicsCommandList * commandList, core::Shape const* shape, ID3D12PipelineState * pso) -> void {
@@ -516,16 +519,4 @@ auto Renderer::CreateTranslucentBundle(core::Shape const * const * shapes, unsig
     _translucentBundle->Close();
 }
 
-auto Renderer::CreateShapeBundle(core::Shape const * const * shapes, unsigned int shapeCount) -> void {
-    auto heaps = array<ID3D12DescriptorHeap *, 1>{
-        _resourceManager->GetCbvSrvDescriptorHeap().GetHeap()
-    };
-    _shapeBundle = _resourceManager->CreateBundle(_defaultPso.Get(), _resourceManager->GetRootSignature(), heaps.data(), heaps.size());
-
-    for (auto i = 0u; i < shapeCount; ++i) {
-        DrawShapeWithPso(_shapeBundle.Get(), shapes[i], _defaultPso.Get());
-    }
-    _shapeBundle->Close();
-}
-
 }
\ No newline at end of file
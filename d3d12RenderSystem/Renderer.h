@@ -48,9 +48,8 @@ public:
     auto CreateSkyBoxBundle(core::SkyBox const* skyBox) -> void;
     auto CreateTerrainBundle(core::Terrain const * terrain) -> void;
     auto CreateTranslucentBundle(core::Shape const*const* shapes, unsigned int shapeCount) -> void;
-    auto CreateShapeBundle(core::Shape const*const* shapes, unsigned int shapeCount) -> void;
 protected:
-    auto DrawShapes(ID3D12GraphicsCommandList * commandList) -> void;
+    auto DrawShapes(ID3D12GraphicsCommandList * commandList, core::Shape const*const* shapes, unsigned int shapeCount) -> void;
     auto DrawShapeWithPso(ID3D12GraphicsCommandList * commandList, core::Shape const* shape, ID3D12PipelineState * pso) -> void;
     auto CreateDefaultPso() -> void;
     auto CreateSkyBoxPso() -> void;
@@ -80,7 +79,6 @@ protected:
     ComPtr<ID3D12GraphicsCommandList> _terrainBundle;
     ComPtr<ID3D12GraphicsCommandList> _terrainWireframeBundle;
     ComPtr<ID3D12GraphicsCommandList> _translucentBundle;
-    ComPtr<ID3D12GraphicsCommandList> _shapeBundle;
 
     bool _wireframeMode = false;
 };
@@ -247,6 +247,7 @@ auto ResourceManager::LoadMovables(core::Movable ** movables, unsigned int count
     if (movables == nullptr || count == 0) {
         return;
     }
+    auto const& changes = _transformChangeTracker.CollectChanges(movables, count);
     auto transformData = vector<TransformData>{};
     if (buffer == nullptr) {
         // create resource
@@ -261,22 +262,32 @@ auto ResourceManager::LoadMovables(core::Movable ** movables, unsigned int count
             _transformDescriptorInfos.push_back(descriptorInfo);
             transformData.push_back(TransformData{
                 movable->GetTransform(),
-                movable->GetTransform(),
+                movable->GetNormalTransform(),
             });
         }
+        _uploadHeap.AllocateAndUploadDataBlock(_commandList.Get(), buffer, sizeof(TransformData) * count, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, transformData.data());
     } else {
+        // only movables whose transform changed since the last upload
+        if (changes.empty()) {
+            return;
+        }
         _commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, D3D12_RESOURCE_STATE_COPY_DEST));
-        // aggregate data
-        for (auto i = 0u; i < count; ++i) {
-            auto & movable = movables[i];
-            transformData.push_back(TransformData{
-                movable->GetTransform(),
-                movable->GetTransform(),
-            });
+        // aggregate data of changed ranges back to back
+        auto destOffsets = vector<uint32>{};
+        auto sizes = vector<uint32>{};
+        for (auto const& range : changes) {
+            for (auto i = range.first; i < range.first + range.count; ++i) {
+                auto & movable = movables[i];
+                transformData.push_back(TransformData{
+                    movable->GetTransform(),
+                    movable->GetNormalTransform(),
+                });
+            }
+            destOffsets.push_back(range.first * sizeof(TransformData));
+            sizes.push_back(range.count * sizeof(TransformData));
         }
+        _uploadHeap.AllocateAndUploadDataRegions(_commandList.Get(), buffer, destOffsets.data(), sizes.data(), changes.size(), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, transformData.data());
     }
-
-    _uploadHeap.AllocateAndUploadDataBlock(_commandList.Get(), buffer, sizeof(TransformData) * count, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, transformData.data());
     _commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(buffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
 }
 
@@ -616,13 +627,13 @@ auto ResourceManager::UploadVertexData(unsigned int size, unsigned int stride, v
     return D3D12_VERTEX_BUFFER_VIEW{ resource->GetGPUVirtualAddress(), size, stride };
 }
 
-auto ResourceManager::UploadIndexData(unsigned int size, void const* data) -> D3D12_INDEX_BUFFER_VIEW {
+auto ResourceManager::UploadIndexData(unsigned int size, void const* data, DXGI_FORMAT format) -> D3D12_INDEX_BUFFER_VIEW {
     auto indexBuffer = CreateCommittedResource(&CD3DX12_RESOURCE_DESC::Buffer(size), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_HEAP_TYPE_DEFAULT);
     if (data != nullptr) {
         _uploadHeap.AllocateAndUploadDataBlock(_commandList.Get(), indexBuffer, size, sizeof(float), data);
         _commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(indexBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER));
     }
-    return D3D12_INDEX_BUFFER_VIEW{ indexBuffer->GetGPUVirtualAddress(), size, DXGI_FORMAT_R32_UINT };
+    return D3D12_INDEX_BUFFER_VIEW{ indexBuffer->GetGPUVirtualAddress(), size, format };
 }
 
 auto ResourceManager::LoadSkyBox(core::SkyBox * skyBox) -> void {
@@ -638,7 +649,7 @@ auto ResourceManager::LoadSkyBox(core::SkyBox * skyBox) -> void {
         core::Vector3f{ -1, -1, 1 },
         core::Vector3f{ 1, -1, 1 },
         core::Vector3f{ 1, 1, 1 } };
-    auto indexData = vector<unsigned int>{
+    auto indexData = vector<uint16>{
         0, 1, 2, 0, 2, 3,
         0, 4, 5, 0, 5, 1,
         0, 3, 7, 0, 7, 4,
@@ -650,9 +661,9 @@ auto ResourceManager::LoadSkyBox(core::SkyBox * skyBox) -> void {
     auto vertexBuffer = CreateCommittedResource(&CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_HEAP_TYPE_DEFAULT);
     auto const vbv = D3D12_VERTEX_BUFFER_VIEW{ vertexBuffer->GetGPUVirtualAddress(), vertexBufferSize, sizeof(core::Vector3f) };
 
-    auto const indexBufferSize = indexData.size() * sizeof(unsigned int);
+    auto const indexBufferSize = indexData.size() * sizeof(uint16);
     auto indexBuffer = CreateCommittedResource(&CD3DX12_RESOURCE_DESC::Buffer(indexBufferSize), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_HEAP_TYPE_DEFAULT);
-    auto const ibv = D3D12_INDEX_BUFFER_VIEW{ indexBuffer->GetGPUVirtualAddress(), indexBufferSize, DXGI_FORMAT_R32_UINT };
+    auto const ibv = D3D12_INDEX_BUFFER_VIEW{ indexBuffer->GetGPUVirtualAddress(), indexBufferSize, DXGI_FORMAT_R16_UINT };
 
     _skyBoxMeshInfo = MeshDataInfo{ vbv, ibv, indexData.size(), 0u, 0u, };
 
@@ -672,8 +683,8 @@ auto ResourceManager::LoadTerrain(core::Terrain * terrain) -> void {
     auto const tileSize = terrain->GetTileSize();
     auto vertexData = std::array<core::Vector2f, 4>{ core::Vector2f{ 0, 0 }, core::Vector2f{ tileSize, 0 }, core::Vector2f{ tileSize, tileSize }, core::Vector2f{ 0, tileSize } };
     auto vertexBufferView = UploadVertexData(vertexData.size() * sizeof(core::Vector2f), sizeof(core::Vector2f), vertexData.data());
-    auto indexData = std::array<unsigned int, 6>{0, 1, 2, 0, 2, 3};
-    auto indexBufferView = UploadIndexData(indexData.size() * sizeof(unsigned int), indexData.data());
+    auto indexData = std::array<uint16, 6>{0, 1, 2, 0, 2, 3};
+    auto indexBufferView = UploadIndexData(indexData.size() * sizeof(uint16), indexData.data(), DXGI_FORMAT_R16_UINT);
 
     auto sightDistance = terrain->GetSightDistance();
     auto tileCountUpperBound = static_cast<int>(ceil(sightDistance / tileSize) * 2);
@@ -27,6 +27,8 @@
 #include "core/Material.h"
 #include "core/Skybox.h"
 #include "core/Terrain.h"
+#include "core/TransformChangeTracker.h"
+#include "core/IndexBuffer.h"
 #include "SwapChainRenderTargets.h"
 #include "FrameResource.h"
 #include "FencedCommandQueue.h"
@@ -246,7 +248,7 @@ public:
     auto CreateTexture2d(DXGI_FORMAT format, uint64 width, uint32 height, void const* data, uint32 size, uint8 stride)->DescriptorInfo;
     auto UploadConstantBufferData(unsigned int size, void const* data, ID3D12Resource * dest = nullptr) -> DescriptorInfo;
     auto UploadVertexData(unsigned int size, unsigned int stride, void const* data, ID3D12Resource ** dest = nullptr) -> D3D12_VERTEX_BUFFER_VIEW;
-    auto UploadIndexData(unsigned int size, void const* data) -> D3D12_INDEX_BUFFER_VIEW;
+    auto UploadIndexData(unsigned int size, void const* data, DXGI_FORMAT format) -> D3D12_INDEX_BUFFER_VIEW;
     auto UpdateTerrain(core::Terrain * terrain, core::Camera * camera) -> void;
     auto CreateBundle(ID3D12PipelineState * pso, ID3D12RootSignature * rootSignature, ID3D12DescriptorHeap *const* descriptorHeaps, unsigned int descriptorHeapCount) -> ComPtr<ID3D12GraphicsCommandList>;
     auto GetMeshDataInfo(unsigned int index) -> MeshDataInfo const& {
@@ -339,6 +341,7 @@ private:
     std::vector<MeshDataInfo> _meshDataInfos;
     std::vector<DescriptorInfo> _cameraDescriptorInfos;
     std::vector<DescriptorInfo> _transformDescriptorInfos;
+    core::TransformChangeTracker _transformChangeTracker;
     std::vector<DescriptorInfo> _textureDescriptorInfos;
     DescriptorInfo _lightDescriptorInfo;
     std::vector<DescriptorInfo> _ambientLightDescriptorInfos;
@@ -371,31 +374,34 @@ auto ResourceManager::LoadMeshes(core::Mesh<T> ** meshes, unsigned int count) ->
         return;
     }
     auto vertexBufferSize = 0u;
-    auto indexBufferSize = 0u;
     for (auto i = 0u; i < count; ++i) {
         vertexBufferSize += meshes[i]->GetVertex().size() * sizeof(T);
-        indexBufferSize += meshes[i]->GetIndex().size() * sizeof(unsigned int);
     }
     auto vertexBuffer = CreateCommittedResource(&CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_HEAP_TYPE_DEFAULT);
     auto const vbv = D3D12_VERTEX_BUFFER_VIEW{ vertexBuffer->GetGPUVirtualAddress(), vertexBufferSize, sizeof(T) };
 
+    // 16 bit indexes of small meshes followed by 32 bit ones, with one view for each part
+    auto const indexLayout = core::LayoutIndexBuffer(meshes, meshes + count);
+    auto const indexBufferSize = indexLayout.GetSize();
     auto indexBuffer = CreateCommittedResource(&CD3DX12_RESOURCE_DESC::Buffer(indexBufferSize), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_HEAP_TYPE_DEFAULT);
-    auto const ibv = D3D12_INDEX_BUFFER_VIEW{ indexBuffer->GetGPUVirtualAddress(), indexBufferSize, DXGI_FORMAT_R32_UINT };
+    auto const ibv16 = D3D12_INDEX_BUFFER_VIEW{ indexBuffer->GetGPUVirtualAddress(), indexLayout.uint16Size, DXGI_FORMAT_R16_UINT };
+    auto const ibv32 = D3D12_INDEX_BUFFER_VIEW{ indexBuffer->GetGPUVirtualAddress() + indexLayout.uint16Size, indexLayout.uint32Size, DXGI_FORMAT_R32_UINT };
 
     auto vertexData = vector<T>();
-    auto indexData = vector<unsigned int>();
+    auto indexData = vector<uint8>(indexBufferSize);
+    core::WriteIndexBuffer(meshes, meshes + count, indexLayout, indexData.data());
     for (auto i = 0u; i < count; ++i) {
         auto mesh = meshes[i];
         mesh->SetRenderDataId(_meshDataInfos.size());
+        auto const& indexEntry = indexLayout.entries[i];
         _meshDataInfos.push_back(MeshDataInfo{
             vbv,
-            ibv,
+            indexEntry.format == core::IndexFormat::Uint16 ? ibv16 : ibv32,
             mesh->GetIndex().size(),
-            indexData.size(),
+            indexEntry.offset,
             static_cast<int>(vertexData.size()),
         });
         vertexData.insert(vertexData.end(), mesh->GetVertex().cbegin(), mesh->GetVertex().cend());
-        indexData.insert(indexData.end(), mesh->GetIndex().cbegin(), mesh->GetIndex().cend());
     }
     _uploadHeap.AllocateAndUploadDataBlock(_commandList.Get(), vertexBuffer, vertexBufferSize, sizeof(float), vertexData.data());
     _commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(vertexBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
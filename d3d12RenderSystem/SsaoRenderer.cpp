@@ -55,7 +55,7 @@ auto SsaoRenderer::Draw(
 
     UseViewpoint(commandList, camera);
 
-    DrawShapes(commandList);
+    DrawShapes(commandList, shapes, shapeCount);
     if (terrain != nullptr) {
         DrawTerrain(commandList, terrain);
     }
@@ -486,10 +486,10 @@ auto SsaoRenderer::LoadScreenQuad() -> void {
             core::Vector2f{ 1, -1 }, 
             core::Vector2f{ 1, 1 },
             core::Vector2f{ -1, 1 } };
-    auto indexData = vector<unsigned int>{ 0, 1, 2, 0, 2, 3 };
+    auto indexData = vector<uint16>{ 0, 1, 2, 0, 2, 3 };
 
     _screenQuadVbv = _resourceManager->UploadVertexData(vertexData.size() * sizeof(core::Vector2f), sizeof(core::Vector2f), vertexData.data());
-    _screenQuadIbv = _resourceManager->UploadIndexData(indexData.size() * sizeof(unsigned int), indexData.data());
+    _screenQuadIbv = _resourceManager->UploadIndexData(indexData.size() * sizeof(uint16), indexData.data(), DXGI_FORMAT_R16_UINT);
 }
 
 auto SsaoRenderer::LoadPointLightVolume() -> void {
@@ -33,6 +33,20 @@ auto UploadHeap::AllocateAndUploadDataBlock(ID3D12GraphicsCommandList * commandL
     UploadMemoryBlock(commandList, memoryBlock, dest);
 }
 
+auto UploadHeap::AllocateAndUploadDataRegions(ID3D12GraphicsCommandList * commandList, ID3D12Resource * dest, uint32 const* destOffsets, uint32 const* sizes, uint32 count, uint32 alignment, void const* data) -> void {
+    auto totalSize = 0u;
+    for (auto i = 0u; i < count; ++i) {
+        totalSize += sizes[i];
+    }
+    auto const& memoryBlock = AllocateMemoryBlock(totalSize, alignment);
+    memcpy(_heapBegin + memoryBlock._offset, data, totalSize);
+    auto srcOffset = memoryBlock._offset;
+    for (auto i = 0u; i < count; ++i) {
+        commandList->CopyBufferRegion(dest, destOffsets[i], _uploadHeap.Get(), srcOffset, sizes[i]);
+        srcOffset += sizes[i];
+    }
+}
+
 auto UploadHeap::AllocateDataBlocks(DataBlock * dataBlocks, uint32 count) -> MemoryBlock const& {
     // 1. compute alignments' lcd
     // alignments' lowest common denominator should be the greatest one.
@@ -0,0 +1,48 @@
+// per object data packed by core::PackTransforms and core::PackMaterials, fetched by instance or draw id
+
+struct PackedTransform {
+    row_major float3x4 worldTransform;
+};
+
+struct PackedMaterial {
+    float3 diffuse;
+    uint flags;
+    float3 emissive;
+    float shininess;
+    float3 specular;
+    float transparency;
+};
+
+static const uint HasDiffuseMap = 0x1;
+static const uint HasEmissiveMap = 0x2;
+static const uint HasSpecularMap = 0x4;
+static const uint HasNormalMap = 0x8;
+
+StructuredBuffer<PackedTransform> transforms : register(t0, space1);
+StructuredBuffer<PackedMaterial> materials : register(t1, space1);
+
+// set per draw, instances of a draw use consecutive transforms
+cbuffer DrawData : register(b0, space1) {
+    uint transformBase;
+    uint materialId;
+};
+
+float4 TransformPosition(uint id, float3 position) {
+    return float4(mul(transforms[id].worldTransform, float4(position, 1)), 1);
+}
+
+// rows of the inverse transpose of the upper 3x3 are cross products of its rows divided by the determinant,
+// as in core::InverseTranspose3x3. normals are normalized later, so only the sign of the determinant is applied,
+// which keeps normals of mirroring transforms from flipping.
+float4 TransformNormal(uint id, float3 normal) {
+    float3x4 m = transforms[id].worldTransform;
+    float3 c0 = cross(m[1].xyz, m[2].xyz);
+    float3 c1 = cross(m[2].xyz, m[0].xyz);
+    float3 c2 = cross(m[0].xyz, m[1].xyz);
+    float determinantSign = sign(dot(m[0].xyz, c0));
+    return float4(determinantSign * float3(dot(c0, normal), dot(c1, normal), dot(c2, normal)), 0);
+}
+
+PackedMaterial GetMaterial() {
+    return materials[materialId];
+}
@@ -0,0 +1,30 @@
+#include "packedData.hlsli"
+
+struct PSInput {
+    float4 position : SV_POSITION;
+    float4 worldPosition : PS_WORLD_POSITION;
+    float4 normal : PS_NORMAL;
+    float2 texCoord : PS_TEXCOORD;
+};
+
+cbuffer Camera : register(b0) {
+    float4x4 viewTransform;
+    float4x4 projectTransform;
+    float4x4 viewTransformInverse;
+    float4 viewPosition;
+    float3x4 _pad;
+};
+
+PSInput main(float3 position : POSITION, float3 normal : NORMAL, float2 texCoord : TEXCOORD, uint instanceId : SV_InstanceID) {
+    PSInput result;
+
+    uint id = transformBase + instanceId;
+    float4 newPosition = TransformPosition(id, position);
+    result.worldPosition = newPosition;
+    newPosition = mul(viewTransform, newPosition);
+    newPosition = mul(projectTransform, newPosition);
+    result.position = newPosition;
+    result.normal = TransformNormal(id, normal);
+    result.texCoord = float2(texCoord.x, 1.0 - texCoord.y); // reverse y coordinate because dx's texture coordinate origin is at top left
+    return result;
+}
@@ -34,7 +34,7 @@ private:
 
 private:
     Float3 _translation;
-    Float3 _scale;
+    Float3 _scale = Float3{ 1.0f, 1.0f, 1.0f };
     Float4 _rotation;
     std::vector<Transform *> _transform;
     Group * _group = nullptr;
@@ -51,13 +51,32 @@ auto X3dReader::ReadIndexedFaceSet(IndexedFaceSet const& indexedFaceSet, core::S
     auto& normal = indexedFaceSet.GetNormal()->GetVector();
     auto& textureCoordinate = indexedFaceSet.GetTextureCoordinate()->GetPoint();
 
-	auto vertexData = vector<Vertex>{};
-	for (auto i = 0u; i < coordIndex.size(); ++i) {
-		vertexData.push_back({ ToVector3(coordinate.at(coordIndex[i].a)), ToVector3(normal.at(coordIndex[i].a)), ToVector2(textureCoordinate.at(texCoordIndex[i].a))});
-		vertexData.push_back({ ToVector3(coordinate.at(coordIndex[i].b)), ToVector3(normal.at(coordIndex[i].b)), ToVector2(textureCoordinate.at(texCoordIndex[i].b))});
-		vertexData.push_back({ ToVector3(coordinate.at(coordIndex[i].c)), ToVector3(normal.at(coordIndex[i].c)), ToVector2(textureCoordinate.at(texCoordIndex[i].c))});
+    auto coords = vector<core::Vector3f>{};
+    coords.reserve(coordinate.size());
+    for (auto const& point : coordinate) {
+        coords.push_back(ToVector3(point));
+    }
+    auto normals = vector<core::Vector3f>{};
+    normals.reserve(normal.size());
+    for (auto const& n : normal) {
+        normals.push_back(ToVector3(n));
+    }
+    auto texCoords = vector<core::Vector2f>{};
+    texCoords.reserve(textureCoordinate.size());
+    for (auto const& point : textureCoordinate) {
+        texCoords.push_back(ToVector2(point));
     }
-	return staticModelGroup.CreateMesh(move(vertexData));;
+
+    // normals are per vertex, indexed by coordIndex
+    auto corner = [](ULong coord, ULong texCoord) {
+        return core::VertexWelder::Corner{ static_cast<unsigned int>(coord), static_cast<unsigned int>(coord), static_cast<unsigned int>(texCoord) };
+    };
+    auto welder = core::VertexWelder{ &coords, &normals, &texCoords, _weldEpsilon };
+    for (auto i = 0u; i < coordIndex.size(); ++i) {
+        auto const& texCoord = texCoordIndex.at(i);
+        welder.AddTriangle(corner(coordIndex[i].a, texCoord.a), corner(coordIndex[i].b, texCoord.b), corner(coordIndex[i].c, texCoord.c));
+    }
+    return staticModelGroup.CreateMesh(move(welder.GetVertices()), move(welder.GetIndexes()));
 }
 
 auto X3dReader::ReadIndexedTriangleSet(IndexedTriangleSet const& indexedTriangleSet, core::StaticModelGroup & staticModelGroup) ->  Mesh<Vertex> * {
@@ -106,7 +125,10 @@ auto X3dReader::ReadTransform(Transform const& transform, core::StaticModelGroup
 		ret = staticModelGroup.CreateMovable();
 	}
 
-	// Does not support scale yet.
+	// scale, then rotate, then translate as X3D does, ignoring center and scaleOrientation
+	auto scale = transform.GetScale();
+	ret->Scale(scale.x, scale.y, scale.z);
+
 	auto rotation = transform.GetRotation();
 	ret->Rotate(rotation.x, rotation.y, rotation.z, rotation.a);
 
@@ -17,6 +17,7 @@
 #include "core/PointLight.h"
 #include "core/DirectionalLight.h"
 #include "core/SpotLight.h"
+#include "core/VertexWelder.h"
 
 using std::make_unique;
 
@@ -24,8 +25,10 @@ namespace x3dParser {
 
 class X3dReader {
 public:
-	X3dReader(std::string pathname)
-		: _pathName(pathname) {
+	// vertices closer than weldEpsilon are merged if their other attributes are equal, 0 merges shared indexes only
+	X3dReader(std::string pathname, core::Float32 weldEpsilon = 0.0f)
+		: _pathName(pathname)
+		, _weldEpsilon(weldEpsilon) {
 	}
 public:
 	// when exporting x3d from blender:
@@ -48,6 +51,7 @@ private:
 private:
     core::Scene * _scene;
 	boost::filesystem::path _pathName;
+	core::Float32 _weldEpsilon;
 	X3dParser _x3dParser;
     std::map<std::string, core::Material *> _materials;
     std::map<std::string, std::vector<core::Texture *>> _imageTextures;